@@ -19,7 +19,53 @@ copy_to   = "/sphenix/user/danderson/sphenix/ForkedCoreSoftware/offline/packages
 to_copy = [
   "TriggerClusterMaker.cc",
   "TriggerClusterMaker.h",
-  "TriggerClusterMakerLinkDef.h"
+  "TriggerClusterMakerLinkDef.h",
+  "TriggerClusterBenchGenerator.h",
+  "TriggerClusterBenchmark.cc",
+  "TriggerClusterBuffer.cc",
+  "TriggerClusterBuffer.h",
+  "TriggerClusterContainer.cc",
+  "TriggerClusterContainer.h",
+  "TriggerClusterContainerLinkDef.h",
+  "TriggerClusterEngine.cc",
+  "TriggerClusterEngine.h",
+  "TriggerClusterEngineTest.cc",
+  "TriggerClusterInstrument.cc",
+  "TriggerClusterInstrument.h",
+  "TriggerClusterKernels.cc",
+  "TriggerClusterKernels.h",
+  "TriggerClusterKernelTest.cc",
+  "TriggerClusterKeys.h",
+  "TriggerClusterLL1Decoder.cc",
+  "TriggerClusterLL1Decoder.h",
+  "TriggerClusterLog.h",
+  "TriggerClusterMakerDefs.h",
+  "TriggerClusterPatchFinder.cc",
+  "TriggerClusterPatchFinder.h",
+  "TriggerClusterPyramid.cc",
+  "TriggerClusterPyramid.h",
+  "TriggerClusterPyramidContainer.cc",
+  "TriggerClusterPyramidContainer.h",
+  "TriggerClusterPyramidContainerLinkDef.h",
+  "TriggerClusterReplay.cc",
+  "TriggerClusterReplayDumper.cc",
+  "TriggerClusterReplayDumper.h",
+  "TriggerClusterReplayDumperLinkDef.h",
+  "TriggerClusterReplayFormat.h",
+  "TriggerClusterReplayReader.cc",
+  "TriggerClusterReplayReader.h",
+  "TriggerClusterReplayWriter.cc",
+  "TriggerClusterReplayWriter.h",
+  "TriggerClusterSPSCQueue.h",
+  "TriggerClusterSumCache.h",
+  "TriggerClusterSumTable.cc",
+  "TriggerClusterSumTable.h",
+  "TriggerClusterTowerGrid.h",
+  "TriggerClusterTupleMaker.cc",
+  "TriggerClusterTupleMaker.h",
+  "TriggerClusterTupleMakerLinkDef.h",
+  "TriggerClusterWorkerPool.cc",
+  "TriggerClusterWorkerPool.h"
 ]
 
 # do copying
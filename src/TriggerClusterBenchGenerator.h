@@ -0,0 +1,306 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterBenchGenerator.h'
+ *  \authors Derek Anderson
+ *  \date    07.12.2024
+ *
+ *  Synthetic calorimeter events for benchmarking
+ *  and checking the trigger cluster engine
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERBENCHGENERATOR_H
+#define TRIGGERCLUSTERBENCHGENERATOR_H
+
+// c++ utilities
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+// module utilities
+#include "TriggerClusterLL1Decoder.h"
+#include "TriggerClusterMakerDefs.h"
+#include "TriggerClusterSumTable.h"
+
+
+
+// synthetic events ===========================================================
+
+// ----------------------------------------------------------------------------
+//! Occupancy of a synthetic event sample
+// ----------------------------------------------------------------------------
+struct TriggerClusterBenchScenario {
+  std::string name      = "";
+  double      occupancy = 0.;   // probability a tower has a hit
+  double      hitScale  = 0.;   // mean energy of a hit (GeV)
+  double      noise     = 0.;   // mean pedestal noise (GeV)
+  uint32_t    nJets     = 0;    // no. of jets per event
+  double      jetEnergy = 0.;   // mean energy of a jet (GeV)
+};
+
+
+
+// ----------------------------------------------------------------------------
+//! An LL1 word located on the retower grid
+// ----------------------------------------------------------------------------
+struct TriggerClusterBenchWord {
+  uint32_t                  cal  = 0;
+  uint32_t                  iEta = 0;
+  uint32_t                  iPhi = 0;
+  std::array<uint32_t, 3>   samples;
+};
+
+
+
+// ----------------------------------------------------------------------------
+//! A primitive given as its layer and sum IDs
+// ----------------------------------------------------------------------------
+struct TriggerClusterBenchPrimitive {
+  uint32_t              layer = 0;
+  std::vector<uint32_t> sums;
+};
+
+
+
+// ----------------------------------------------------------------------------
+//! One synthetic event
+// ----------------------------------------------------------------------------
+struct TriggerClusterBenchEvent {
+  std::array<std::vector<float>, 3>         energies;
+  std::vector<TriggerClusterBenchWord>      words;
+  std::vector<TriggerClusterBenchPrimitive> primitives;
+};
+
+
+
+// ----------------------------------------------------------------------------
+//! Generates synthetic calorimeter events
+// ----------------------------------------------------------------------------
+/*! Towers get exponential noise everywhere, a hit with
+ *  probability set by the occupancy, and any jets deposit a
+ *  Gaussian blob in every layer (most of it in the EMCal).
+ *
+ *  Primitives are emitted like the emulator does: every
+ *  primitive with at least one sum above threshold, with all
+ *  of its sums. Every LL1 jet patch (4 x 4 retowers over all
+ *  layers) is emitted as a word with three samples.
+ */
+class TriggerClusterBenchGenerator {
+
+  public:
+
+    // thresholds
+    static constexpr double SumThreshold = 0.25;  // GeV
+    static constexpr double AdcPerGeV    = 10.;
+
+    // ctor
+    TriggerClusterBenchGenerator(const TriggerClusterSumTable& table, const uint32_t seed) : m_table(table), m_rng(seed) {};
+
+    // ------------------------------------------------------------------------
+    //! Get the standard scenarios: pp min. bias, pp jets, and central AuAu
+    // ------------------------------------------------------------------------
+    static std::vector<TriggerClusterBenchScenario> GetScenarios() {
+
+      std::vector<TriggerClusterBenchScenario> scenarios(3);
+      scenarios[0].name      = "ppMinBias";
+      scenarios[0].occupancy = 0.01;
+      scenarios[0].hitScale  = 0.3;
+      scenarios[0].noise     = 0.005;
+      scenarios[1].name      = "ppJet";
+      scenarios[1].occupancy = 0.03;
+      scenarios[1].hitScale  = 0.4;
+      scenarios[1].noise     = 0.005;
+      scenarios[1].nJets     = 2;
+      scenarios[1].jetEnergy = 20.;
+      scenarios[2].name      = "AuAuCentral";
+      scenarios[2].occupancy = 0.6;
+      scenarios[2].hitScale  = 0.25;
+      scenarios[2].noise     = 0.01;
+      scenarios[2].nJets     = 4;
+      scenarios[2].jetEnergy = 30.;
+      return scenarios;
+
+    }  // end 'GetScenarios()'
+
+    // ------------------------------------------------------------------------
+    //! Generate an event
+    // ------------------------------------------------------------------------
+    void Generate(const TriggerClusterBenchScenario& scenario, TriggerClusterBenchEvent& event) {
+
+      std::uniform_real_distribution<double> flat(0., 1.);
+      std::exponential_distribution<double>  noise(1. / std::max(scenario.noise, 1e-6));
+      std::exponential_distribution<double>  hit(1. / std::max(scenario.hitScale, 1e-6));
+
+      // fill towers
+      for (uint32_t iCal = 0; iCal < 3; ++iCal) {
+        const uint32_t nEta = TriggerClusterMakerDefs::NEtaTowers(iCal);
+        const uint32_t nPhi = TriggerClusterMakerDefs::NPhiTowers(iCal);
+        event.energies[iCal].assign(nEta * nPhi, 0.);
+        for (float& energy : event.energies[iCal]) {
+          energy = noise(m_rng);
+          if (flat(m_rng) < scenario.occupancy) energy += hit(m_rng);
+        }
+      }
+
+      // add jets
+      std::exponential_distribution<double> jet(1. / std::max(scenario.jetEnergy, 1e-6));
+      for (uint32_t iJet = 0; iJet < scenario.nJets; ++iJet) {
+        const double eta    = flat(m_rng);
+        const double phi    = flat(m_rng);
+        const double energy = jet(m_rng);
+        AddJet(event, eta, phi, energy);
+      }
+
+      // and derive trigger info
+      MakePrimitives(event);
+      MakeWords(event);
+      return;
+
+    }  // end 'Generate(TriggerClusterBenchScenario&, TriggerClusterBenchEvent&)'
+
+  private:
+
+    // ------------------------------------------------------------------------
+    //! Deposit a jet around (eta, phi) in units of the acceptance
+    // ------------------------------------------------------------------------
+    void AddJet(TriggerClusterBenchEvent& event, const double eta, const double phi, const double energy) {
+
+      const std::array<double, 3> fraction = {0.7, 0.1, 0.2};
+      for (uint32_t iCal = 0; iCal < 3; ++iCal) {
+        const int32_t nEta   = TriggerClusterMakerDefs::NEtaTowers(iCal);
+        const int32_t nPhi   = TriggerClusterMakerDefs::NPhiTowers(iCal);
+        const int32_t etaJet = static_cast<int32_t>(eta * nEta);
+        const int32_t phiJet = static_cast<int32_t>(phi * nPhi);
+        const int32_t radius = (iCal == TriggerClusterMakerDefs::Cal::EM) ? 8 : 2;
+        const double  sigma  = 0.5 * radius;
+
+        // spread energy with a gaussian profile
+        double norm = 0.;
+        for (int32_t dEta = -radius; dEta <= radius; ++dEta) {
+          for (int32_t dPhi = -radius; dPhi <= radius; ++dPhi) {
+            norm += std::exp(-0.5 * ((dEta * dEta) + (dPhi * dPhi)) / (sigma * sigma));
+          }
+        }
+        for (int32_t dEta = -radius; dEta <= radius; ++dEta) {
+          const int32_t iEta = etaJet + dEta;
+          if ((iEta < 0) || (iEta >= nEta)) continue;
+          for (int32_t dPhi = -radius; dPhi <= radius; ++dPhi) {
+            const int32_t iPhi   = (phiJet + dPhi + nPhi) % nPhi;
+            const double  weight = std::exp(-0.5 * ((dEta * dEta) + (dPhi * dPhi)) / (sigma * sigma)) / norm;
+            event.energies[iCal][(iEta * nPhi) + iPhi] += fraction[iCal] * energy * weight;
+          }
+        }
+      }  // end layer loop
+      return;
+
+    }  // end 'AddJet(TriggerClusterBenchEvent&, double, double, double)'
+
+    // ------------------------------------------------------------------------
+    //! Emit primitives with at least one sum above threshold
+    // ------------------------------------------------------------------------
+    void MakePrimitives(TriggerClusterBenchEvent& event) {
+
+      typedef TriggerClusterMakerDefs::SumTraits<TriggerClusterMakerDefs::Cal::EM, TriggerClusterMakerDefs::Type::Prim> Sum;
+
+      event.primitives.clear();
+      for (uint32_t iCal = 0; iCal < 3; ++iCal) {
+        const uint32_t nPhi    = TriggerClusterMakerDefs::NPhiTowers(iCal);
+        const uint32_t nSumEta = TriggerClusterMakerDefs::NEtaTowers(iCal) / Sum::nTowInSum;
+        const uint32_t nSumPhi = nPhi / Sum::nTowInSum;
+        for (uint32_t iPrimEta = 0; iPrimEta < nSumEta / Sum::nSumInPrim; ++iPrimEta) {
+          for (uint32_t iPrimPhi = 0; iPrimPhi < nSumPhi / Sum::nSumInPrim; ++iPrimPhi) {
+
+            TriggerClusterBenchPrimitive primitive;
+            primitive.layer = iCal;
+
+            bool isAbove = false;
+            for (uint32_t iSumEta = 0; iSumEta < Sum::nSumInPrim; ++iSumEta) {
+              for (uint32_t iSumPhi = 0; iSumPhi < Sum::nSumInPrim; ++iSumPhi) {
+                const uint32_t sumEta = (iPrimEta * Sum::nSumInPrim) + iSumEta;
+                const uint32_t sumPhi = (iPrimPhi * Sum::nSumInPrim) + iSumPhi;
+
+                double energy = 0.;
+                for (uint32_t iTow = 0; iTow < Sum::nTowers; ++iTow) {
+                  const uint32_t eta = (sumEta * Sum::nTowInSum) + (iTow / Sum::nTowInSum);
+                  const uint32_t phi = (sumPhi * Sum::nTowInSum) + (iTow % Sum::nTowInSum);
+                  energy += event.energies[iCal][(eta * nPhi) + phi];
+                }
+                isAbove |= (energy > SumThreshold);
+                primitive.sums.push_back(
+                  m_table.GetSumID(iCal, TriggerClusterMakerDefs::Type::Prim, sumEta, sumPhi)
+                );
+              }
+            }  // end sum loops
+            if (isAbove) event.primitives.push_back(primitive);
+
+          }
+        }  // end primitive loops
+      }  // end layer loop
+
+      // the LL1-level primitive nodes are built from the same
+      // sums as the per-detector ones, so repeat each primitive
+      const std::size_t nPrims = event.primitives.size();
+      for (std::size_t iPrim = 0; iPrim < nPrims; ++iPrim) {
+        event.primitives.push_back(event.primitives[iPrim]);
+      }
+      return;
+
+    }  // end 'MakePrimitives(TriggerClusterBenchEvent&)'
+
+    // ------------------------------------------------------------------------
+    //! Emit a word for every LL1 jet patch
+    // ------------------------------------------------------------------------
+    void MakeWords(TriggerClusterBenchEvent& event) {
+
+      typedef TriggerClusterMakerDefs::CalTraits<TriggerClusterMakerDefs::Cal::EM> EMCal;
+
+      const uint32_t nEta = TriggerClusterLL1Decoder::NEta;
+      const uint32_t nPhi = TriggerClusterLL1Decoder::NPhi;
+      const uint32_t side = TriggerClusterMakerDefs::NTowInLL1();
+
+      // retower every layer onto the LL1 grid
+      std::vector<double> retowers(nEta * nPhi, 0.);
+      for (uint32_t iCal = 0; iCal < 3; ++iCal) {
+        const uint32_t nRetow  = (iCal == TriggerClusterMakerDefs::Cal::EM) ? EMCal::nRetow : 1;
+        const uint32_t nPhiCal = TriggerClusterMakerDefs::NPhiTowers(iCal);
+        for (uint32_t iTow = 0; iTow < event.energies[iCal].size(); ++iTow) {
+          const uint32_t iEta = (iTow / nPhiCal) / nRetow;
+          const uint32_t iPhi = (iTow % nPhiCal) / nRetow;
+          retowers[(iEta * nPhi) + iPhi] += event.energies[iCal][iTow];
+        }
+      }
+
+      // sum each patch
+      event.words.clear();
+      for (uint32_t iEta = 0; iEta < nEta; ++iEta) {
+        for (uint32_t iPhi = 0; iPhi < nPhi; ++iPhi) {
+          double energy = 0.;
+          for (uint32_t dEta = 0; dEta < side; ++dEta) {
+            for (uint32_t dPhi = 0; dPhi < side; ++dPhi) {
+              energy += retowers[(std::min(iEta + dEta, nEta - 1) * nPhi) + ((iPhi + dPhi) % nPhi)];
+            }
+          }
+
+          TriggerClusterBenchWord word;
+          word.cal     = TriggerClusterLL1Decoder::AllLayers;
+          word.iEta    = iEta;
+          word.iPhi    = iPhi;
+          word.samples = {0, static_cast<uint32_t>(energy * AdcPerGeV), static_cast<uint32_t>(0.5 * energy * AdcPerGeV)};
+          event.words.push_back(word);
+        }
+      }  // end patch loops
+      return;
+
+    }  // end 'MakeWords(TriggerClusterBenchEvent&)'
+
+    // members
+    const TriggerClusterSumTable& m_table;
+    std::mt19937                  m_rng;
+
+};
+
+#endif
+
+// end ------------------------------------------------------------------------
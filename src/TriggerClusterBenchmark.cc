@@ -0,0 +1,387 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterBenchmark.cc'
+ *  \authors Derek Anderson
+ *  \date    07.12.2024
+ *
+ *  Micro- and macro-benchmarks of the trigger
+ *  cluster engine on synthetic events
+ */
+// ----------------------------------------------------------------------------
+
+#define TRIGGERCLUSTERBENCHMARK_CC
+
+// c++ utilities
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+// module utilities
+#include "TriggerClusterBenchGenerator.h"
+#include "TriggerClusterBuffer.h"
+#include "TriggerClusterEngine.h"
+#include "TriggerClusterKernels.h"
+#include "TriggerClusterMakerDefs.h"
+#include "TriggerClusterSumTable.h"
+
+
+
+// allocation counting ========================================================
+
+// ----------------------------------------------------------------------------
+//! No. of heap allocations made by the process so far
+// ----------------------------------------------------------------------------
+/*! Every form of operator new is replaced below so that the
+ *  benchmarks can report allocations per event. The
+ *  replacements are kept out of line so that the compiler
+ *  doesn't see malloc/free paired with new/delete.
+ */
+#define TRGCLUST_NOINLINE __attribute__((noinline))
+
+namespace {
+  std::atomic<uint64_t> g_nAllocs {0};
+}
+
+TRGCLUST_NOINLINE void* operator new(const std::size_t size) {
+  ++g_nAllocs;
+  void* ptr = std::malloc(std::max<std::size_t>(size, 1));
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+TRGCLUST_NOINLINE void* operator new[](const std::size_t size) {
+  return ::operator new(size);
+}
+
+TRGCLUST_NOINLINE void* operator new(const std::size_t size, const std::align_val_t align) {
+  ++g_nAllocs;
+  const std::size_t alignment = static_cast<std::size_t>(align);
+  const std::size_t rounded   = ((std::max<std::size_t>(size, 1) + alignment - 1) / alignment) * alignment;
+  void* ptr = std::aligned_alloc(alignment, rounded);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+TRGCLUST_NOINLINE void* operator new[](const std::size_t size, const std::align_val_t align) {
+  return ::operator new(size, align);
+}
+
+TRGCLUST_NOINLINE void operator delete(void* ptr) noexcept                                 {std::free(ptr);}
+TRGCLUST_NOINLINE void operator delete[](void* ptr) noexcept                               {std::free(ptr);}
+TRGCLUST_NOINLINE void operator delete(void* ptr, const std::size_t) noexcept              {std::free(ptr);}
+TRGCLUST_NOINLINE void operator delete[](void* ptr, const std::size_t) noexcept            {std::free(ptr);}
+TRGCLUST_NOINLINE void operator delete(void* ptr, const std::align_val_t) noexcept         {std::free(ptr);}
+TRGCLUST_NOINLINE void operator delete[](void* ptr, const std::align_val_t) noexcept       {std::free(ptr);}
+TRGCLUST_NOINLINE void operator delete(void* ptr, const std::size_t, const std::align_val_t) noexcept   {std::free(ptr);}
+TRGCLUST_NOINLINE void operator delete[](void* ptr, const std::size_t, const std::align_val_t) noexcept {std::free(ptr);}
+
+
+
+// reporting ==================================================================
+
+// ----------------------------------------------------------------------------
+//! Collects results and writes them out
+// ----------------------------------------------------------------------------
+/*! Results are printed as a table, and optionally appended
+ *  to a CSV file (label, benchmark, metric, value) so that
+ *  runs on different commits can be compared directly.
+ */
+class TriggerClusterBenchReport {
+
+  public:
+
+    TriggerClusterBenchReport(const std::string& label, const std::string& csv) : m_label(label), m_csv(csv) {};
+
+    // ------------------------------------------------------------------------
+    //! Record a result
+    // ------------------------------------------------------------------------
+    void Add(const std::string& bench, const std::string& metric, const double value) {
+
+      std::cout << "  " << std::left << std::setw(40) << bench
+                << std::setw(16) << metric
+                << std::right << std::setw(14) << std::fixed << std::setprecision(2) << value
+                << std::endl;
+      if (!m_csv.empty()) {
+        std::ofstream out(m_csv, std::ios::app);
+        out << m_label << "," << bench << "," << metric << "," << value << "\n";
+      }
+      return;
+
+    }  // end 'Add(std::string&, std::string&, double)'
+
+  private:
+
+    std::string m_label;
+    std::string m_csv;
+
+};
+
+
+
+// benchmarks =================================================================
+
+namespace {
+
+  // clock
+  typedef std::chrono::steady_clock Clock;
+
+  // --------------------------------------------------------------------------
+  //! Elapsed ns since start
+  // --------------------------------------------------------------------------
+  double ElapsedNs(const Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  }
+
+  // keeps results of micro-benchmarks alive
+  volatile uint64_t g_sink = 0;
+
+  // --------------------------------------------------------------------------
+  //! Feed one event through the engine
+  // --------------------------------------------------------------------------
+  double RunEvent(
+    TriggerClusterEngine& engine,
+    const TriggerClusterBenchEvent& event,
+    TriggerClusterBuffer& clusters,
+    const uint32_t threshold
+  ) {
+
+    engine.BeginEvent(&clusters);
+    for (uint32_t iCal = 0; iCal < 3; ++iCal) {
+      engine.SetTowers(iCal, event.energies[iCal].data(), event.energies[iCal].size());
+    }
+
+    engine.ResetLL1s();
+    for (const TriggerClusterBenchWord& word : event.words) {
+      engine.AddLL1Word(word.cal, word.iEta, word.iPhi, word.samples.data(), word.samples.size(), threshold);
+    }
+    engine.ProcessLL1s();
+
+    for (const TriggerClusterBenchPrimitive& primitive : event.primitives) {
+      engine.AddPrimitive(primitive.layer, primitive.sums.data(), primitive.sums.size());
+    }
+
+    // time primitive processing on its own
+    const Clock::time_point start = Clock::now();
+    if (engine.GetConfig().mode == TriggerClusterMakerDefs::Mode::Patches) {
+      engine.ProcessPatches();
+    } else {
+      engine.ProcessPrimitives();
+    }
+    const double ns = ElapsedNs(start);
+
+    engine.EndEvent();
+    return ns;
+
+  }  // end 'RunEvent(...)'
+
+}  // end anonymous namespace
+
+
+
+// ----------------------------------------------------------------------------
+//! Run every benchmark
+// ----------------------------------------------------------------------------
+/*! Usage:
+ *    triggerclusterbench [nEvents] [nThreads] [csv file] [label]
+ *
+ *  Events are generated up front from fixed seeds, so every
+ *  run processes the same events.
+ */
+int main(int argc, char* argv[]) {
+
+  // parse arguments
+  const uint32_t    nEvents  = (argc > 1) ? std::atoi(argv[1]) : 200;
+  const uint32_t    nThreads = (argc > 2) ? std::atoi(argv[2]) : 1;
+  const std::string csv      = (argc > 3) ? argv[3] : "";
+  const std::string label    = (argc > 4) ? argv[4] : "local";
+  const uint32_t    nWarmup  = std::max(nEvents / 10, 1U);
+
+  // scenarios
+  const std::vector<TriggerClusterBenchScenario> scenarios = TriggerClusterBenchGenerator::GetScenarios();
+
+  std::cout << "TriggerClusterBenchmark: " << nEvents << " events per scenario, "
+            << nThreads << " thread(s), kernel level " << TriggerClusterKernels::GetLevel()
+            << std::endl;
+  TriggerClusterBenchReport report(label, csv);
+
+  // micro-benchmarks ---------------------------------------------------------
+
+  TriggerClusterSumTable table;
+  table.Build();
+  {
+    const uint32_t nCalls = 1 << 22;
+
+    // sum ID lookup
+    Clock::time_point start = Clock::now();
+    for (uint32_t iCall = 0; iCall < nCalls; ++iCall) {
+      g_sink = g_sink + table.GetSumID(iCall % 3, TriggerClusterMakerDefs::Type::Prim, (iCall >> 2) % 48, (iCall >> 5) % 128);
+    }
+    report.Add("SumTable::GetSumID", "ns/call", ElapsedNs(start) / nCalls);
+
+    // span lookup
+    start = Clock::now();
+    for (uint32_t iCall = 0; iCall < nCalls; ++iCall) {
+      const TriggerClusterSumTable::Span* span = table.GetSpan(iCall % table.GetNSpans());
+      g_sink = g_sink + span -> start;
+    }
+    report.Add("SumTable::GetSpan", "ns/call", ElapsedNs(start) / nCalls);
+
+    // defs helpers
+    start = Clock::now();
+    for (uint32_t iCall = 0; iCall < nCalls; ++iCall) {
+      const uint32_t cal = iCall % 3;
+      g_sink = g_sink
+             + TriggerClusterMakerDefs::GetTowersInSum(cal, iCall & 1)
+             + TriggerClusterMakerDefs::NEtaTowers(cal)
+             + TriggerClusterMakerDefs::NPhiTowers(cal)
+             + TriggerClusterMakerDefs::GetRangeOfIndices<TriggerClusterMakerDefs::Cal::EM, TriggerClusterMakerDefs::Type::Prim>(iCall & 0xFF).second;
+    }
+    report.Add("TriggerClusterMakerDefs helpers", "ns/call", ElapsedNs(start) / nCalls);
+
+    // gathered sum over a row of 64 primitive sums
+    std::vector<float> energies(TriggerClusterMakerDefs::NEtaTowers(0) * TriggerClusterMakerDefs::NPhiTowers(0), 1.);
+    start = Clock::now();
+    float total = 0.;
+    for (uint32_t iCall = 0; iCall < nCalls; ++iCall) {
+      const TriggerClusterSumTable::Span* span = table.GetSpan((iCall % 48) * 64);
+      total += TriggerClusterKernels::GatherSum(energies.data(), table.GetTowerIndices() + span -> start, 64 * span -> size);
+    }
+    g_sink = g_sink + static_cast<uint64_t>(total);
+    report.Add("Kernels::GatherSum (64 sums)", "ns/call", ElapsedNs(start) / nCalls);
+
+    // threshold mask over an emcal layer
+    const uint32_t        nMasks = 1 << 10;
+    std::vector<uint64_t> bits((energies.size() + 63) / 64);
+    start = Clock::now();
+    for (uint32_t iCall = 0; iCall < nMasks; ++iCall) {
+      TriggerClusterKernels::MaskAbove(energies.data(), energies.size(), 0.5 * (iCall & 3), bits.data());
+      g_sink = g_sink + bits[iCall % bits.size()];
+    }
+    report.Add("Kernels::MaskAbove (EMCal)", "us/call", 1e-3 * ElapsedNs(start) / nMasks);
+
+    // status mask and zeroing over an emcal layer, ~1% bad
+    std::vector<uint8_t> statuses(energies.size(), 0);
+    for (std::size_t iTow = 0; iTow < statuses.size(); iTow += 97) {
+      statuses[iTow] = 1 << TriggerClusterMakerDefs::Status::Hot;
+    }
+    start = Clock::now();
+    for (uint32_t iCall = 0; iCall < nMasks; ++iCall) {
+      std::fill(bits.begin(), bits.end(), 0);
+      TriggerClusterKernels::MaskStatus(statuses.data(), statuses.size(), TriggerClusterMakerDefs::BadStatusBits(), bits.data());
+      total += TriggerClusterKernels::ZeroMasked(energies.data(), energies.size(), bits.data());
+    }
+    g_sink = g_sink + static_cast<uint64_t>(total);
+    report.Add("Kernels::ZeroMasked (EMCal)", "us/call", 1e-3 * ElapsedNs(start) / nMasks);
+
+    // saturating adc sums of 1024 primitives with 16 sums each
+    const uint32_t        nAdcPrims = 1 << 10;
+    std::vector<uint16_t> adcs(16 * nAdcPrims);
+    std::vector<uint16_t> adcSums(nAdcPrims);
+    for (std::size_t iAdc = 0; iAdc < adcs.size(); ++iAdc) {
+      adcs[iAdc] = iAdc & 0xFF;
+    }
+    start = Clock::now();
+    for (uint32_t iCall = 0; iCall < nMasks; ++iCall) {
+      TriggerClusterKernels::SaturatingSum(adcs.data(), 16, nAdcPrims, nAdcPrims, 0xFF + (iCall & 0xFF), adcSums.data());
+      g_sink = g_sink + adcSums[iCall % nAdcPrims];
+    }
+    report.Add("Kernels::SaturatingSum (16 x 1024)", "us/call", 1e-3 * ElapsedNs(start) / nMasks);
+  }
+
+  // macro-benchmarks ---------------------------------------------------------
+
+  // engine setups to time
+  //   - sparse primitives drop anything without a sum
+  //     above 1 GeV
+  struct TriggerClusterBenchSetup {
+    std::string name;
+    uint32_t    mode;
+    bool        sparse;
+  };
+  const std::vector<TriggerClusterBenchSetup> setups = {
+    {"Primitives",       TriggerClusterMakerDefs::Mode::Primitives, false},
+    {"SparsePrimitives", TriggerClusterMakerDefs::Mode::Primitives, true},
+    {"Patches",          TriggerClusterMakerDefs::Mode::Patches,    false}
+  };
+
+  for (const TriggerClusterBenchSetup& setup : setups) {
+    const uint32_t mode = setup.mode;
+    for (const TriggerClusterBenchScenario& scenario : scenarios) {
+
+      // generate events
+      TriggerClusterBenchGenerator          generator(table, 12345);
+      std::vector<TriggerClusterBenchEvent> events(nEvents);
+      for (TriggerClusterBenchEvent& event : events) {
+        generator.Generate(scenario, event);
+      }
+
+      // set up engine
+      //   - n.b. runs with several threads always take the
+      //     parallel path, so that they can be compared
+      //     against 1 thread to find the crossover
+      TriggerClusterEngineConfig config;
+      config.mode             = mode;
+      config.nThreads         = nThreads;
+      config.minParallelPrims = 0;
+      config.patch.retower    = 4;
+      config.patch.minEnergy  = 5.;
+      config.sparse           = setup.sparse;
+      config.sparseThreshold  = 1.;
+
+      TriggerClusterEngine engine;
+      engine.SetConfig(config);
+      engine.Init();
+
+      // warm up buffers, then time
+      TriggerClusterBuffer clusters;
+      const uint32_t       threshold = 5. * TriggerClusterBenchGenerator::AdcPerGeV;
+      for (uint32_t iEvt = 0; iEvt < nWarmup; ++iEvt) {
+        RunEvent(engine, events[iEvt % nEvents], clusters, threshold);
+      }
+
+      double   nsProcess   = 0.;
+      uint64_t nPrimitives = 0;
+      uint64_t nClusters   = 0;
+
+      const uint64_t          allocsStart  = g_nAllocs.load();
+      const uint64_t          skippedStart = engine.GetNSkippedPrimitives();
+      const Clock::time_point start        = Clock::now();
+      for (const TriggerClusterBenchEvent& event : events) {
+        nsProcess   += RunEvent(engine, event, clusters, threshold);
+        nPrimitives += event.primitives.size();
+        nClusters   += clusters.GetNClusters();
+      }
+      const double   nsTotal = ElapsedNs(start);
+      const uint64_t nAllocs = g_nAllocs.load() - allocsStart;
+      engine.End();
+
+      // report
+      const std::string bench = scenario.name + "/" + setup.name;
+      report.Add(bench, "events/s", 1e9 * nEvents / nsTotal);
+      report.Add(bench, "clusters/event", static_cast<double>(nClusters) / nEvents);
+      report.Add(bench, "allocs/event", static_cast<double>(nAllocs) / nEvents);
+      if (mode == TriggerClusterMakerDefs::Mode::Primitives) {
+        report.Add(bench, "prims/event", static_cast<double>(nPrimitives) / nEvents);
+        report.Add(bench, "ns/primitive", (nPrimitives > 0) ? nsProcess / nPrimitives : 0.);
+
+        const uint64_t nLookups = engine.GetNSumCacheHits() + engine.GetNSumCacheMisses();
+        report.Add(bench, "sum cache hit rate", (nLookups > 0) ? static_cast<double>(engine.GetNSumCacheHits()) / nLookups : 0.);
+        if (setup.sparse) {
+          report.Add(bench, "skipped prims/event", static_cast<double>(engine.GetNSkippedPrimitives() - skippedStart) / nEvents);
+        }
+      } else {
+        report.Add(bench, "us/patch scan", 1e-3 * nsProcess / nEvents);
+      }
+    }  // end scenario loop
+  }  // end setup loop
+  return 0;
+
+}  // end 'main(int, char*[])'
+
+// end ------------------------------------------------------------------------
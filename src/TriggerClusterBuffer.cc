@@ -0,0 +1,238 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterBuffer.cc'
+ *  \authors Derek Anderson
+ *  \date    07.10.2024
+ *
+ *  Compact, flat-array storage for all trigger
+ *  clusters in an event
+ */
+// ----------------------------------------------------------------------------
+
+#define TRIGGERCLUSTERBUFFER_CC
+
+// c++ utilities
+#include <algorithm>
+
+// class definition
+#include "TriggerClusterBuffer.h"
+
+
+
+// public methods =============================================================
+
+// ----------------------------------------------------------------------------
+//! Clear all clusters
+// ----------------------------------------------------------------------------
+/*! Vectors keep their capacity, so once the arrays reach
+ *  the high-water mark of an event no further allocations
+ *  are needed.
+ */
+void TriggerClusterBuffer::Reset() {
+
+  m_offsets.assign(1, 0);
+  m_channels.clear();
+  m_energies.clear();
+  m_sums.clear();
+  m_tags.clear();
+  m_fractions.clear();
+  m_fracClusters.clear();
+  m_adcs.clear();
+  return;
+
+}  // end 'Reset()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Print contents
+// ----------------------------------------------------------------------------
+void TriggerClusterBuffer::Print(std::ostream& os) const {
+
+  os << "Packed trigger clusters: " << GetNClusters() << " clusters, " << GetNTowers() << " towers" << std::endl;
+  for (std::size_t iClust = 0; iClust < GetNClusters(); ++iClust) {
+    os << "  Cluster " << iClust
+       << ": source = " << GetSource(iClust)
+       << ", layer = "  << GetLayer(iClust)
+       << ", no. of towers = " << GetNTowers(iClust)
+       << ", energy = " << GetEnergy(iClust)
+       << ", ADC = " << GetAdc(iClust)
+       << ", fractions = (" << GetFraction(iClust, TriggerClusterMakerDefs::Cal::EM)
+       << ", " << GetFraction(iClust, TriggerClusterMakerDefs::Cal::IH)
+       << ", " << GetFraction(iClust, TriggerClusterMakerDefs::Cal::OH)
+       << ")"
+       << std::endl;
+  }
+  return;
+
+}  // end 'Print(std::ostream&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Fraction of a cluster's energy in a layer
+// ----------------------------------------------------------------------------
+/*! Single-layer clusters are implied by their tag. Combined
+ *  grid clusters are looked up by index, which stays sorted
+ *  since clusters are only ever added at the end.
+ */
+float TriggerClusterBuffer::GetFraction(const std::size_t iClust, const uint32_t cal) const {
+
+  const uint32_t layer = GetLayer(iClust);
+  if (layer != AllLayers) {
+    return (layer == cal) ? 1. : 0.;
+  }
+
+  std::vector<uint32_t>::const_iterator itFrac = std::lower_bound(m_fracClusters.begin(), m_fracClusters.end(), iClust);
+  if ((itFrac == m_fracClusters.end()) || (*itFrac != iClust)) {
+    return 0.;
+  }
+  return m_fractions[((itFrac - m_fracClusters.begin()) * NLayers) + cal];
+
+}  // end 'GetFraction(std::size_t, uint32_t)'
+
+
+
+// filling methods ============================================================
+
+// ----------------------------------------------------------------------------
+//! Start a new cluster
+// ----------------------------------------------------------------------------
+void TriggerClusterBuffer::BeginCluster(const uint32_t source, const uint32_t cal) {
+
+  m_tags.push_back( static_cast<uint8_t>(((source & 0xF) << 4) | (cal & 0xF)) );
+  return;
+
+}  // end 'BeginCluster(uint32_t, uint32_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Add a tower to the current cluster
+// ----------------------------------------------------------------------------
+void TriggerClusterBuffer::AddTower(const uint16_t channel, const float energy) {
+
+  m_channels.push_back(channel);
+  m_energies.push_back(energy);
+  return;
+
+}  // end 'AddTower(uint16_t, float)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Add a run of towers to the current cluster
+// ----------------------------------------------------------------------------
+/*! Copies towers from arrays outside the buffer, e.g. sums
+ *  expanded ahead of time (see
+ *  TriggerClusterEngine::ProcessPrimitivesInParallel()).
+ */
+void TriggerClusterBuffer::AddTowers(const uint16_t* channels, const float* energies, const std::size_t nTowers) {
+
+  m_channels.insert(m_channels.end(), channels, channels + nTowers);
+  m_energies.insert(m_energies.end(), energies, energies + nTowers);
+  return;
+
+}  // end 'AddTowers(uint16_t*, float*, std::size_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Add copies of towers already in the buffer to the current cluster
+// ----------------------------------------------------------------------------
+/*! Copies towers [first, first + nTowers), e.g. a sum which
+ *  was already expanded for an earlier cluster. The arrays
+ *  are grown first so that the source range stays valid.
+ */
+void TriggerClusterBuffer::CopyTowers(const std::size_t first, const std::size_t nTowers) {
+
+  const std::size_t size = m_channels.size();
+  m_channels.resize(size + nTowers);
+  m_energies.resize(size + nTowers);
+  std::copy_n(m_channels.begin() + first, nTowers, m_channels.begin() + size);
+  std::copy_n(m_energies.begin() + first, nTowers, m_energies.begin() + size);
+  return;
+
+}  // end 'CopyTowers(std::size_t, std::size_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Close the current cluster
+// ----------------------------------------------------------------------------
+/*! All of the energy is assigned to the layer the cluster
+ *  was tagged with, so no fractions are stored. The ADC is
+ *  only stored once any cluster has a nonzero one, with
+ *  earlier clusters back-filled with 0.
+ */
+void TriggerClusterBuffer::EndCluster(const float energy, const uint16_t adc) {
+
+  m_offsets.push_back(m_channels.size());
+  m_sums.push_back(energy);
+  if ((adc > 0) || !m_adcs.empty()) {
+    m_adcs.resize(m_sums.size(), 0);
+    m_adcs.back() = adc;
+  }
+  return;
+
+}  // end 'EndCluster(float, uint16_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Close the current cluster, splitting its energy between layers
+// ----------------------------------------------------------------------------
+/*! Fractions are only stored for clusters tagged with the
+ *  combined grid (AllLayers); any other cluster's are
+ *  implied by its layer.
+ */
+void TriggerClusterBuffer::EndCluster(const float energy, const std::array<float, NLayers>& fractions, const uint16_t adc) {
+
+  if (GetLayer(m_sums.size()) == AllLayers) {
+    m_fracClusters.push_back(m_sums.size());
+    m_fractions.insert(m_fractions.end(), fractions.begin(), fractions.end());
+  }
+  EndCluster(energy, adc);
+  return;
+
+}  // end 'EndCluster(float, std::array<float, NLayers>&, uint16_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Append all clusters of another container
+// ----------------------------------------------------------------------------
+void TriggerClusterBuffer::Append(const TriggerClusterBuffer& other) {
+
+  // shift other's offsets past this container's towers
+  const uint32_t shift = m_channels.size();
+  for (std::size_t iOffset = 1; iOffset < other.m_offsets.size(); ++iOffset) {
+    m_offsets.push_back(other.m_offsets[iOffset] + shift);
+  }
+
+  // and other's fraction indices past this container's clusters
+  const uint32_t nClusters = GetNClusters();
+  for (const uint32_t iClust : other.m_fracClusters) {
+    m_fracClusters.push_back(iClust + nClusters);
+  }
+
+  // ADCs are only needed if either container has them
+  if (!m_adcs.empty() || !other.m_adcs.empty()) {
+    m_adcs.resize(nClusters, 0);
+    if (other.m_adcs.empty()) {
+      m_adcs.resize(nClusters + other.GetNClusters(), 0);
+    } else {
+      m_adcs.insert(m_adcs.end(), other.m_adcs.begin(), other.m_adcs.end());
+    }
+  }
+
+  // and copy the rest
+  m_channels.insert(m_channels.end(), other.m_channels.begin(), other.m_channels.end());
+  m_energies.insert(m_energies.end(), other.m_energies.begin(), other.m_energies.end());
+  m_sums.insert(m_sums.end(), other.m_sums.begin(), other.m_sums.end());
+  m_tags.insert(m_tags.end(), other.m_tags.begin(), other.m_tags.end());
+  m_fractions.insert(m_fractions.end(), other.m_fractions.begin(), other.m_fractions.end());
+  return;
+
+}  // end 'Append(TriggerClusterBuffer&)'
+
+// end ------------------------------------------------------------------------
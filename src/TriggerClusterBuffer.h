@@ -0,0 +1,155 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterBuffer.h'
+ *  \authors Derek Anderson
+ *  \date    07.10.2024
+ *
+ *  Compact, flat-array storage for all trigger
+ *  clusters in an event
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERBUFFER_H
+#define TRIGGERCLUSTERBUFFER_H
+
+// c++ utilities
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+// module utilities
+#include "TriggerClusterMakerDefs.h"
+
+
+
+// ----------------------------------------------------------------------------
+//! Packed buffer of trigger clusters
+// ----------------------------------------------------------------------------
+/*! Stores every cluster of an event in a handful of flat
+ *  arrays rather than one RawCluster (and one std::map) per
+ *  cluster:
+ *
+ *    - offsets:  index of each cluster's first tower, plus
+ *                one past the last tower of the last cluster
+ *    - channels: packed tower channel of each tower
+ *    - energies: energy of each tower
+ *    - sums:     summed energy of each cluster
+ *    - tags:     source (TriggerClusterMakerDefs::Source) and
+ *                layer (TriggerClusterMakerDefs::Cal, or
+ *                AllLayers) of each cluster
+ *    - fractions: fraction of the energy in each layer,
+ *                NLayers per combined-grid cluster
+ *    - fracClusters: index of the cluster each set of
+ *                fractions belongs to
+ *    - adcs:     summed trigger ADC of each cluster, if it
+ *                was built from trigger sums (0 otherwise);
+ *                left empty until a cluster has a nonzero ADC
+ *
+ *  Packed channels index the EMCal, inner HCal, and outer
+ *  HCal channels back to back, followed by the cells of the
+ *  combined (EMCal + HCal) retower grid in (eta, phi) order,
+ *  so every tower fits in 16 bits; use GetChannelLayer() and
+ *  GetLayerChannel() to unpack them. Channels within a layer
+ *  follow whatever map the cluster engine was given: (eta,
+ *  phi) order by default, or the tower containers' channel
+ *  order when filled by TriggerClusterMaker.
+ *
+ *  Clusters of a single layer have all of their energy in
+ *  that layer, so their fractions are implied by the tag
+ *  and never stored; only clusters built on the combined
+ *  grid record the split between layers. Likewise, events
+ *  without ADC sums store no ADCs at all.
+ *
+ *  This has no framework dependencies so that the cluster
+ *  engine can fill it directly; TriggerClusterContainer
+ *  wraps it for the node tree.
+ */
+class TriggerClusterBuffer {
+
+  public:
+
+    // no. of layers, and layer index of the combined grid
+    static constexpr uint32_t NLayers   = TriggerClusterMakerDefs::Cal::OH + 1;
+    static constexpr uint32_t AllLayers = NLayers;
+
+    // ctor/dtor
+    TriggerClusterBuffer()  {Reset();};
+    ~TriggerClusterBuffer() {};
+
+    // public methods
+    void Reset();
+    void Print(std::ostream& os = std::cout) const;
+
+    // filling methods
+    void BeginCluster(const uint32_t source, const uint32_t cal);
+    void AddTower(const uint16_t channel, const float energy);
+    void AddTowers(const uint16_t* channels, const float* energies, const std::size_t nTowers);
+    void CopyTowers(const std::size_t first, const std::size_t nTowers);
+    void EndCluster(const float energy, const uint16_t adc = 0);
+    void EndCluster(const float energy, const std::array<float, NLayers>& fractions, const uint16_t adc = 0);
+    void Append(const TriggerClusterBuffer& other);
+
+    // getters
+    std::size_t     GetNClusters()                        const {return m_sums.size();}
+    std::size_t     GetNTowers()                          const {return m_channels.size();}
+    uint32_t        GetNTowers(const std::size_t iClust)  const {return m_offsets[iClust + 1] - m_offsets[iClust];}
+    uint32_t        GetSource(const std::size_t iClust)   const {return m_tags[iClust] >> 4;}
+    uint32_t        GetLayer(const std::size_t iClust)    const {return m_tags[iClust] & 0xF;}
+    float           GetEnergy(const std::size_t iClust)   const {return m_sums[iClust];}
+    uint16_t        GetAdc(const std::size_t iClust)      const {return m_adcs.empty() ? 0 : m_adcs[iClust];}
+    const uint16_t* GetChannels(const std::size_t iClust) const {return m_channels.data() + m_offsets[iClust];}
+    const float*    GetEnergies(const std::size_t iClust) const {return m_energies.data() + m_offsets[iClust];}
+    float           GetFraction(const std::size_t iClust, const uint32_t cal) const;
+
+    // ------------------------------------------------------------------------
+    //! Offset of a layer's towers in packed channels
+    // ------------------------------------------------------------------------
+    static uint32_t GetChannelOffset(const uint32_t cal) {
+      switch (cal) {
+        case AllLayers:
+          return GetChannelOffset(TriggerClusterMakerDefs::Cal::OH) + (TriggerClusterMakerDefs::CalTraits<TriggerClusterMakerDefs::Cal::OH>::nEta * TriggerClusterMakerDefs::CalTraits<TriggerClusterMakerDefs::Cal::OH>::nPhi);
+        case TriggerClusterMakerDefs::Cal::OH:
+          return GetChannelOffset(TriggerClusterMakerDefs::Cal::IH) + (TriggerClusterMakerDefs::CalTraits<TriggerClusterMakerDefs::Cal::IH>::nEta * TriggerClusterMakerDefs::CalTraits<TriggerClusterMakerDefs::Cal::IH>::nPhi);
+        case TriggerClusterMakerDefs::Cal::IH:
+          return TriggerClusterMakerDefs::CalTraits<TriggerClusterMakerDefs::Cal::EM>::nEta * TriggerClusterMakerDefs::CalTraits<TriggerClusterMakerDefs::Cal::EM>::nPhi;
+        case TriggerClusterMakerDefs::Cal::EM:
+          [[fallthrough]];
+        default:
+          return 0;
+      }
+    }
+
+    // ------------------------------------------------------------------------
+    //! Layer of a packed channel
+    // ------------------------------------------------------------------------
+    static uint32_t GetChannelLayer(const uint16_t channel) {
+      if (channel >= GetChannelOffset(AllLayers))                    return AllLayers;
+      if (channel >= GetChannelOffset(TriggerClusterMakerDefs::Cal::OH)) return TriggerClusterMakerDefs::Cal::OH;
+      if (channel >= GetChannelOffset(TriggerClusterMakerDefs::Cal::IH)) return TriggerClusterMakerDefs::Cal::IH;
+      return TriggerClusterMakerDefs::Cal::EM;
+    }
+
+    // ------------------------------------------------------------------------
+    //! Channel of a packed channel within its layer's tower container
+    // ------------------------------------------------------------------------
+    static uint32_t GetLayerChannel(const uint16_t channel) {
+      return channel - GetChannelOffset(GetChannelLayer(channel));
+    }
+
+  private:
+
+    // flat cluster data
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint16_t> m_channels;
+    std::vector<float>    m_energies;
+    std::vector<float>    m_sums;
+    std::vector<uint8_t>  m_tags;
+    std::vector<float>    m_fractions;
+    std::vector<uint32_t> m_fracClusters;
+    std::vector<uint16_t> m_adcs;
+
+};
+
+#endif
+
+// end ------------------------------------------------------------------------
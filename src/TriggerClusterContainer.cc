@@ -0,0 +1,31 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterContainer.cc'
+ *  \authors Derek Anderson
+ *  \date    06.28.2024
+ *
+ *  Compact, flat-array storage for all trigger
+ *  clusters in an event
+ */
+// ----------------------------------------------------------------------------
+
+#define TRIGGERCLUSTERCONTAINER_CC
+
+// class definition
+#include "TriggerClusterContainer.h"
+
+
+
+// PHObject methods ===========================================================
+
+// ----------------------------------------------------------------------------
+//! Print contents
+// ----------------------------------------------------------------------------
+void TriggerClusterContainer::identify(std::ostream& os) const {
+
+  os << "TriggerClusterContainer:" << std::endl;
+  Print(os);
+  return;
+
+}  // end 'identify(std::ostream&)'
+
+// end ------------------------------------------------------------------------
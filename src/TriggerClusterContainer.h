@@ -0,0 +1,51 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterContainer.h'
+ *  \authors Derek Anderson
+ *  \date    06.28.2024
+ *
+ *  Compact, flat-array storage for all trigger
+ *  clusters in an event
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERCONTAINER_H
+#define TRIGGERCLUSTERCONTAINER_H
+
+// c++ utilities
+#include <iostream>
+// phool libraries
+#include <phool/PHObject.h>
+// module utilities
+#include "TriggerClusterBuffer.h"
+
+
+
+// ----------------------------------------------------------------------------
+//! Packed container of trigger clusters
+// ----------------------------------------------------------------------------
+/*! Puts a TriggerClusterBuffer on the node tree. All of the
+ *  storage and accessors live in the buffer, see there for
+ *  the layout.
+ */
+class TriggerClusterContainer : public PHObject, public TriggerClusterBuffer {
+
+  public:
+
+    // ctor/dtor
+    TriggerClusterContainer()           {};
+    ~TriggerClusterContainer() override {};
+
+    // PHObject methods
+    void Reset() override {TriggerClusterBuffer::Reset();}
+    void identify(std::ostream& os = std::cout) const override;
+    int  isValid() const override {return 1;}
+
+  private:
+
+    ClassDefOverride(TriggerClusterContainer, 5)
+
+};
+
+#endif
+
+// end ------------------------------------------------------------------------
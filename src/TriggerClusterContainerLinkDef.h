@@ -0,0 +1,20 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterContainerLinkDef.h'
+ *  \authors Derek Anderson
+ *  \date    06.28.2024
+ *
+ *  Compact, flat-array storage for all trigger
+ *  clusters in an event
+ */
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#ifdef __CINT__
+
+#pragma link C++ class TriggerClusterBuffer+;
+#pragma link C++ class TriggerClusterContainer+;
+
+#endif  // end if __CINT__
+
+// end ------------------------------------------------------------------------
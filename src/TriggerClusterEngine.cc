@@ -0,0 +1,1172 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterEngine.cc'
+ *  \authors Derek Anderson
+ *  \date    07.10.2024
+ *
+ *  Framework-free core of the TriggerClusterMaker
+ *  module
+ */
+// ----------------------------------------------------------------------------
+
+#define TRIGGERCLUSTERENGINE_CC
+
+// c++ utilities
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+// module utilities
+#include "TriggerClusterKernels.h"
+
+// class definition
+#include "TriggerClusterEngine.h"
+
+
+
+// setup methods ==============================================================
+
+// ----------------------------------------------------------------------------
+//! Build lookup tables, size grids, and spin up workers
+// ----------------------------------------------------------------------------
+/*! Every layer starts with channels in (eta, phi) order;
+ *  call MapChannels() afterwards to use a different order.
+ */
+void TriggerClusterEngine::Init() {
+
+  // print debug message
+  TRGCLUST_LOG(1, "TriggerClusterEngine::Init() Initializing engine");
+
+  // make sure patch configurations fit their grids
+  ValidatePatchConfig(m_config.patch);
+  for (const TriggerClusterPatchConfig& config : m_config.sweep) {
+    ValidatePatchConfig(config);
+  }
+
+  // precompute sum to tower expansion
+  m_sumTable.Build();
+
+  // size grids and set identity channel maps
+  for (uint32_t iCal = 0; iCal < m_towerGrids.size(); ++iCal) {
+    m_towerGrids[iCal].Resize(
+      TriggerClusterMakerDefs::NEtaTowers(iCal),
+      TriggerClusterMakerDefs::NPhiTowers(iCal)
+    );
+
+    std::vector<uint32_t> identity(m_towerGrids[iCal].Size());
+    for (uint32_t iChan = 0; iChan < identity.size(); ++iChan) {
+      identity[iChan] = iChan;
+    }
+    MapChannels(iCal, identity);
+  }
+
+  // size sum caches
+  m_sumCache.Resize(m_sumTable.GetNSpans());
+
+  // spin up workers if processing in parallel
+  if (m_config.nThreads > 1) {
+    m_workers.Start(m_config.nThreads);
+    m_workerClusters.resize(m_config.nThreads);
+  }
+  m_log.Flush();
+  return;
+
+}  // end 'Init()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Join workers
+// ----------------------------------------------------------------------------
+void TriggerClusterEngine::End() {
+
+  // print debug message
+  TRGCLUST_LOG(1, "TriggerClusterEngine::End() Stopping engine");
+
+  m_workers.Stop();
+  m_log.Flush();
+  return;
+
+}  // end 'End()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Set order of a layer's channels
+// ----------------------------------------------------------------------------
+/*! chanToGrid[iChan] is the (eta, phi) grid index of channel
+ *  iChan. Channels are what SetTowers() reads from, what
+ *  maskedChannels lists, and what gets stored in the output
+ *  clusters (offset by layer, see
+ *  TriggerClusterBuffer::GetChannelOffset()).
+ */
+void TriggerClusterEngine::MapChannels(const uint32_t cal, const std::vector<uint32_t>& chanToGrid) {
+
+  // print debug message
+  TRGCLUST_LOG(1, "TriggerClusterEngine::MapChannels(uint32_t, std::vector<uint32_t>&) Mapping " << chanToGrid.size() << " channels of layer " << cal);
+
+  // packed channels assume one channel per grid cell
+  const std::size_t nTowers = m_towerGrids[cal].Size();
+  if (chanToGrid.size() > nTowers) {
+    std::cerr << "TriggerClusterEngine::MapChannels(uint32_t, std::vector<uint32_t>&): PANIC! Layer " << cal << " has more channels than towers! Aborting!" << std::endl;
+    assert(chanToGrid.size() <= nTowers);
+  }
+
+  // map each grid index back onto a packed channel
+  const uint32_t offset = TriggerClusterBuffer::GetChannelOffset(cal);
+  m_chanToGrid[cal] = chanToGrid;
+  m_gridToChan[cal].assign(nTowers, offset);
+  for (uint32_t iChan = 0; iChan < chanToGrid.size(); ++iChan) {
+    if (chanToGrid[iChan] >= nTowers) {
+      std::cerr << "TriggerClusterEngine::MapChannels(uint32_t, std::vector<uint32_t>&): PANIC! Channel " << iChan << " of layer " << cal << " is off the grid! Aborting!" << std::endl;
+      assert(chanToGrid[iChan] < nTowers);
+    }
+    m_gridToChan[cal][chanToGrid[iChan]] = offset + iChan;
+  }
+
+  // and rebuild run mask in the new order
+  m_runMasks[cal].assign((nTowers + 63) / 64, 0);
+  m_towerMasks[cal].assign(m_runMasks[cal].size(), 0);
+  for (const uint32_t iChan : m_config.maskedChannels[cal]) {
+    if (iChan >= chanToGrid.size()) {
+      std::cerr << "TriggerClusterEngine::MapChannels(uint32_t, std::vector<uint32_t>&): PANIC! Masked channel " << iChan << " of layer " << cal << " doesn't exist! Aborting!" << std::endl;
+      assert(iChan < chanToGrid.size());
+    }
+    m_runMasks[cal][chanToGrid[iChan] / 64] |= (uint64_t(1) << (chanToGrid[iChan] % 64));
+  }
+  return;
+
+}  // end 'MapChannels(uint32_t, std::vector<uint32_t>&)'
+
+
+
+// event methods ==============================================================
+
+// ----------------------------------------------------------------------------
+//! Start a new event
+// ----------------------------------------------------------------------------
+/*! Clears the output buffer and any queued primitives. Tower
+ *  grids are left as they are, so layers which aren't set
+ *  this event keep their last values.
+ */
+void TriggerClusterEngine::BeginEvent(TriggerClusterBuffer* clusters) {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterEngine::BeginEvent(TriggerClusterBuffer*) Starting event");
+
+  m_clusters       = clusters;
+  m_clusters -> Reset();
+  m_sumCache.Invalidate();
+  m_nImages        = 0;
+  m_isPyramidBuilt = false;
+
+  m_nMaskedTowers.fill(0);
+  m_maskedEnergies.fill(0.);
+
+  m_primSums.clear();
+  m_primOffsets.assign(1, 0);
+  m_primLayers.clear();
+  m_primSumAdcs.clear();
+  return;
+
+}  // end 'BeginEvent(TriggerClusterBuffer*)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Copy a layer's tower energies (and statuses) into its grid
+// ----------------------------------------------------------------------------
+/*! energies[iChan] is the energy of channel iChan, ordered as
+ *  set by MapChannels(). Towers without a channel are zeroed,
+ *  as are all statuses if statuses is NULL. Bad and listed
+ *  channels are then masked (see MaskTowers()).
+ */
+void TriggerClusterEngine::SetTowers(const uint32_t cal, const float* energies, const std::size_t nChannels, const uint8_t* statuses) {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterEngine::SetTowers(uint32_t, float*, std::size_t, uint8_t*) Setting " << nChannels << " towers of layer " << cal);
+
+  TriggerClusterTowerGrid& grid  = m_towerGrids[cal];
+  const uint32_t*          index = m_chanToGrid[cal].data();
+  const std::size_t        nChan = std::min(nChannels, m_chanToGrid[cal].size());
+
+  // towers changed, so any patch images, the
+  // pyramid, and cached sums are stale
+  m_sumCache.Invalidate();
+  m_nImages        = 0;
+  m_isPyramidBuilt = false;
+
+  grid.Reset();
+  for (std::size_t iChan = 0; iChan < nChan; ++iChan) {
+    grid.energy[index[iChan]] = energies[iChan];
+  }
+  if (statuses) {
+    for (std::size_t iChan = 0; iChan < nChan; ++iChan) {
+      grid.status[index[iChan]] = statuses[iChan];
+    }
+  }
+  MaskTowers(cal);
+  return;
+
+}  // end 'SetTowers(uint32_t, float*, std::size_t, uint8_t*)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Zero the bad and listed towers of a layer
+// ----------------------------------------------------------------------------
+/*! Merges the run's masked channels with the towers whose
+ *  status has any of maskStatusBits, and zeroes the masked
+ *  towers of the grid in one vectorized pass. Everything
+ *  downstream (sums, patches, pyramid, LL1 footprints) only
+ *  reads the grid, so masked towers cost nothing there; they
+ *  still show up as constituents, with no energy. Called by
+ *  SetTowers(); call it directly after filling a grid via
+ *  GetTowerGrid().
+ */
+void TriggerClusterEngine::MaskTowers(const uint32_t cal) {
+
+  if (!m_config.maskChannels) return;
+
+  // grid is about to change, so anything
+  // built from it is stale
+  m_sumCache.Invalidate();
+  m_nImages        = 0;
+  m_isPyramidBuilt = false;
+
+  // merge run mask with bad statuses
+  TriggerClusterTowerGrid& grid = m_towerGrids[cal];
+  std::vector<uint64_t>&   mask = m_towerMasks[cal];
+  std::copy(m_runMasks[cal].begin(), m_runMasks[cal].end(), mask.begin());
+  if (m_config.maskStatusBits != 0) {
+    TriggerClusterKernels::MaskStatus(grid.status.data(), grid.Size(), m_config.maskStatusBits, mask.data());
+  }
+
+  // then zero masked towers
+  m_maskedEnergies[cal] = TriggerClusterKernels::ZeroMasked(grid.energy.data(), grid.Size(), mask.data());
+  m_nMaskedTowers[cal]  = 0;
+  for (const uint64_t word : mask) {
+    m_nMaskedTowers[cal] += __builtin_popcountll(word);
+  }
+
+  // print debug message
+  TRGCLUST_LOG(3, "    Masked " << m_nMaskedTowers[cal] << " towers of layer " << cal << ", removing " << m_maskedEnergies[cal] << " GeV");
+  return;
+
+}  // end 'MaskTowers(uint32_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Clear fired LL1 patches
+// ----------------------------------------------------------------------------
+void TriggerClusterEngine::ResetLL1s() {
+
+  m_ll1Decoder.Reset();
+  return;
+
+}  // end 'ResetLL1s()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Add an LL1 trigger word
+// ----------------------------------------------------------------------------
+/*! See TriggerClusterLL1Decoder::Fill(). */
+bool TriggerClusterEngine::AddLL1Word(
+  const uint32_t cal,
+  const uint32_t iEta,
+  const uint32_t iPhi,
+  const unsigned int* samples,
+  const std::size_t nSamples,
+  const uint32_t threshold
+) {
+
+  return m_ll1Decoder.Fill(cal, iEta, iPhi, samples, nSamples, threshold);
+
+}  // end 'AddLL1Word(uint32_t, uint32_t, uint32_t, unsigned int*, std::size_t, uint32_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Build clusters from the fired LL1 patches
+// ----------------------------------------------------------------------------
+/*! Each fired patch is expanded into a cluster of the towers
+ *  under its NTowInLL1 x NTowInLL1 retower footprint. Patches
+ *  from words which don't map onto a single layer (e.g.
+ *  combined jet patches) produce one cluster per layer so
+ *  that EMCal and HCal towers are never mixed in one cluster.
+ */
+void TriggerClusterEngine::ProcessLL1s() {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterEngine::ProcessLL1s() Building clusters from LL1 trigger words");
+
+  m_ll1Decoder.Decode(m_ll1Patches);
+  for (const TriggerClusterLL1Decoder::Patch& patch : m_ll1Patches) {
+
+    // print debug message
+    TRGCLUST_LOG(3, "    Fired patch: source = " << patch.source << ", (eta, phi) = (" << patch.iEta << ", " << patch.iPhi << "), ADC = " << patch.adc);
+
+    if (patch.source == TriggerClusterLL1Decoder::AllLayers) {
+      AddLL1PatchToCluster<TriggerClusterMakerDefs::Cal::EM>(patch);
+      AddLL1PatchToCluster<TriggerClusterMakerDefs::Cal::IH>(patch);
+      AddLL1PatchToCluster<TriggerClusterMakerDefs::Cal::OH>(patch);
+    } else {
+      TriggerClusterMakerDefs::DispatchCal(
+        patch.source,
+        [this, &patch](auto layer) {
+          this -> AddLL1PatchToCluster<decltype(layer)::value>(patch);
+        }
+      );
+    }
+  }  // end patch loop
+  return;
+
+}  // end 'ProcessLL1s()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Queue a primitive
+// ----------------------------------------------------------------------------
+/*! The primitive's cluster is tagged with layer, and built
+ *  from the towers of the listed sums. Invalid sum IDs are
+ *  skipped. If summing ADCs, sumAdcs[iSum] is the trigger
+ *  ADC (e.g. LUT output) of sum iSum; sums without an ADC
+ *  count as 0.
+ */
+void TriggerClusterEngine::AddPrimitive(const uint32_t layer, const uint32_t* sumIDs, const std::size_t nSums, const uint16_t* sumAdcs) {
+
+  m_primSums.insert(m_primSums.end(), sumIDs, sumIDs + nSums);
+  m_primOffsets.push_back(m_primSums.size());
+  m_primLayers.push_back(layer);
+  if (m_config.sumAdcs) {
+    if (sumAdcs) {
+      m_primSumAdcs.insert(m_primSumAdcs.end(), sumAdcs, sumAdcs + nSums);
+    } else {
+      m_primSumAdcs.resize(m_primSums.size(), 0);
+    }
+  }
+  return;
+
+}  // end 'AddPrimitive(uint32_t, uint32_t*, std::size_t, uint16_t*)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Build clusters from the queued primitives
+// ----------------------------------------------------------------------------
+void TriggerClusterEngine::ProcessPrimitives() {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterEngine::ProcessPrimitives() Processing " << m_primLayers.size() << " primitives");
+
+  // in sparse mode, drop primitives with nothing above threshold
+  if (m_config.sparse) {
+    FindActivePrimitives();
+  }
+
+  // sum every primitive's ADCs in one pass
+  if (m_config.sumAdcs) {
+    SumPrimitiveAdcs();
+  }
+
+  // hand off to workers if available and worth it
+  if ((m_workers.GetNWorkers() > 1) && (GetNPrimsToVisit() >= m_config.minParallelPrims)) {
+    ProcessPrimitivesInParallel();
+    return;
+  }
+
+  TriggerClusterSumCache* cache = m_config.cacheSums ? &m_sumCache : NULL;
+  for (std::size_t iVisit = 0; iVisit < GetNPrimsToVisit(); ++iVisit) {
+    const std::size_t iPrim = GetPrimToVisit(iVisit);
+    TriggerClusterMakerDefs::DispatchCal(
+      m_primLayers[iPrim],
+      [this, iPrim, cache](auto layer) {
+        this -> AddPrimitiveToCluster<decltype(layer)::value>(iPrim, m_clusters, cache);
+      }
+    );
+  }  // end primitive loop
+  return;
+
+}  // end 'ProcessPrimitives()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Build clusters from sliding-window patches
+// ----------------------------------------------------------------------------
+/*! Every overlapping patch of the configured size and
+ *  stride is summed via the patch finder's integral image,
+ *  so the cost of finding patches is O(towers). Only patches
+ *  above threshold are expanded into clusters.
+ *
+ *  If the configured layer is TriggerClusterPyramid::AllLayers,
+ *  patches are found on the combined EMCal + HCal retower
+ *  grid of the energy pyramid, i.e. full-calorimeter jet
+ *  patches, in one pass.
+ */
+void TriggerClusterEngine::ProcessPatches() {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterEngine::ProcessPatches() Building clusters from patches");
+
+  const TriggerClusterPatchConfig& config = m_config.patch;
+  AddPatchesToClusters(config, GetPatchImage(config.cal, config.retower), m_clusters);
+  return;
+
+}  // end 'ProcessPatches()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Build clusters from patches for every sweep configuration
+// ----------------------------------------------------------------------------
+/*! clusters[iConfig] receives the patches of sweep[iConfig]
+ *  (see TriggerClusterEngineConfig), and is reset first.
+ *  Retowered grids and integral images are shared by every
+ *  configuration with the same layer and retower size, so
+ *  sweeping N configurations costs one pass over the towers
+ *  plus N patch scans.
+ */
+void TriggerClusterEngine::ProcessSweep(const std::vector<TriggerClusterBuffer*>& clusters) {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterEngine::ProcessSweep(std::vector<TriggerClusterBuffer*>&) Sweeping " << m_config.sweep.size() << " patch configurations");
+
+  // need one output per configuration
+  if (clusters.size() != m_config.sweep.size()) {
+    std::cerr << "TriggerClusterEngine::ProcessSweep(std::vector<TriggerClusterBuffer*>&): PANIC! Got " << clusters.size() << " outputs for " << m_config.sweep.size() << " configurations! Aborting!" << std::endl;
+    assert(clusters.size() == m_config.sweep.size());
+  }
+
+  for (std::size_t iConfig = 0; iConfig < m_config.sweep.size(); ++iConfig) {
+    const TriggerClusterPatchConfig& config = m_config.sweep[iConfig];
+    clusters[iConfig] -> Reset();
+    AddPatchesToClusters(config, GetPatchImage(config.cal, config.retower), clusters[iConfig]);
+  }
+  return;
+
+}  // end 'ProcessSweep(std::vector<TriggerClusterBuffer*>&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Finish an event
+// ----------------------------------------------------------------------------
+void TriggerClusterEngine::EndEvent() {
+
+  m_log.Flush();
+  return;
+
+}  // end 'EndEvent()'
+
+
+
+// shared intermediates =======================================================
+
+// ----------------------------------------------------------------------------
+//! Get the energy pyramid of the current event
+// ----------------------------------------------------------------------------
+/*! Built from the tower grids the first time it's asked for
+ *  in an event, and shared by everything afterwards.
+ */
+const TriggerClusterPyramid& TriggerClusterEngine::GetPyramid() {
+
+  TriggerClusterPyramid* pyramid = m_pyramid ? m_pyramid : &m_ownPyramid;
+  if (!m_isPyramidBuilt) {
+    TRGCLUST_LOG(2, "TriggerClusterEngine::GetPyramid() Building energy pyramid");
+    pyramid -> Build({
+      m_towerGrids[TriggerClusterMakerDefs::Cal::EM].energy.data(),
+      m_towerGrids[TriggerClusterMakerDefs::Cal::IH].energy.data(),
+      m_towerGrids[TriggerClusterMakerDefs::Cal::OH].energy.data()
+    });
+    m_isPyramidBuilt = true;
+  }
+  return *pyramid;
+
+}  // end 'GetPyramid()'
+
+
+
+// counters ===================================================================
+
+// ----------------------------------------------------------------------------
+//! Get no. of sums reused from the sum caches so far
+// ----------------------------------------------------------------------------
+uint64_t TriggerClusterEngine::GetNSumCacheHits() const {
+
+  return m_sumCache.GetNHits();
+
+}  // end 'GetNSumCacheHits()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Get no. of sums expanded from the tower grids so far
+// ----------------------------------------------------------------------------
+uint64_t TriggerClusterEngine::GetNSumCacheMisses() const {
+
+  return m_sumCache.GetNMisses();
+
+}  // end 'GetNSumCacheMisses()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Get no. of towers masked this event
+// ----------------------------------------------------------------------------
+uint32_t TriggerClusterEngine::GetNMaskedTowers() const {
+
+  uint32_t nMasked = 0;
+  for (const uint32_t nLayer : m_nMaskedTowers) {
+    nMasked += nLayer;
+  }
+  return nMasked;
+
+}  // end 'GetNMaskedTowers()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Get energy removed by masking this event
+// ----------------------------------------------------------------------------
+float TriggerClusterEngine::GetMaskedEnergy() const {
+
+  float energy = 0.;
+  for (const float eLayer : m_maskedEnergies) {
+    energy += eLayer;
+  }
+  return energy;
+
+}  // end 'GetMaskedEnergy()'
+
+
+
+// private methods ============================================================
+
+// ----------------------------------------------------------------------------
+//! Check that a patch configuration's retower size fits its grid
+// ----------------------------------------------------------------------------
+/*! Retowering drops any towers left over at the end of a
+ *  row or column, while patch constituents wrap around the
+ *  full grid in phi. So the retower size has to divide the
+ *  grid exactly along both axes, or the two would disagree.
+ *  For AllLayers, the grid is the combined retower grid.
+ */
+void TriggerClusterEngine::ValidatePatchConfig(const TriggerClusterPatchConfig& config) const {
+
+  if (config.cal > TriggerClusterPyramid::AllLayers) {
+    std::cerr << "TriggerClusterEngine::ValidatePatchConfig(TriggerClusterPatchConfig&): PANIC! Patch layer " << config.cal << " doesn't exist! Aborting!" << std::endl;
+    assert(config.cal <= TriggerClusterPyramid::AllLayers);
+  }
+
+  // get grid patches are built from
+  const bool     isCombined = (config.cal == TriggerClusterPyramid::AllLayers);
+  const uint32_t nEta       = isCombined ? TriggerClusterPyramid::GetNEta(config.cal, TriggerClusterMakerDefs::Level::RetowerLevel) : TriggerClusterMakerDefs::NEtaTowers(config.cal);
+  const uint32_t nPhi       = isCombined ? TriggerClusterPyramid::GetNPhi(config.cal, TriggerClusterMakerDefs::Level::RetowerLevel) : TriggerClusterMakerDefs::NPhiTowers(config.cal);
+
+  const bool isDividing = (config.retower > 0) && ((nEta % config.retower) == 0) && ((nPhi % config.retower) == 0);
+  if (!isDividing) {
+    std::cerr << "TriggerClusterEngine::ValidatePatchConfig(TriggerClusterPatchConfig&): PANIC! Retower size " << config.retower << " doesn't divide the " << nEta << " x " << nPhi << " grid of layer " << config.cal << "! Aborting!" << std::endl;
+    assert(isDividing);
+  }
+  return;
+
+}  // end 'ValidatePatchConfig(TriggerClusterPatchConfig&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Get the integral image of a layer at a retower size
+// ----------------------------------------------------------------------------
+/*! Images are built the first time they're asked for in an
+ *  event and reused afterwards, until towers change. Storage
+ *  is kept across events, so no allocations are needed once
+ *  every image has been built once. Retower sizes matching a
+ *  level of the energy pyramid are read from it rather than
+ *  reduced again.
+ */
+const TriggerClusterEngine::PatchImage& TriggerClusterEngine::GetPatchImage(const uint32_t cal, const uint32_t retower) {
+
+  // check if image was already built this event
+  const uint32_t size = std::max(retower, 1U);
+  for (std::size_t iImage = 0; iImage < m_nImages; ++iImage) {
+    if ((m_images[iImage].cal == cal) && (m_images[iImage].retower == size)) {
+      return m_images[iImage];
+    }
+  }
+
+  // otherwise grab next slot
+  if (m_nImages == m_images.size()) {
+    m_images.emplace_back();
+  }
+  PatchImage& image = m_images[m_nImages++];
+  image.cal     = cal;
+  image.retower = size;
+
+  // use towers as is if no retowering needed
+  //   - n.b. the combined grid only exists in the pyramid
+  if ((size == 1) && (cal != TriggerClusterPyramid::AllLayers)) {
+    image.finder.Build(m_towerGrids[cal]);
+    return image;
+  }
+
+  // use a pyramid level if one matches
+  for (uint32_t iLevel = TriggerClusterMakerDefs::Level::RetowerLevel; iLevel < TriggerClusterPyramid::NLevels; ++iLevel) {
+    if (TriggerClusterPyramid::GetFactor(cal, iLevel) == size) {
+      image.finder.Build(
+        GetPyramid().GetEnergies(cal, iLevel),
+        TriggerClusterPyramid::GetNEta(cal, iLevel),
+        TriggerClusterPyramid::GetNPhi(cal, iLevel)
+      );
+      return image;
+    }
+  }
+
+  // otherwise retower directly
+  const bool     isCombined = (cal == TriggerClusterPyramid::AllLayers);
+  const float*   energies   = isCombined ? GetPyramid().GetEnergies(cal, TriggerClusterMakerDefs::Level::RetowerLevel) : m_towerGrids[cal].energy.data();
+  const uint32_t nEta       = isCombined ? TriggerClusterPyramid::GetNEta(cal, TriggerClusterMakerDefs::Level::RetowerLevel) : m_towerGrids[cal].nEta;
+  const uint32_t nPhi       = isCombined ? TriggerClusterPyramid::GetNPhi(cal, TriggerClusterMakerDefs::Level::RetowerLevel) : m_towerGrids[cal].nPhi;
+
+  image.grid.Resize(nEta / size, nPhi / size);
+  TriggerClusterKernels::BlockSum(energies, nEta, nPhi, size, image.grid.energy.data());
+  image.finder.Build(image.grid);
+  return image;
+
+}  // end 'GetPatchImage(uint32_t, uint32_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Find patches in an image and turn them into clusters
+// ----------------------------------------------------------------------------
+void TriggerClusterEngine::AddPatchesToClusters(
+  const TriggerClusterPatchConfig& config,
+  const PatchImage& image,
+  TriggerClusterBuffer* clusters
+) {
+
+  image.finder.FindPatches(config, m_patches);
+
+  // combined patches are built from the pyramid instead
+  if (image.cal == TriggerClusterPyramid::AllLayers) {
+    AddCombinedPatchesToClusters(config, image, clusters);
+    return;
+  }
+
+  // turn each patch into a cluster of its constituent towers
+  const TriggerClusterTowerGrid& grid  = m_towerGrids[image.cal];
+  const uint16_t*                chans = m_gridToChan[image.cal].data();
+  for (const TriggerClusterPatchFinder::Patch& patch : m_patches) {
+
+    const uint32_t etaStart = patch.iEta * image.retower;
+    const uint32_t phiStart = patch.iPhi * image.retower;
+    const uint32_t etaStop  = etaStart + (config.nEta * image.retower);
+    const uint32_t phiStop  = phiStart + (config.nPhi * image.retower);
+
+    clusters -> BeginCluster(TriggerClusterMakerDefs::Source::FromPatch, image.cal);
+    for (uint32_t iEta = etaStart; iEta < etaStop; ++iEta) {
+      for (uint32_t iPhi = phiStart; iPhi < phiStop; ++iPhi) {
+        const uint32_t index = grid.Index(iEta, iPhi % grid.nPhi);
+        clusters -> AddTower(chans[index], grid.energy[index]);
+      }
+    }  // end tower loops
+    clusters -> EndCluster(patch.energy);
+
+  }  // end patch loop
+  return;
+
+}  // end 'AddPatchesToClusters(TriggerClusterPatchConfig&, PatchImage&, TriggerClusterBuffer*)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Turn found patches on the combined grid into clusters
+// ----------------------------------------------------------------------------
+/*! Constituents are cells of the combined retower grid (see
+ *  TriggerClusterBuffer::GetChannelOffset()) rather than
+ *  towers, so EMCal and HCal towers are still never mixed
+ *  in one cluster. The energy of each layer under the patch
+ *  is summed alongside, from the same pyramid level, and
+ *  stored as fractions of the patch energy.
+ */
+void TriggerClusterEngine::AddCombinedPatchesToClusters(
+  const TriggerClusterPatchConfig& config,
+  const PatchImage& image,
+  TriggerClusterBuffer* clusters
+) {
+
+  const uint32_t level  = TriggerClusterMakerDefs::Level::RetowerLevel;
+  const uint32_t nPhi   = TriggerClusterPyramid::GetNPhi(image.cal, level);
+  const uint32_t offset = TriggerClusterBuffer::GetChannelOffset(image.cal);
+
+  const TriggerClusterPyramid& pyramid  = GetPyramid();
+  const float*                 combined = pyramid.GetEnergies(image.cal, level);
+
+  std::array<const float*, TriggerClusterBuffer::NLayers> layers;
+  for (uint32_t iCal = 0; iCal < layers.size(); ++iCal) {
+    layers[iCal] = pyramid.GetEnergies(iCal, level);
+  }
+
+  for (const TriggerClusterPatchFinder::Patch& patch : m_patches) {
+
+    const uint32_t etaStart = patch.iEta * image.retower;
+    const uint32_t phiStart = patch.iPhi * image.retower;
+    const uint32_t etaStop  = etaStart + (config.nEta * image.retower);
+    const uint32_t phiStop  = phiStart + (config.nPhi * image.retower);
+
+    std::array<float, TriggerClusterBuffer::NLayers> fractions = {0., 0., 0.};
+    clusters -> BeginCluster(TriggerClusterMakerDefs::Source::FromPatch, image.cal);
+    for (uint32_t iEta = etaStart; iEta < etaStop; ++iEta) {
+      for (uint32_t iPhi = phiStart; iPhi < phiStop; ++iPhi) {
+        const uint32_t index = (iEta * nPhi) + (iPhi % nPhi);
+        clusters -> AddTower(offset + index, combined[index]);
+        for (uint32_t iCal = 0; iCal < layers.size(); ++iCal) {
+          fractions[iCal] += layers[iCal][index];
+        }
+      }
+    }  // end cell loops
+
+    // convert layer energies to fractions
+    for (float& fraction : fractions) {
+      fraction = (patch.energy != 0.) ? fraction / patch.energy : 0.;
+    }
+    clusters -> EndCluster(patch.energy, fractions);
+
+  }  // end patch loop
+  return;
+
+}  // end 'AddCombinedPatchesToClusters(TriggerClusterPatchConfig&, PatchImage&, TriggerClusterBuffer*)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Build clusters from the queued primitives across the workers
+// ----------------------------------------------------------------------------
+/*! Each worker fills its own buffer of clusters from a
+ *  contiguous block of primitives. Buffers are then appended
+ *  in worker order, so the output is identical to serial
+ *  processing regardless of the no. of threads.
+ *
+ *  If caching sums, every sum used by the queued primitives
+ *  is first expanded exactly once into shared arrays (see
+ *  ExpandSharedSums()), and workers only copy towers from
+ *  there. So sums are reused across workers just as they
+ *  are when processing serially, and the cache counters are
+ *  the same either way. Workers otherwise only read the sum
+ *  table and tower grids.
+ */
+void TriggerClusterEngine::ProcessPrimitivesInParallel() {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterEngine::ProcessPrimitivesInParallel() Processing primitives with " << m_workers.GetNWorkers() << " workers");
+
+  // expand shared sums up front if caching
+  if (m_config.cacheSums) {
+    ExpandSharedSums();
+  }
+
+  // fill clusters on workers
+  TriggerClusterWorkerPool::Task fill = [this](const std::size_t begin, const std::size_t end, const uint32_t iWorker) {
+    TriggerClusterBuffer* clusters = &m_workerClusters[iWorker];
+    for (std::size_t iVisit = begin; iVisit < end; ++iVisit) {
+      const std::size_t iPrim = GetPrimToVisit(iVisit);
+
+      // without cache, expand each primitive directly
+      if (!m_config.cacheSums) {
+        TriggerClusterMakerDefs::DispatchCal(
+          m_primLayers[iPrim],
+          [this, iPrim, clusters](auto layer) {
+            this -> AddPrimitiveToCluster<decltype(layer)::value>(iPrim, clusters, NULL);
+          }
+        );
+        continue;
+      }
+
+      // otherwise copy its sums from the shared arrays
+      clusters -> BeginCluster(TriggerClusterMakerDefs::Source::FromPrimitive, m_primLayers[iPrim]);
+      float energy = 0.;
+      for (uint32_t iSum = m_primOffsets[iPrim]; iSum < m_primOffsets[iPrim + 1]; ++iSum) {
+        const TriggerClusterSumCache::Entry* entry = m_sumCache.Peek(m_primSums[iSum]);
+        if (!entry) continue;
+        clusters -> AddTowers(&m_sharedChannels[entry -> first], &m_sharedEnergies[entry -> first], entry -> size);
+        energy += entry -> energy;
+      }
+      clusters -> EndCluster(energy, m_config.sumAdcs ? m_primAdcs[iPrim] : 0);
+    }
+  };
+  for (TriggerClusterBuffer& clusters : m_workerClusters) {
+    clusters.Reset();
+  }
+  m_workers.Run(GetNPrimsToVisit(), fill);
+
+  // merge worker clusters in order
+  for (const TriggerClusterBuffer& clusters : m_workerClusters) {
+    m_clusters -> Append(clusters);
+  }
+
+  // cache entries point into the shared arrays rather than
+  // m_clusters, so they can't be reused afterwards
+  m_sumCache.Invalidate();
+  return;
+
+}  // end 'ProcessPrimitivesInParallel()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Expand every sum of the queued primitives into shared arrays
+// ----------------------------------------------------------------------------
+/*! Sums are looked up in the sum cache serially, in the same
+ *  order as serial processing would, so hits and misses are
+ *  counted the same way. Each missed sum is given a slot in
+ *  the shared arrays, and the slots are then filled from the
+ *  tower grids across the workers. Each worker only writes
+ *  its own slots and the cache entries of its own sums.
+ */
+void TriggerClusterEngine::ExpandSharedSums() {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterEngine::ExpandSharedSums() Expanding sums of " << GetNPrimsToVisit() << " primitives");
+
+  // assign each sum a slot on first use
+  m_sumCache.Invalidate();
+  m_sharedSums.clear();
+
+  uint32_t nTowers = 0;
+  for (std::size_t iVisit = 0; iVisit < GetNPrimsToVisit(); ++iVisit) {
+    const std::size_t iPrim = GetPrimToVisit(iVisit);
+    for (uint32_t iSum = m_primOffsets[iPrim]; iSum < m_primOffsets[iPrim + 1]; ++iSum) {
+      const uint32_t sumID = m_primSums[iSum];
+      if (m_sumCache.Find(sumID)) continue;
+
+      const TriggerClusterSumTable::Span* span = m_sumTable.GetSpan(sumID);
+      if (!span) continue;
+
+      m_sumCache.Insert(sumID, nTowers, span -> size, 0.);
+      m_sharedSums.push_back(sumID);
+      nTowers += span -> size;
+    }
+  }  // end primitive loop
+  m_sharedChannels.resize(nTowers);
+  m_sharedEnergies.resize(nTowers);
+
+  // then fill slots on workers
+  TriggerClusterWorkerPool::Task expand = [this](const std::size_t begin, const std::size_t end, const uint32_t /*iWorker*/) {
+    for (std::size_t iShared = begin; iShared < end; ++iShared) {
+      const uint32_t                       sumID = m_sharedSums[iShared];
+      const TriggerClusterSumTable::Span*  span  = m_sumTable.GetSpan(sumID);
+      const TriggerClusterSumCache::Entry* entry = m_sumCache.Peek(sumID);
+
+      float sum = 0.;
+      TriggerClusterMakerDefs::DispatchCal(
+        span -> cal,
+        [this, span, entry, &sum](auto layer) {
+          sum = this -> ExpandSum<decltype(layer)::value>(*span, &m_sharedChannels[entry -> first], &m_sharedEnergies[entry -> first]);
+        }
+      );
+      m_sumCache.Insert(sumID, entry -> first, entry -> size, sum);
+    }
+  };
+  m_workers.Run(m_sharedSums.size(), expand);
+  return;
+
+}  // end 'ExpandSharedSums()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Collect the queued primitives with a sum above threshold
+// ----------------------------------------------------------------------------
+/*! The towers of each layer are reduced into primitive sums
+ *  and compared against the threshold in one vectorized pass
+ *  each, giving a bitmap of active sums. Primitives are then
+ *  checked against the bitmap without touching any towers,
+ *  so the cost of building clusters scales with occupancy
+ *  rather than with the no. of primitives.
+ */
+void TriggerClusterEngine::FindActivePrimitives() {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterEngine::FindActivePrimitives() Finding primitives above " << m_config.sparseThreshold << " GeV");
+
+  // mark sums above threshold in each layer
+  const uint32_t nTowInSum = TriggerClusterMakerDefs::NTowInSum();
+  for (uint32_t iCal = 0; iCal < m_towerGrids.size(); ++iCal) {
+    const TriggerClusterTowerGrid& grid = m_towerGrids[iCal];
+
+    m_nActiveBits[iCal] = (grid.nEta / nTowInSum) * (grid.nPhi / nTowInSum);
+    m_sumEnergies.resize(m_nActiveBits[iCal]);
+    m_activeSums[iCal].resize((m_nActiveBits[iCal] + 63) / 64);
+
+    TriggerClusterKernels::BlockSum(grid.energy.data(), grid.nEta, grid.nPhi, nTowInSum, m_sumEnergies.data());
+    TriggerClusterKernels::MaskAbove(m_sumEnergies.data(), m_nActiveBits[iCal], m_config.sparseThreshold, m_activeSums[iCal].data());
+  }
+
+  // then keep primitives with at least one marked sum
+  m_activePrims.clear();
+  for (std::size_t iPrim = 0; iPrim < m_primLayers.size(); ++iPrim) {
+    if (IsPrimitiveActive(iPrim)) {
+      m_activePrims.push_back(iPrim);
+    }
+  }
+  m_nSkippedPrims += m_primLayers.size() - m_activePrims.size();
+
+  // print debug message
+  TRGCLUST_LOG(3, "    Kept " << m_activePrims.size() << " of " << m_primLayers.size() << " primitives");
+  return;
+
+}  // end 'FindActivePrimitives()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Check if a queued primitive has a sum above threshold
+// ----------------------------------------------------------------------------
+/*! Sum IDs outside the primitive sums of their layer (e.g.
+ *  LL1 sums) aren't in the bitmap, so primitives with any
+ *  such sum are always kept.
+ */
+bool TriggerClusterEngine::IsPrimitiveActive(const std::size_t iPrim) const {
+
+  for (uint32_t iSum = m_primOffsets[iPrim]; iSum < m_primOffsets[iPrim + 1]; ++iSum) {
+
+    const uint32_t                      sumID = m_primSums[iSum];
+    const TriggerClusterSumTable::Span* span  = m_sumTable.GetSpan(sumID);
+    if (!span) continue;
+
+    const uint32_t offset = m_sumTable.GetOffset(span -> cal, TriggerClusterMakerDefs::Type::Prim);
+    const uint32_t iBit   = sumID - offset;
+    if ((sumID < offset) || (iBit >= m_nActiveBits[span -> cal])) {
+      return true;
+    }
+    if ((m_activeSums[span -> cal][iBit / 64] >> (iBit % 64)) & 1) {
+      return true;
+    }
+  }  // end sum loop
+  return false;
+
+}  // end 'IsPrimitiveActive(std::size_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Sum the ADCs of every queued primitive
+// ----------------------------------------------------------------------------
+/*! ADCs are transposed into a matrix with one row per sum
+ *  slot (padded with zeros up to the largest primitive) and
+ *  one column per primitive, so that the saturating sums of
+ *  16 primitives at a time are plain vertical adds (see
+ *  TriggerClusterKernels::SaturatingSum()).
+ */
+void TriggerClusterEngine::SumPrimitiveAdcs() {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterEngine::SumPrimitiveAdcs() Summing ADCs of " << m_primLayers.size() << " primitives");
+
+  const uint32_t nPrims = m_primLayers.size();
+
+  uint32_t nSlots = 0;
+  for (uint32_t iPrim = 0; iPrim < nPrims; ++iPrim) {
+    nSlots = std::max(nSlots, m_primOffsets[iPrim + 1] - m_primOffsets[iPrim]);
+  }
+
+  // transpose ADCs
+  m_adcMatrix.assign(static_cast<std::size_t>(nSlots) * nPrims, 0);
+  for (uint32_t iPrim = 0; iPrim < nPrims; ++iPrim) {
+    for (uint32_t iSum = m_primOffsets[iPrim]; iSum < m_primOffsets[iPrim + 1]; ++iSum) {
+      m_adcMatrix[((iSum - m_primOffsets[iPrim]) * nPrims) + iPrim] = m_primSumAdcs[iSum];
+    }
+  }
+
+  // then sum down slots
+  m_primAdcs.resize(nPrims);
+  TriggerClusterKernels::SaturatingSum(m_adcMatrix.data(), nSlots, nPrims, nPrims, m_config.adcMax, m_primAdcs.data());
+  return;
+
+}  // end 'SumPrimitiveAdcs()'
+
+
+
+// private templates ==========================================================
+
+// ----------------------------------------------------------------------------
+//! Build the cluster of a queued primitive
+// ----------------------------------------------------------------------------
+/*! Sums in layer C take the specialized path; sums from any
+ *  other layer (e.g. in combined primitives) are dispatched
+ *  individually. If a cache is given, sums already expanded
+ *  into clusters this event are copied from there instead.
+ */
+template <uint32_t C> void TriggerClusterEngine::AddPrimitiveToCluster(const std::size_t iPrim, TriggerClusterBuffer* clusters, TriggerClusterSumCache* cache) {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterEngine::AddPrimitiveToCluster(std::size_t, TriggerClusterBuffer*, TriggerClusterSumCache*) Making cluster from primitive " << iPrim);
+
+  // loop over sums
+  clusters -> BeginCluster(TriggerClusterMakerDefs::Source::FromPrimitive, C);
+  float energy = 0.;
+  for (uint32_t iSum = m_primOffsets[iPrim]; iSum < m_primOffsets[iPrim + 1]; ++iSum) {
+
+    // reuse sum if already expanded
+    const uint32_t sumID = m_primSums[iSum];
+    if (cache) {
+      const TriggerClusterSumCache::Entry* entry = cache -> Find(sumID);
+      if (entry) {
+        clusters -> CopyTowers(entry -> first, entry -> size);
+        energy += entry -> energy;
+        continue;
+      }
+    }
+
+    // otherwise look up towers in sum
+    const TriggerClusterSumTable::Span* span = m_sumTable.GetSpan(sumID);
+    if (!span) continue;
+
+    // print debug message
+    TRGCLUST_LOG(3, "    Sum ID = " << sumID << ", layer = " << span -> cal << ", no. of towers = " << span -> size);
+
+    // then add towers in sum to cluster
+    const uint32_t first = clusters -> GetNTowers();
+    float          sum   = 0.;
+    if (span -> cal == C) {
+      sum = AddSumToCluster<C>(*span, clusters);
+    } else {
+      TriggerClusterMakerDefs::DispatchCal(
+        span -> cal,
+        [this, span, clusters, &sum](auto layer) {
+          sum = this -> AddSumToCluster<decltype(layer)::value>(*span, clusters);
+        }
+      );
+    }
+    energy += sum;
+
+    // and remember where it went
+    if (cache) {
+      cache -> Insert(sumID, first, clusters -> GetNTowers() - first, sum);
+    }
+  }  // end sum loop
+  clusters -> EndCluster(energy, m_config.sumAdcs ? m_primAdcs[iPrim] : 0);
+  return;
+
+}  // end 'AddPrimitiveToCluster<uint32_t>(std::size_t, TriggerClusterBuffer*, TriggerClusterSumCache*)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Add the towers of a primitive sum to a cluster
+// ----------------------------------------------------------------------------
+/*! The no. of towers in a primitive sum of layer C is a
+ *  compile-time constant, so the tower loop is unrolled for
+ *  spans of that size. Spans of any other size (e.g. LL1
+ *  sums) take a general loop over the span. The energy is
+ *  summed while the towers are added, since a 2x2 sum is
+ *  too short for the vectorized gather to pay off. Returns
+ *  the summed energy.
+ */
+template <uint32_t C> float TriggerClusterEngine::AddSumToCluster(const TriggerClusterSumTable::Span& span, TriggerClusterBuffer* clusters) {
+
+  typedef TriggerClusterMakerDefs::SumTraits<C, TriggerClusterMakerDefs::Type::Prim> Sum;
+
+  // gather towers in sum from snapshot
+  const float*    energies = m_towerGrids[C].energy.data();
+  const uint16_t* chans    = m_gridToChan[C].data();
+  const uint32_t* indices  = m_sumTable.GetTowerIndices() + span.start;
+
+  float sum = 0.;
+  if (span.size == Sum::nTowers) {
+    for (uint32_t iTow = 0; iTow < Sum::nTowers; ++iTow) {
+      const float energy = energies[indices[iTow]];
+      clusters -> AddTower(chans[indices[iTow]], energy);
+      sum += energy;
+    }
+  } else {
+    for (uint32_t iTow = 0; iTow < span.size; ++iTow) {
+      const float energy = energies[indices[iTow]];
+      clusters -> AddTower(chans[indices[iTow]], energy);
+      sum += energy;
+    }
+  }
+  return sum;
+
+}  // end 'AddSumToCluster<uint32_t>(TriggerClusterSumTable::Span&, TriggerClusterBuffer*)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Expand the towers of a primitive sum into plain arrays
+// ----------------------------------------------------------------------------
+/*! Same as AddSumToCluster(), but writes into chans and
+ *  energies (which must have room for span.size towers)
+ *  instead of appending to a buffer, so that sums can be
+ *  expanded concurrently. As there, only primitive-sized
+ *  spans take the unrolled loop. Returns the summed energy.
+ */
+template <uint32_t C> float TriggerClusterEngine::ExpandSum(const TriggerClusterSumTable::Span& span, uint16_t* chans, float* energies) const {
+
+  typedef TriggerClusterMakerDefs::SumTraits<C, TriggerClusterMakerDefs::Type::Prim> Sum;
+
+  const float*    grid     = m_towerGrids[C].energy.data();
+  const uint16_t* channels = m_gridToChan[C].data();
+  const uint32_t* indices  = m_sumTable.GetTowerIndices() + span.start;
+
+  float sum = 0.;
+  if (span.size == Sum::nTowers) {
+    for (uint32_t iTow = 0; iTow < Sum::nTowers; ++iTow) {
+      chans[iTow]     = channels[indices[iTow]];
+      energies[iTow]  = grid[indices[iTow]];
+      sum            += energies[iTow];
+    }
+  } else {
+    for (uint32_t iTow = 0; iTow < span.size; ++iTow) {
+      chans[iTow]     = channels[indices[iTow]];
+      energies[iTow]  = grid[indices[iTow]];
+      sum            += energies[iTow];
+    }
+  }
+  return sum;
+
+}  // end 'ExpandSum<uint32_t>(TriggerClusterSumTable::Span&, uint16_t*, float*)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Build a cluster from the towers under a fired LL1 patch in layer C
+// ----------------------------------------------------------------------------
+/*! The footprint is NTowInLL1 retowers along each side,
+ *  starting at the patch's corner. It's clamped at the edge
+ *  of the layer in eta and wrapped around in phi. If summing
+ *  ADCs, the cluster keeps the patch's peak ADC (so each
+ *  layer's cluster of a combined patch has the full ADC).
+ */
+template <uint32_t C> void TriggerClusterEngine::AddLL1PatchToCluster(const TriggerClusterLL1Decoder::Patch& patch) {
+
+  typedef TriggerClusterMakerDefs::CalTraits<C> Layer;
+
+  // get footprint in towers
+  const uint32_t nTowSide = TriggerClusterMakerDefs::NTowInLL1() * Layer::nRetow;
+  const uint32_t etaStart = patch.iEta * Layer::nRetow;
+  const uint32_t phiStart = patch.iPhi * Layer::nRetow;
+  const uint32_t etaStop  = std::min(etaStart + nTowSide, Layer::nEta);
+  const uint32_t phiStop  = phiStart + nTowSide;
+
+  // add towers from snapshot
+  const TriggerClusterTowerGrid& grid  = m_towerGrids[C];
+  const uint16_t*                chans = m_gridToChan[C].data();
+
+  float energy = 0.;
+  m_clusters -> BeginCluster(TriggerClusterMakerDefs::Source::FromLL1, C);
+  for (uint32_t iEta = etaStart; iEta < etaStop; ++iEta) {
+    for (uint32_t iPhi = phiStart; iPhi < phiStop; ++iPhi) {
+      const uint32_t index = grid.Index(iEta, iPhi % Layer::nPhi);
+      m_clusters -> AddTower(chans[index], grid.energy[index]);
+      energy += grid.energy[index];
+    }
+  }  // end tower loops
+  m_clusters -> EndCluster(energy, m_config.sumAdcs ? std::min<uint32_t>(patch.adc, m_config.adcMax) : 0);
+  return;
+
+}  // end 'AddLL1PatchToCluster<uint32_t>(TriggerClusterLL1Decoder::Patch&)'
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,297 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterEngine.h'
+ *  \authors Derek Anderson
+ *  \date    07.10.2024
+ *
+ *  Framework-free core of the TriggerClusterMaker
+ *  module
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERENGINE_H
+#define TRIGGERCLUSTERENGINE_H
+
+// c++ utilities
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+// module utilities
+#include "TriggerClusterBuffer.h"
+#include "TriggerClusterLL1Decoder.h"
+#include "TriggerClusterLog.h"
+#include "TriggerClusterMakerDefs.h"
+#include "TriggerClusterPatchFinder.h"
+#include "TriggerClusterPyramid.h"
+#include "TriggerClusterSumCache.h"
+#include "TriggerClusterSumTable.h"
+#include "TriggerClusterTowerGrid.h"
+#include "TriggerClusterWorkerPool.h"
+
+
+
+// ----------------------------------------------------------------------------
+//! Options for the trigger cluster engine
+// ----------------------------------------------------------------------------
+struct TriggerClusterEngineConfig {
+
+  // general options
+  //   - debug messages are written if debug is set, up to
+  //     verbosity (see TriggerClusterLog.h)
+  bool    debug     = false;
+  int32_t verbosity = 0;
+
+  // cluster-building options
+  //   - Primitives: one cluster per trigger primitive
+  //   - Patches: one cluster per sliding-window patch
+  //   - Sweep: one set of patch clusters per configuration
+  //     in sweep (see ProcessSweep())
+  uint32_t                               mode  = TriggerClusterMakerDefs::Mode::Primitives;
+  TriggerClusterPatchConfig              patch;
+  std::vector<TriggerClusterPatchConfig> sweep;
+
+  // no. of threads used to process trigger primitives
+  //   - primitives are processed serially when <= 1
+  //   - events with fewer than minParallelPrims primitives
+  //     to visit are always processed serially, since waking
+  //     the workers and merging their clusters costs more
+  //     than it saves on small events (e.g. pp minimum bias)
+  uint32_t nThreads         = 1;
+  uint32_t minParallelPrims = 1024;
+
+  // reuse sums already expanded this event when they show
+  // up again in another primitive (see TriggerClusterSumCache)
+  bool cacheSums = true;
+
+  // sparse processing
+  //   - if set, only primitives with at least one sum above
+  //     sparseThreshold (in GeV, summed from the towers) are
+  //     built; the rest produce no cluster at all
+  bool  sparse          = false;
+  float sparseThreshold = 0.;
+
+  // channel masking
+  //   - if set, towers with any of maskStatusBits in their
+  //     status (see TriggerClusterMakerDefs::Status) or
+  //     listed in maskedChannels[cal] (as channels, see
+  //     MapChannels()) are zeroed as soon as they're set,
+  //     so nothing downstream ever sees their energy
+  //   - off by default, so towers are used as given
+  bool                                 maskChannels   = false;
+  uint8_t                              maskStatusBits = TriggerClusterMakerDefs::BadStatusBits();
+  std::array<std::vector<uint32_t>, 3> maskedChannels;
+
+  // integer (ADC) sums
+  //   - if set, the ADCs given with each primitive's sums
+  //     (see AddPrimitive()) are summed into each cluster
+  //     alongside its energy, as are the ADCs of fired LL1
+  //     patches
+  //   - sums saturate at adcMax, e.g. 0xFF to emulate an
+  //     8-bit firmware adder
+  bool     sumAdcs = false;
+  uint16_t adcMax  = 0xFFFF;
+
+};
+
+
+
+// ----------------------------------------------------------------------------
+//! Builds trigger clusters from plain arrays
+// ----------------------------------------------------------------------------
+/*! All of the cluster building of TriggerClusterMaker, with
+ *  no dependence on Fun4All, the node tree, or the sPHENIX
+ *  tower and trigger classes. Inputs are dense arrays of
+ *  tower energies, LL1 words located on the retower grid,
+ *  and primitives given as lists of sum IDs (see
+ *  TriggerClusterSumTable::GetSumID()); output goes into a
+ *  TriggerClusterBuffer.
+ *
+ *  An event looks like:
+ *
+ *    engine.BeginEvent(&clusters);
+ *    engine.SetTowers(cal, energies, nChannels);  // per layer
+ *    engine.ResetLL1s();                          // per LL1 source
+ *    engine.AddLL1Word(...);
+ *    engine.ProcessLL1s();
+ *    engine.AddPrimitive(layer, sumIDs, nSums);   // per primitive
+ *    engine.ProcessPrimitives();                  // or ProcessPatches(), ProcessSweep()
+ *    engine.EndEvent();
+ *
+ *  Primitives are queued and only built in ProcessPrimitives(),
+ *  so that they can be spread across the workers. Clusters
+ *  come out in the order primitives were added regardless of
+ *  the no. of threads.
+ */
+class TriggerClusterEngine {
+
+  public:
+
+    // ctor/dtor
+    TriggerClusterEngine()  {};
+    ~TriggerClusterEngine() {};
+
+    // setters
+    void SetConfig(const TriggerClusterEngineConfig& config) {m_config = config;}
+    void SetPyramid(TriggerClusterPyramid* pyramid)          {m_pyramid = pyramid; m_isPyramidBuilt = false;}
+
+    // getters
+    TriggerClusterEngineConfig     GetConfig()                          const {return m_config;}
+    int32_t                        Verbosity()                          const {return m_config.verbosity;}
+    uint32_t                       GetNWorkers()                        const {return m_workers.GetNWorkers();}
+    std::size_t                    GetNPrimitives()                     const {return m_primLayers.size();}
+    const TriggerClusterSumTable&  GetSumTable()                        const {return m_sumTable;}
+    const std::vector<uint32_t>&   GetChannelMap(const uint32_t cal)    const {return m_chanToGrid[cal];}
+    const TriggerClusterTowerGrid& GetTowerGrid(const uint32_t cal)     const {return m_towerGrids[cal];}
+    const std::vector<uint64_t>&   GetTowerMask(const uint32_t cal)     const {return m_towerMasks[cal];}
+    TriggerClusterTowerGrid&       GetTowerGrid(const uint32_t cal)           {return m_towerGrids[cal];}
+
+    // setup methods
+    void Init();
+    void End();
+    void MapChannels(const uint32_t cal, const std::vector<uint32_t>& chanToGrid);
+
+    // event methods
+    void BeginEvent(TriggerClusterBuffer* clusters);
+    void SetTowers(const uint32_t cal, const float* energies, const std::size_t nChannels, const uint8_t* statuses = NULL);
+    void MaskTowers(const uint32_t cal);
+    void ResetLL1s();
+    bool AddLL1Word(const uint32_t cal, const uint32_t iEta, const uint32_t iPhi, const unsigned int* samples, const std::size_t nSamples, const uint32_t threshold);
+    void ProcessLL1s();
+    void AddPrimitive(const uint32_t layer, const uint32_t* sumIDs, const std::size_t nSums, const uint16_t* sumAdcs = NULL);
+    void ProcessPrimitives();
+    void ProcessPatches();
+    void ProcessSweep(const std::vector<TriggerClusterBuffer*>& clusters);
+    void EndEvent();
+
+    // shared intermediates
+    const TriggerClusterPyramid& GetPyramid();
+
+    // counters
+    uint64_t GetNSumCacheHits()      const;
+    uint64_t GetNSumCacheMisses()    const;
+    uint64_t GetNSkippedPrimitives() const {return m_nSkippedPrims;}
+    uint32_t GetNMaskedTowers()      const;
+    float    GetMaskedEnergy()       const;
+
+  private:
+
+    // ------------------------------------------------------------------------
+    //! Integral image of a (possibly retowered) layer
+    // ------------------------------------------------------------------------
+    struct PatchImage {
+      uint32_t                  cal     = 0;
+      uint32_t                  retower = 1;
+      TriggerClusterTowerGrid   grid;     // only used when retower > 1
+      TriggerClusterPatchFinder finder;
+    };
+
+    // queued primitives to visit: all of them, or only the
+    // active ones in sparse mode
+    std::size_t GetNPrimsToVisit()                     const {return m_config.sparse ? m_activePrims.size() : m_primLayers.size();}
+    std::size_t GetPrimToVisit(const std::size_t iVisit) const {return m_config.sparse ? m_activePrims[iVisit] : iVisit;}
+
+    // private methods
+    void              ValidatePatchConfig(const TriggerClusterPatchConfig& config) const;
+    void              ProcessPrimitivesInParallel();
+    void              ExpandSharedSums();
+    void              FindActivePrimitives();
+    void              SumPrimitiveAdcs();
+    bool              IsPrimitiveActive(const std::size_t iPrim) const;
+    const PatchImage& GetPatchImage(const uint32_t cal, const uint32_t retower);
+    void              AddPatchesToClusters(const TriggerClusterPatchConfig& config, const PatchImage& image, TriggerClusterBuffer* clusters);
+    void              AddCombinedPatchesToClusters(const TriggerClusterPatchConfig& config, const PatchImage& image, TriggerClusterBuffer* clusters);
+
+    // private templates
+    template <uint32_t C> void  AddPrimitiveToCluster(const std::size_t iPrim, TriggerClusterBuffer* clusters, TriggerClusterSumCache* cache);
+    template <uint32_t C> float AddSumToCluster(const TriggerClusterSumTable::Span& span, TriggerClusterBuffer* clusters);
+    template <uint32_t C> void  AddLL1PatchToCluster(const TriggerClusterLL1Decoder::Patch& patch);
+    template <uint32_t C> float ExpandSum(const TriggerClusterSumTable::Span& span, uint16_t* chans, float* energies) const;
+
+    // clusters of the current event
+    TriggerClusterBuffer* m_clusters = NULL;
+
+    // dense tower snapshots, channel to grid index maps,
+    // and grid index to packed channel maps
+    std::array<TriggerClusterTowerGrid, 3> m_towerGrids;
+    std::array<std::vector<uint32_t>, 3>   m_chanToGrid;
+    std::array<std::vector<uint16_t>, 3>   m_gridToChan;
+
+    // channel masking: masked channels of the run and masked
+    // towers of the current event (both in grid order, 64 per
+    // word), and no. of towers and energy masked this event
+    std::array<std::vector<uint64_t>, 3> m_runMasks;
+    std::array<std::vector<uint64_t>, 3> m_towerMasks;
+    std::array<uint32_t, 3>              m_nMaskedTowers  = {0, 0, 0};
+    std::array<float, 3>                 m_maskedEnergies = {0., 0., 0.};
+
+    // sum to tower lookup
+    TriggerClusterSumTable m_sumTable;
+
+    // queued primitives: flattened sum IDs, offset of each
+    // primitive's first sum, and layer of each primitive
+    std::vector<uint32_t> m_primSums;
+    std::vector<uint32_t> m_primOffsets;
+    std::vector<uint32_t> m_primLayers;
+
+    // integer sums: ADC of each queued sum (parallel to
+    // m_primSums), the same ADCs laid out one row per sum
+    // slot and one column per primitive, and the saturated
+    // ADC sum of each primitive
+    std::vector<uint16_t> m_primSumAdcs;
+    std::vector<uint16_t> m_adcMatrix;
+    std::vector<uint16_t> m_primAdcs;
+
+    // sparse processing: energy of each primitive sum, sums
+    // above threshold as a bitmap and no. of sums per layer,
+    // queued primitives with a sum above threshold, and no.
+    // of primitives skipped so far
+    std::vector<float>                   m_sumEnergies;
+    std::array<std::vector<uint64_t>, 3> m_activeSums;
+    std::array<uint32_t, 3>              m_nActiveBits   = {0, 0, 0};
+    std::vector<uint32_t>                m_activePrims;
+    uint64_t                             m_nSkippedPrims = 0;
+
+    // energy pyramid of the current event
+    //   - built in m_ownPyramid unless SetPyramid() was
+    //     given external storage (e.g. a node)
+    TriggerClusterPyramid  m_ownPyramid;
+    TriggerClusterPyramid* m_pyramid        = NULL;
+    bool                   m_isPyramidBuilt = false;
+
+    // sliding-window patches: integral images shared between
+    // patch configurations, no. of images built this event,
+    // and patches of the current configuration
+    std::vector<PatchImage>                       m_images;
+    std::size_t                                   m_nImages = 0;
+    std::vector<TriggerClusterPatchFinder::Patch> m_patches;
+
+    // LL1 word decoding
+    TriggerClusterLL1Decoder                     m_ll1Decoder;
+    std::vector<TriggerClusterLL1Decoder::Patch> m_ll1Patches;
+
+    // workers and per-worker clusters
+    TriggerClusterWorkerPool          m_workers;
+    std::vector<TriggerClusterBuffer> m_workerClusters;
+
+    // expanded sums of m_clusters (or, when processing in
+    // parallel, of the shared arrays below)
+    TriggerClusterSumCache m_sumCache;
+
+    // sums used by the queued primitives, in order of first
+    // use, and their towers, expanded once and shared by
+    // every worker (see ProcessPrimitivesInParallel())
+    std::vector<uint32_t> m_sharedSums;
+    std::vector<uint16_t> m_sharedChannels;
+    std::vector<float>    m_sharedEnergies;
+
+    // buffered debug messages
+    TriggerClusterLogSink m_log;
+
+    // engine configuration
+    TriggerClusterEngineConfig m_config;
+
+};
+
+#endif
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,438 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterEngineTest.cc'
+ *  \authors Derek Anderson
+ *  \date    07.19.2024
+ *
+ *  Checks that the trigger cluster engine gives
+ *  the same clusters however it's configured to
+ *  build them
+ */
+// ----------------------------------------------------------------------------
+
+#define TRIGGERCLUSTERENGINETEST_CC
+
+// c++ utilities
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+// module utilities
+#include "TriggerClusterBenchGenerator.h"
+#include "TriggerClusterBuffer.h"
+#include "TriggerClusterEngine.h"
+#include "TriggerClusterMakerDefs.h"
+#include "TriggerClusterSumTable.h"
+#include "TriggerClusterWorkerPool.h"
+
+
+
+// test helpers ===============================================================
+
+namespace {
+
+  // no. of events per scenario
+  const uint32_t g_nEvents = 4;
+
+  // no. of failed checks
+  uint32_t g_nFailures = 0;
+
+  // --------------------------------------------------------------------------
+  //! Record a failed check if pass is false
+  // --------------------------------------------------------------------------
+  void Check(const bool pass, const std::string& test, const std::string& what) {
+    if (pass) return;
+    ++g_nFailures;
+    std::cerr << "  FAILED: " << test << ": " << what << std::endl;
+  }
+
+  // --------------------------------------------------------------------------
+  //! Check if two clusters are identical, bit-for-bit
+  // --------------------------------------------------------------------------
+  bool IsSameCluster(const TriggerClusterBuffer& lhs, const std::size_t iLhs, const TriggerClusterBuffer& rhs, const std::size_t iRhs) {
+
+    if ((lhs.GetEnergy(iLhs) != rhs.GetEnergy(iRhs)) ||
+        (lhs.GetSource(iLhs) != rhs.GetSource(iRhs)) ||
+        (lhs.GetLayer(iLhs)  != rhs.GetLayer(iRhs))  ||
+        (lhs.GetAdc(iLhs)    != rhs.GetAdc(iRhs))    ||
+        (lhs.GetNTowers(iLhs) != rhs.GetNTowers(iRhs))) {
+      return false;
+    }
+    for (uint32_t iTow = 0; iTow < lhs.GetNTowers(iLhs); ++iTow) {
+      if ((lhs.GetChannels(iLhs)[iTow] != rhs.GetChannels(iRhs)[iTow]) ||
+          (lhs.GetEnergies(iLhs)[iTow] != rhs.GetEnergies(iRhs)[iTow])) {
+        return false;
+      }
+    }
+    return true;
+
+  }  // end 'IsSameCluster(TriggerClusterBuffer&, std::size_t, TriggerClusterBuffer&, std::size_t)'
+
+  // --------------------------------------------------------------------------
+  //! Check if two buffers hold identical clusters in the same order
+  // --------------------------------------------------------------------------
+  bool IsSame(const TriggerClusterBuffer& lhs, const TriggerClusterBuffer& rhs) {
+
+    if (lhs.GetNClusters() != rhs.GetNClusters()) return false;
+    for (std::size_t iClust = 0; iClust < lhs.GetNClusters(); ++iClust) {
+      if (!IsSameCluster(lhs, iClust, rhs, iClust)) return false;
+    }
+    return true;
+
+  }  // end 'IsSame(TriggerClusterBuffer&, TriggerClusterBuffer&)'
+
+  // --------------------------------------------------------------------------
+  //! Check if the clusters of subset appear in set, in order
+  // --------------------------------------------------------------------------
+  bool IsOrderedSubset(const TriggerClusterBuffer& subset, const TriggerClusterBuffer& set) {
+
+    std::size_t iSet = 0;
+    for (std::size_t iSub = 0; iSub < subset.GetNClusters(); ++iSub) {
+      while ((iSet < set.GetNClusters()) && !IsSameCluster(subset, iSub, set, iSet)) {
+        ++iSet;
+      }
+      if (iSet == set.GetNClusters()) return false;
+      ++iSet;
+    }
+    return true;
+
+  }  // end 'IsOrderedSubset(TriggerClusterBuffer&, TriggerClusterBuffer&)'
+
+  // --------------------------------------------------------------------------
+  //! Build clusters from every event with a given configuration
+  // --------------------------------------------------------------------------
+  /*! Returns the no. of primitives skipped in sparse mode.
+   */
+  uint64_t RunEvents(
+    const TriggerClusterEngineConfig& config,
+    const std::vector<TriggerClusterBenchEvent>& events,
+    std::vector<TriggerClusterBuffer>& outputs
+  ) {
+
+    TriggerClusterEngine engine;
+    engine.SetConfig(config);
+    engine.Init();
+
+    const uint32_t threshold = 5. * TriggerClusterBenchGenerator::AdcPerGeV;
+
+    outputs.assign(events.size(), TriggerClusterBuffer());
+    for (std::size_t iEvt = 0; iEvt < events.size(); ++iEvt) {
+      const TriggerClusterBenchEvent& event = events[iEvt];
+
+      engine.BeginEvent(&outputs[iEvt]);
+      for (uint32_t iCal = 0; iCal < 3; ++iCal) {
+        engine.SetTowers(iCal, event.energies[iCal].data(), event.energies[iCal].size());
+      }
+
+      engine.ResetLL1s();
+      for (const TriggerClusterBenchWord& word : event.words) {
+        engine.AddLL1Word(word.cal, word.iEta, word.iPhi, word.samples.data(), word.samples.size(), threshold);
+      }
+      engine.ProcessLL1s();
+
+      for (const TriggerClusterBenchPrimitive& primitive : event.primitives) {
+        engine.AddPrimitive(primitive.layer, primitive.sums.data(), primitive.sums.size());
+      }
+      engine.ProcessPrimitives();
+      engine.EndEvent();
+    }
+    engine.End();
+    return engine.GetNSkippedPrimitives();
+
+  }  // end 'RunEvents(...)'
+
+}  // end anonymous namespace
+
+
+
+// engine tests ===============================================================
+
+// ----------------------------------------------------------------------------
+//! Any no. of threads, with or without the sum cache, gives the same clusters
+// ----------------------------------------------------------------------------
+void TestProcessing(const std::string& scenario, const std::vector<TriggerClusterBenchEvent>& events) {
+
+  // serial with cache as reference
+  TriggerClusterEngineConfig        reference;
+  std::vector<TriggerClusterBuffer> expect;
+  RunEvents(reference, events, expect);
+
+  for (const uint32_t nThreads : {1U, 2U, 3U}) {
+    for (const bool cacheSums : {true, false}) {
+      TriggerClusterEngineConfig config;
+      config.nThreads         = nThreads;
+      config.minParallelPrims = 0;
+      config.cacheSums        = cacheSums;
+
+      std::vector<TriggerClusterBuffer> outputs;
+      RunEvents(config, events, outputs);
+      for (std::size_t iEvt = 0; iEvt < events.size(); ++iEvt) {
+        Check(
+          IsSame(outputs[iEvt], expect[iEvt]),
+          "Processing",
+          scenario + ", event " + std::to_string(iEvt) + ", " + std::to_string(nThreads) + " thread(s), cache " + (cacheSums ? "on" : "off")
+        );
+      }
+    }
+  }
+  return;
+
+}  // end 'TestProcessing(std::string&, std::vector<TriggerClusterBenchEvent>&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Sparse mode keeps an ordered subset of the dense clusters
+// ----------------------------------------------------------------------------
+/*! Exactly as many clusters as primitives skipped should be
+ *  missing, and the rest must be identical to their dense
+ *  counterparts.
+ */
+void TestSparse(const std::string& scenario, const std::vector<TriggerClusterBenchEvent>& events) {
+
+  TriggerClusterEngineConfig        dense;
+  std::vector<TriggerClusterBuffer> expect;
+  RunEvents(dense, events, expect);
+
+  for (const uint32_t nThreads : {1U, 2U}) {
+    TriggerClusterEngineConfig config;
+    config.nThreads         = nThreads;
+    config.minParallelPrims = 0;
+    config.sparse           = true;
+    config.sparseThreshold  = 1.;
+
+    std::vector<TriggerClusterBuffer> outputs;
+    const uint64_t nSkipped = RunEvents(config, events, outputs);
+
+    uint64_t nMissing = 0;
+    for (std::size_t iEvt = 0; iEvt < events.size(); ++iEvt) {
+      Check(
+        IsOrderedSubset(outputs[iEvt], expect[iEvt]),
+        "Sparse",
+        scenario + ", event " + std::to_string(iEvt) + ", " + std::to_string(nThreads) + " thread(s)"
+      );
+      nMissing += expect[iEvt].GetNClusters() - outputs[iEvt].GetNClusters();
+    }
+    Check(nMissing == nSkipped, "Sparse", scenario + ", " + std::to_string(nMissing) + " clusters missing for " + std::to_string(nSkipped) + " skipped primitives");
+  }
+  return;
+
+}  // end 'TestSparse(std::string&, std::vector<TriggerClusterBenchEvent>&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Primitives may list sums of any size, e.g. LL1 sums
+// ----------------------------------------------------------------------------
+/*! Each primitive mixes primitive sums with EMCal LL1 sums
+ *  (16 towers), HCal LL1 sums (1 tower, including the last
+ *  span of the sum table), and an invalid sum ID. Every
+ *  tower of every valid sum must show up in order, with the
+ *  energy summed sum by sum, however the engine is set up.
+ */
+void TestMixedSums(const TriggerClusterSumTable& table, const TriggerClusterBenchEvent& event) {
+
+  typedef TriggerClusterMakerDefs::SumTraits<TriggerClusterMakerDefs::Cal::OH, TriggerClusterMakerDefs::Type::LL1> OHLL1;
+
+  // build primitives of every layer
+  std::vector<TriggerClusterBenchPrimitive> primitives;
+  for (uint32_t iCal = 0; iCal < 3; ++iCal) {
+    for (uint32_t iPrim = 0; iPrim < 8; ++iPrim) {
+      TriggerClusterBenchPrimitive primitive;
+      primitive.layer = iCal;
+      primitive.sums  = {
+        table.GetSumID(iCal, TriggerClusterMakerDefs::Type::Prim, iPrim, iPrim),
+        table.GetSumID(TriggerClusterMakerDefs::Cal::EM, TriggerClusterMakerDefs::Type::LL1, iPrim, 2 * iPrim),
+        table.GetSumID(TriggerClusterMakerDefs::Cal::IH, TriggerClusterMakerDefs::Type::LL1, iPrim, iPrim + 1),
+        table.GetSumID(TriggerClusterMakerDefs::Cal::OH, TriggerClusterMakerDefs::Type::LL1, OHLL1::nSumEta - 1, OHLL1::nSumPhi - 1),
+        table.GetSumID(iCal, TriggerClusterMakerDefs::Type::Prim, iPrim, iPrim),
+        static_cast<uint32_t>(table.GetNSpans())
+      };
+      primitives.push_back(primitive);
+    }
+  }
+  Check(
+    table.GetSumID(TriggerClusterMakerDefs::Cal::OH, TriggerClusterMakerDefs::Type::LL1, OHLL1::nSumEta - 1, OHLL1::nSumPhi - 1) == static_cast<uint32_t>(table.GetNSpans() - 1),
+    "MixedSums",
+    "last outer HCal LL1 sum isn't the last span"
+  );
+
+  // expected clusters, expanded straight from the sum table
+  TriggerClusterBuffer expect;
+  expect.Reset();
+  for (const TriggerClusterBenchPrimitive& primitive : primitives) {
+    expect.BeginCluster(TriggerClusterMakerDefs::Source::FromPrimitive, primitive.layer);
+    float energy = 0.;
+    for (const uint32_t sumID : primitive.sums) {
+      const TriggerClusterSumTable::Span* span = table.GetSpan(sumID);
+      if (!span) continue;
+
+      float sum = 0.;
+      for (uint32_t iTow = 0; iTow < span -> size; ++iTow) {
+        const uint32_t index = table.GetTowerIndices()[span -> start + iTow];
+        expect.AddTower(TriggerClusterBuffer::GetChannelOffset(span -> cal) + index, event.energies[span -> cal][index]);
+        sum += event.energies[span -> cal][index];
+      }
+      energy += sum;
+    }
+    expect.EndCluster(energy);
+  }
+
+  // then check every way of building them
+  TriggerClusterBenchEvent mixed = event;
+  mixed.words.clear();
+  mixed.primitives = primitives;
+
+  for (const uint32_t nThreads : {1U, 2U, 3U}) {
+    for (const bool cacheSums : {true, false}) {
+      TriggerClusterEngineConfig config;
+      config.nThreads         = nThreads;
+      config.minParallelPrims = 0;
+      config.cacheSums        = cacheSums;
+
+      std::vector<TriggerClusterBuffer> outputs;
+      RunEvents(config, {mixed}, outputs);
+      Check(
+        IsSame(outputs[0], expect),
+        "MixedSums",
+        std::to_string(nThreads) + " thread(s), cache " + (cacheSums ? "on" : "off")
+      );
+    }
+  }
+  return;
+
+}  // end 'TestMixedSums(TriggerClusterSumTable&, TriggerClusterBenchEvent&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Fractions and ADCs read back the same however they're stored
+// ----------------------------------------------------------------------------
+/*! Single-layer clusters store no fractions, and buffers
+ *  store no ADCs until one is nonzero, so check both
+ *  directly and after appending buffers with and without
+ *  them.
+ */
+void TestBuffer() {
+
+  const std::array<float, TriggerClusterBuffer::NLayers> split = {0.5, 0.25, 0.25};
+
+  // ohcal cluster without ADC, then a combined-grid cluster
+  TriggerClusterBuffer first;
+  first.BeginCluster(TriggerClusterMakerDefs::Source::FromPrimitive, TriggerClusterMakerDefs::Cal::OH);
+  first.AddTower(TriggerClusterBuffer::GetChannelOffset(TriggerClusterMakerDefs::Cal::OH), 1.);
+  first.EndCluster(1.);
+  first.BeginCluster(TriggerClusterMakerDefs::Source::FromLL1, TriggerClusterBuffer::AllLayers);
+  first.AddTower(TriggerClusterBuffer::GetChannelOffset(TriggerClusterBuffer::AllLayers), 2.);
+  first.EndCluster(2., split);
+
+  // emcal cluster with an ADC
+  TriggerClusterBuffer second;
+  second.BeginCluster(TriggerClusterMakerDefs::Source::FromPrimitive, TriggerClusterMakerDefs::Cal::EM);
+  second.AddTower(0, 3.);
+  second.EndCluster(3., 30);
+
+  TriggerClusterBuffer merged;
+  merged.Append(first);
+  merged.Append(second);
+  merged.Append(first);
+
+  const std::vector<uint16_t> adcs   = {0, 0, 30, 0, 0};
+  const std::vector<uint32_t> layers = {
+    TriggerClusterMakerDefs::Cal::OH,
+    TriggerClusterBuffer::AllLayers,
+    TriggerClusterMakerDefs::Cal::EM,
+    TriggerClusterMakerDefs::Cal::OH,
+    TriggerClusterBuffer::AllLayers
+  };
+  Check(merged.GetNClusters() == layers.size(), "Buffer", "no. of appended clusters");
+  for (std::size_t iClust = 0; iClust < merged.GetNClusters(); ++iClust) {
+    Check(merged.GetAdc(iClust) == adcs[iClust], "Buffer", "ADC of cluster " + std::to_string(iClust));
+    for (uint32_t iCal = 0; iCal < TriggerClusterBuffer::NLayers; ++iCal) {
+      const float fraction = (layers[iClust] == TriggerClusterBuffer::AllLayers) ? split[iCal] : ((layers[iClust] == iCal) ? 1. : 0.);
+      Check(merged.GetFraction(iClust, iCal) == fraction, "Buffer", "fraction of cluster " + std::to_string(iClust));
+    }
+  }
+  Check(first.GetAdc(1) == 0, "Buffer", "ADC of buffer without ADCs");
+  return;
+
+}  // end 'TestBuffer()'
+
+
+
+// ----------------------------------------------------------------------------
+//! A restarted worker pool only runs the jobs it's given
+// ----------------------------------------------------------------------------
+/*! Every item of every job should be visited exactly once,
+ *  including when the pool is restarted with a different
+ *  no. of workers after it has already run jobs.
+ */
+void TestWorkerPool() {
+
+  const std::size_t nItems = 100;
+
+  TriggerClusterWorkerPool pool;
+  for (const uint32_t nWorkers : {2U, 3U, 1U, 4U}) {
+    pool.Start(nWorkers);
+
+    // give new workers a chance to wake up before the first job
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    for (uint32_t iJob = 0; iJob < 3; ++iJob) {
+      std::vector<uint32_t> nVisits(nItems, 0);
+      pool.Run(nItems, [&nVisits](const std::size_t begin, const std::size_t end, const uint32_t) {
+        for (std::size_t iItem = begin; iItem < end; ++iItem) {
+          ++nVisits[iItem];
+        }
+      });
+      Check(
+        nVisits == std::vector<uint32_t>(nItems, 1),
+        "WorkerPool",
+        std::to_string(nWorkers) + " worker(s), job " + std::to_string(iJob)
+      );
+    }
+  }
+  pool.Stop();
+  return;
+
+}  // end 'TestWorkerPool()'
+
+
+
+// main =======================================================================
+
+// ----------------------------------------------------------------------------
+//! Run every engine test on every scenario, returning nonzero on any failure
+// ----------------------------------------------------------------------------
+int main() {
+
+  TestBuffer();
+  TestWorkerPool();
+
+  TriggerClusterSumTable table;
+  table.Build();
+
+  for (const TriggerClusterBenchScenario& scenario : TriggerClusterBenchGenerator::GetScenarios()) {
+
+    TriggerClusterBenchGenerator          generator(table, 12345);
+    std::vector<TriggerClusterBenchEvent> events(g_nEvents);
+    for (TriggerClusterBenchEvent& event : events) {
+      generator.Generate(scenario, event);
+    }
+
+    TestProcessing(scenario.name, events);
+    TestSparse(scenario.name, events);
+    TestMixedSums(table, events[0]);
+  }
+
+  if (g_nFailures > 0) {
+    std::cerr << "TriggerClusterEngineTest: " << g_nFailures << " check(s) failed!" << std::endl;
+    return 1;
+  }
+  std::cout << "TriggerClusterEngineTest: all checks passed" << std::endl;
+  return 0;
+
+}  // end 'main()'
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,303 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterInstrument.cc'
+ *  \authors Derek Anderson
+ *  \date    07.05.2024
+ *
+ *  Per-stage timing and counters for the
+ *  TriggerClusterMaker module
+ */
+// ----------------------------------------------------------------------------
+
+#define TRIGGERCLUSTERINSTRUMENT_CC
+
+// c++ utilities
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <vector>
+// root libraries
+#include <TFile.h>
+#include <TH1.h>
+
+// class definition
+#include "TriggerClusterInstrument.h"
+
+
+
+// TriggerClusterLatencyHistogram =============================================
+
+// ----------------------------------------------------------------------------
+//! Clear histogram
+// ----------------------------------------------------------------------------
+void TriggerClusterLatencyHistogram::Reset() {
+
+  m_buckets.fill(0);
+  m_count = 0;
+  m_sum   = 0;
+  m_min   = std::numeric_limits<uint64_t>::max();
+  m_max   = 0;
+  return;
+
+}  // end 'Reset()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Add a duration
+// ----------------------------------------------------------------------------
+void TriggerClusterLatencyHistogram::Add(const uint64_t ns) {
+
+  // bucket is index of highest set bit
+  const uint32_t iBkt = (NBuckets - 1) - __builtin_clzll(ns | 1);
+
+  ++m_buckets[iBkt];
+  ++m_count;
+  m_sum += ns;
+  m_min  = std::min(m_min, ns);
+  m_max  = std::max(m_max, ns);
+  return;
+
+}  // end 'Add(uint64_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Estimate a percentile (fraction in [0, 1]) in ns
+// ----------------------------------------------------------------------------
+double TriggerClusterLatencyHistogram::GetPercentile(const double fraction) const {
+
+  if (m_count == 0) return 0.;
+
+  // find bucket containing target rank
+  const double target = std::clamp(fraction, 0., 1.) * m_count;
+  uint64_t     below  = 0;
+  for (uint32_t iBkt = 0; iBkt < NBuckets; ++iBkt) {
+    if ((below + m_buckets[iBkt]) < target) {
+      below += m_buckets[iBkt];
+      continue;
+    }
+
+    // interpolate within bucket and clamp to observed range
+    const double lo    = (iBkt == 0) ? 0. : std::ldexp(1., iBkt);
+    const double hi    = std::ldexp(1., iBkt + 1);
+    const double frac  = (m_buckets[iBkt] > 0) ? (target - below) / m_buckets[iBkt] : 0.;
+    const double value = lo + (frac * (hi - lo));
+    return std::clamp(value, (double) m_min, (double) m_max);
+  }
+  return m_max;
+
+}  // end 'GetPercentile(double)'
+
+
+
+// TriggerClusterInstrument ===================================================
+
+// ----------------------------------------------------------------------------
+//! Clear all histograms and counters
+// ----------------------------------------------------------------------------
+void TriggerClusterInstrument::Reset() {
+
+  for (TriggerClusterLatencyHistogram& hist : m_hists) {
+    hist.Reset();
+  }
+  m_counters.fill(0);
+  return;
+
+}  // end 'Reset()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Print summary table
+// ----------------------------------------------------------------------------
+void TriggerClusterInstrument::Report(std::ostream& os) const {
+
+  const uint64_t nEvents = std::max<uint64_t>(m_hists[Stage::Event].GetCount(), 1);
+
+  os << "TriggerClusterMaker timing summary (us):\n"
+     << std::setw(12) << "stage"
+     << std::setw(10) << "calls"
+     << std::setw(12) << "mean"
+     << std::setw(12) << "p50"
+     << std::setw(12) << "p90"
+     << std::setw(12) << "p99"
+     << std::setw(12) << "max"
+     << std::setw(14) << "total"
+     << "\n";
+  for (uint32_t stage = 0; stage < NStages; ++stage) {
+    const TriggerClusterLatencyHistogram& hist = m_hists[stage];
+    if (hist.GetCount() == 0) continue;
+    os << std::setw(12) << GetStageName(stage)
+       << std::setw(10) << hist.GetCount()
+       << std::fixed << std::setprecision(2)
+       << std::setw(12) << hist.GetMean() / 1e3
+       << std::setw(12) << hist.GetPercentile(0.50) / 1e3
+       << std::setw(12) << hist.GetPercentile(0.90) / 1e3
+       << std::setw(12) << hist.GetPercentile(0.99) / 1e3
+       << std::setw(12) << hist.GetMax() / 1e3
+       << std::setw(14) << hist.GetSum() / 1e3
+       << "\n";
+  }
+
+  os << "TriggerClusterMaker counters (total, per event):\n";
+  for (uint32_t counter = 0; counter < NCounters; ++counter) {
+    os << std::setw(16) << GetCounterName(counter)
+       << std::setw(14) << m_counters[counter]
+       << std::setw(14) << std::setprecision(2) << (double) m_counters[counter] / nEvents
+       << "\n";
+  }
+  os << std::defaultfloat << std::flush;
+  return;
+
+}  // end 'Report(std::ostream&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Write histograms and counters to a JSON file
+// ----------------------------------------------------------------------------
+void TriggerClusterInstrument::WriteJSON(const std::string& path) const {
+
+  std::ofstream out(path);
+  if (!out) {
+    std::cerr << "TriggerClusterInstrument::WriteJSON(std::string&) WARNING: couldn't open '" << path << "'" << std::endl;
+    return;
+  }
+
+  out << "{\n  \"stages\": {\n";
+  for (uint32_t stage = 0; stage < NStages; ++stage) {
+    const TriggerClusterLatencyHistogram& hist = m_hists[stage];
+    out << "    \"" << GetStageName(stage) << "\": {"
+        << "\"count\": "  << hist.GetCount()
+        << ", \"sum_ns\": " << hist.GetSum()
+        << ", \"min_ns\": " << ((hist.GetCount() > 0) ? hist.GetMin() : 0)
+        << ", \"max_ns\": " << hist.GetMax()
+        << ", \"p50_ns\": " << hist.GetPercentile(0.50)
+        << ", \"p90_ns\": " << hist.GetPercentile(0.90)
+        << ", \"p99_ns\": " << hist.GetPercentile(0.99)
+        << ", \"log2_buckets\": [";
+    for (uint32_t iBkt = 0; iBkt < TriggerClusterLatencyHistogram::NBuckets; ++iBkt) {
+      out << ((iBkt > 0) ? ", " : "") << hist.GetBucket(iBkt);
+    }
+    out << "]}" << (((stage + 1) < NStages) ? "," : "") << "\n";
+  }
+  out << "  },\n  \"counters\": {\n";
+  for (uint32_t counter = 0; counter < NCounters; ++counter) {
+    out << "    \"" << GetCounterName(counter) << "\": " << m_counters[counter]
+        << (((counter + 1) < NCounters) ? "," : "") << "\n";
+  }
+  out << "  }\n}\n";
+  return;
+
+}  // end 'WriteJSON(std::string&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Write histograms and counters to a ROOT file
+// ----------------------------------------------------------------------------
+/*! Each stage gets a histogram with log2-spaced bins in ns,
+ *  and counters are stored as labeled bins of one histogram.
+ */
+void TriggerClusterInstrument::WriteROOT(const std::string& path) const {
+
+  TFile file(path.data(), "recreate");
+  if (file.IsZombie()) {
+    std::cerr << "TriggerClusterInstrument::WriteROOT(std::string&) WARNING: couldn't open '" << path << "'" << std::endl;
+    return;
+  }
+  file.cd();
+
+  // bin edges: 0, 2, 4, ..., 2^NBuckets
+  std::vector<double> edges(TriggerClusterLatencyHistogram::NBuckets + 1, 0.);
+  for (uint32_t iEdge = 1; iEdge < edges.size(); ++iEdge) {
+    edges[iEdge] = std::ldexp(1., iEdge);
+  }
+
+  for (uint32_t stage = 0; stage < NStages; ++stage) {
+    const std::string name = "hLatency_" + GetStageName(stage);
+    TH1D hist(name.data(), (GetStageName(stage) + ";t [ns];calls").data(), TriggerClusterLatencyHistogram::NBuckets, edges.data());
+    for (uint32_t iBkt = 0; iBkt < TriggerClusterLatencyHistogram::NBuckets; ++iBkt) {
+      hist.SetBinContent(iBkt + 1, m_hists[stage].GetBucket(iBkt));
+    }
+    hist.SetEntries(m_hists[stage].GetCount());
+    hist.Write();
+  }
+
+  TH1D counters("hCounters", "Counters", NCounters, 0., NCounters);
+  for (uint32_t counter = 0; counter < NCounters; ++counter) {
+    counters.GetXaxis() -> SetBinLabel(counter + 1, GetCounterName(counter).data());
+    counters.SetBinContent(counter + 1, m_counters[counter]);
+  }
+  counters.Write();
+  file.Close();
+  return;
+
+}  // end 'WriteROOT(std::string&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Write to a ROOT file if path ends in '.root', otherwise JSON
+// ----------------------------------------------------------------------------
+void TriggerClusterInstrument::Write(const std::string& path) const {
+
+  const std::string ext = ".root";
+  const bool isRoot = (path.size() >= ext.size()) && (path.compare(path.size() - ext.size(), ext.size(), ext) == 0);
+  if (isRoot) {
+    WriteROOT(path);
+  } else {
+    WriteJSON(path);
+  }
+  return;
+
+}  // end 'Write(std::string&)'
+
+
+
+// static methods =============================================================
+
+// ----------------------------------------------------------------------------
+//! Get name of a stage
+// ----------------------------------------------------------------------------
+std::string TriggerClusterInstrument::GetStageName(const uint32_t stage) {
+
+  static const std::array<std::string, NStages> names = {
+    "Event",
+    "GrabNodes",
+    "TowerLookup",
+    "LL1s",
+    "Primitives",
+    "Patches",
+    "Insertion",
+    "Prefilter"
+  };
+  return (stage < NStages) ? names[stage] : "Unknown";
+
+}  // end 'GetStageName(uint32_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Get name of a counter
+// ----------------------------------------------------------------------------
+std::string TriggerClusterInstrument::GetCounterName(const uint32_t counter) {
+
+  static const std::array<std::string, NCounters> names = {
+    "PrimitivesSeen",
+    "TowersAdded",
+    "ClustersEmitted",
+    "SumCacheHits",
+    "SumCacheMisses",
+    "PrimitivesSkipped",
+    "TowersMasked",
+    "EventsAccepted",
+    "EventsRejected"
+  };
+  return (counter < NCounters) ? names[counter] : "Unknown";
+
+}  // end 'GetCounterName(uint32_t)'
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,178 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterInstrument.h'
+ *  \authors Derek Anderson
+ *  \date    07.05.2024
+ *
+ *  Per-stage timing and counters for the
+ *  TriggerClusterMaker module
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERINSTRUMENT_H
+#define TRIGGERCLUSTERINSTRUMENT_H
+
+// c++ utilities
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+
+
+// ----------------------------------------------------------------------------
+//! Instrumentation macros
+// ----------------------------------------------------------------------------
+/*! Everything below is only compiled into the module when
+ *  TRIGGERCLUSTER_INSTRUMENT is defined (configure with
+ *  --enable-instrument); otherwise these expand to nothing.
+ */
+#ifdef TRIGGERCLUSTER_INSTRUMENT
+  #define TRGCLUST_CONCAT_IMPL(a, b) a##b
+  #define TRGCLUST_CONCAT(a, b)      TRGCLUST_CONCAT_IMPL(a, b)
+  #define TRGCLUST_TIME(inst, stage) TriggerClusterScopedTimer TRGCLUST_CONCAT(trgClustTimer, __LINE__)((inst).GetHistogram(stage))
+  #define TRGCLUST_COUNT(inst, counter, n) (inst).Count((counter), (n))
+#else
+  #define TRGCLUST_TIME(inst, stage)
+  #define TRGCLUST_COUNT(inst, counter, n)
+#endif
+
+
+
+// ----------------------------------------------------------------------------
+//! Fixed-bucket latency histogram
+// ----------------------------------------------------------------------------
+/*! Bucket b holds durations in [2^b, 2^(b+1)) ns, so adding a
+ *  sample is a count-leading-zeros and an increment, and the
+ *  histogram never allocates. Percentiles are interpolated
+ *  within a bucket and so are accurate to within a factor of
+ *  two of the bucket width.
+ */
+class TriggerClusterLatencyHistogram {
+
+  public:
+
+    // no. of buckets
+    static constexpr uint32_t NBuckets = 64;
+
+    // ctor/dtor
+    TriggerClusterLatencyHistogram()  {Reset();};
+    ~TriggerClusterLatencyHistogram() {};
+
+    // public methods
+    void   Reset();
+    void   Add(const uint64_t ns);
+    double GetPercentile(const double fraction) const;
+
+    // getters
+    uint64_t GetCount()                     const {return m_count;}
+    uint64_t GetSum()                       const {return m_sum;}
+    uint64_t GetMin()                       const {return m_min;}
+    uint64_t GetMax()                       const {return m_max;}
+    uint64_t GetBucket(const uint32_t iBkt) const {return m_buckets[iBkt];}
+    double   GetMean()                      const {return (m_count > 0) ? (double) m_sum / (double) m_count : 0.;}
+
+  private:
+
+    // buckets and summary statistics
+    std::array<uint64_t, NBuckets> m_buckets;
+    uint64_t                       m_count;
+    uint64_t                       m_sum;
+    uint64_t                       m_min;
+    uint64_t                       m_max;
+
+};
+
+
+
+// ----------------------------------------------------------------------------
+//! Records the lifetime of a scope into a histogram
+// ----------------------------------------------------------------------------
+class TriggerClusterScopedTimer {
+
+  public:
+
+    // ctor/dtor
+    TriggerClusterScopedTimer(TriggerClusterLatencyHistogram& hist) : m_hist(hist), m_start(std::chrono::steady_clock::now()) {};
+    ~TriggerClusterScopedTimer() {
+      m_hist.Add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count()
+      );
+    };
+
+  private:
+
+    TriggerClusterLatencyHistogram&       m_hist;
+    std::chrono::steady_clock::time_point m_start;
+
+};
+
+
+
+// ----------------------------------------------------------------------------
+//! Per-stage latency histograms and counters
+// ----------------------------------------------------------------------------
+class TriggerClusterInstrument {
+
+  public:
+
+    // timed stages
+    enum Stage {
+      Event,
+      GrabNodes,
+      TowerLookup,
+      LL1s,
+      Primitives,
+      Patches,
+      Insertion,
+      Prefilter,
+      NStages
+    };
+
+    // counters
+    enum Counter {
+      PrimitivesSeen,
+      TowersAdded,
+      ClustersEmitted,
+      SumCacheHits,
+      SumCacheMisses,
+      PrimitivesSkipped,
+      TowersMasked,
+      EventsAccepted,
+      EventsRejected,
+      NCounters
+    };
+
+    // ctor/dtor
+    TriggerClusterInstrument()  {Reset();};
+    ~TriggerClusterInstrument() {};
+
+    // public methods
+    void Reset();
+    void Report(std::ostream& os = std::cout) const;
+    void WriteJSON(const std::string& path) const;
+    void WriteROOT(const std::string& path) const;
+    void Write(const std::string& path) const;
+
+    // inline methods
+    TriggerClusterLatencyHistogram& GetHistogram(const uint32_t stage)              {return m_hists[stage];}
+    void                            Count(const uint32_t counter, const uint64_t n) {m_counters[counter] += n;}
+
+    // getters
+    const TriggerClusterLatencyHistogram& GetHistogram(const uint32_t stage) const {return m_hists[stage];}
+    uint64_t                              GetCounter(const uint32_t counter) const {return m_counters[counter];}
+
+    // static methods
+    static std::string GetStageName(const uint32_t stage);
+    static std::string GetCounterName(const uint32_t counter);
+
+  private:
+
+    std::array<TriggerClusterLatencyHistogram, NStages> m_hists;
+    std::array<uint64_t, NCounters>                     m_counters;
+
+};
+
+#endif
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,358 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterKernelTest.cc'
+ *  \authors Derek Anderson
+ *  \date    07.19.2024
+ *
+ *  Checks every instruction set level of the
+ *  trigger cluster kernels against the scalar
+ *  implementation
+ */
+// ----------------------------------------------------------------------------
+
+#define TRIGGERCLUSTERKERNELTEST_CC
+
+// c++ utilities
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+// module utilities
+#include "TriggerClusterKernels.h"
+
+
+
+// test helpers ===============================================================
+
+namespace {
+
+  // all instruction set levels, narrowest first
+  const std::vector<TriggerClusterKernels::Level> g_levels = {
+    TriggerClusterKernels::Scalar,
+    TriggerClusterKernels::AVX2,
+    TriggerClusterKernels::AVX512
+  };
+
+  // lengths around every vector width and word boundary
+  const std::vector<uint32_t> g_lengths = {
+    0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 128, 129, 1000, 1536, 24576
+  };
+
+  // no. of failed checks
+  uint32_t g_nFailures = 0;
+
+  // --------------------------------------------------------------------------
+  //! Record a failed check if pass is false
+  // --------------------------------------------------------------------------
+  void Check(const bool pass, const std::string& kernel, const TriggerClusterKernels::Level level, const std::string& what) {
+    if (pass) return;
+    ++g_nFailures;
+    std::cerr << "  FAILED: " << kernel << " at level " << level << ": " << what << std::endl;
+  }
+
+  // --------------------------------------------------------------------------
+  //! Check if two floats agree to within float rounding of a sum of n terms
+  // --------------------------------------------------------------------------
+  bool IsClose(const float a, const float b, const float scale, const uint32_t n) {
+    return std::fabs(a - b) <= 1e-6 * (n + 1) * std::max(scale, 1.F);
+  }
+
+  // --------------------------------------------------------------------------
+  //! Fill floats with random energies, with some exact zeros
+  // --------------------------------------------------------------------------
+  void FillEnergies(std::mt19937& rng, std::vector<float>& values) {
+    std::uniform_real_distribution<float> energy(-0.1, 10.);
+    std::bernoulli_distribution           isZero(0.2);
+    for (float& value : values) {
+      value = isZero(rng) ? 0. : energy(rng);
+    }
+  }
+
+}  // end anonymous namespace
+
+
+
+// kernel tests ===============================================================
+
+// ----------------------------------------------------------------------------
+//! Block sums must agree bit-for-bit
+// ----------------------------------------------------------------------------
+void TestBlockSum(std::mt19937& rng) {
+
+  // grids of every layer plus ones which don't divide evenly
+  const std::vector<std::pair<uint32_t, uint32_t>> grids = {
+    {96, 256}, {24, 64}, {12, 32}, {7, 13}, {5, 37}, {33, 66}
+  };
+
+  for (const std::pair<uint32_t, uint32_t>& grid : grids) {
+    std::vector<float> in(grid.first * grid.second);
+    FillEnergies(rng, in);
+
+    for (uint32_t factor = 1; factor <= 5; ++factor) {
+      const std::size_t nOut = (grid.first / factor) * (grid.second / factor);
+
+      TriggerClusterKernels::SetLevel(TriggerClusterKernels::Scalar);
+      std::vector<float> expect(nOut, -1.);
+      TriggerClusterKernels::BlockSum(in.data(), grid.first, grid.second, factor, expect.data());
+
+      for (const TriggerClusterKernels::Level level : g_levels) {
+        TriggerClusterKernels::SetLevel(level);
+        std::vector<float> out(nOut, -1.);
+        TriggerClusterKernels::BlockSum(in.data(), grid.first, grid.second, factor, out.data());
+        Check(out == expect, "BlockSum", TriggerClusterKernels::GetLevel(), std::to_string(grid.first) + " x " + std::to_string(grid.second) + ", factor " + std::to_string(factor));
+      }
+    }
+  }  // end grid loop
+  return;
+
+}  // end 'TestBlockSum(std::mt19937&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Gathered sums must agree to within float rounding
+// ----------------------------------------------------------------------------
+void TestGatherSum(std::mt19937& rng) {
+
+  std::vector<float> in(4096);
+  FillEnergies(rng, in);
+
+  std::uniform_int_distribution<uint32_t> index(0, in.size() - 1);
+  for (const uint32_t length : g_lengths) {
+    if (length > in.size()) continue;
+
+    std::vector<uint32_t> indices(length);
+    for (uint32_t& idx : indices) {
+      idx = index(rng);
+    }
+
+    TriggerClusterKernels::SetLevel(TriggerClusterKernels::Scalar);
+    const float expect = TriggerClusterKernels::GatherSum(in.data(), indices.data(), length);
+
+    for (const TriggerClusterKernels::Level level : g_levels) {
+      TriggerClusterKernels::SetLevel(level);
+      const float sum = TriggerClusterKernels::GatherSum(in.data(), indices.data(), length);
+      Check(IsClose(sum, expect, std::fabs(expect), length), "GatherSum", TriggerClusterKernels::GetLevel(), "length " + std::to_string(length));
+    }
+  }  // end length loop
+  return;
+
+}  // end 'TestGatherSum(std::mt19937&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Threshold masks must agree exactly, including cleared tail bits
+// ----------------------------------------------------------------------------
+void TestMaskAbove(std::mt19937& rng) {
+
+  for (const uint32_t length : g_lengths) {
+    std::vector<float> in(length);
+    FillEnergies(rng, in);
+
+    for (const float threshold : {-1.F, 0.F, 5.F, 100.F}) {
+      const std::size_t nWords = (length + 63) / 64;
+
+      TriggerClusterKernels::SetLevel(TriggerClusterKernels::Scalar);
+      std::vector<uint64_t> expect(nWords, ~uint64_t(0));
+      TriggerClusterKernels::MaskAbove(in.data(), length, threshold, expect.data());
+
+      for (const TriggerClusterKernels::Level level : g_levels) {
+        TriggerClusterKernels::SetLevel(level);
+        std::vector<uint64_t> bits(nWords, ~uint64_t(0));
+        TriggerClusterKernels::MaskAbove(in.data(), length, threshold, bits.data());
+        Check(bits == expect, "MaskAbove", TriggerClusterKernels::GetLevel(), "length " + std::to_string(length) + ", threshold " + std::to_string(threshold));
+      }
+    }
+  }  // end length loop
+  return;
+
+}  // end 'TestMaskAbove(std::mt19937&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Status masks must agree exactly and only ever add bits
+// ----------------------------------------------------------------------------
+void TestMaskStatus(std::mt19937& rng) {
+
+  std::uniform_int_distribution<uint32_t> bit(0, 7);
+  std::bernoulli_distribution             isBad(0.05);
+  std::bernoulli_distribution             isPreset(0.02);
+
+  for (const uint32_t length : g_lengths) {
+    const std::size_t nWords = (length + 63) / 64;
+
+    // random statuses, and all-zero statuses
+    for (const bool allZero : {false, true}) {
+      std::vector<uint8_t> statuses(length, 0);
+      if (!allZero) {
+        for (uint8_t& status : statuses) {
+          status = isBad(rng) ? (1 << bit(rng)) : 0;
+        }
+      }
+
+      // bits already set must survive
+      std::vector<uint64_t> preset(nWords, 0);
+      for (uint32_t iValue = 0; iValue < length; ++iValue) {
+        if (isPreset(rng)) preset[iValue / 64] |= (uint64_t(1) << (iValue % 64));
+      }
+
+      for (const uint8_t statusBits : {uint8_t(0x00), uint8_t(0x1D), uint8_t(0xFF)}) {
+        TriggerClusterKernels::SetLevel(TriggerClusterKernels::Scalar);
+        std::vector<uint64_t> expect = preset;
+        TriggerClusterKernels::MaskStatus(statuses.data(), length, statusBits, expect.data());
+
+        // scalar against a plain reference
+        bool isRight = true;
+        for (uint32_t iValue = 0; iValue < length; ++iValue) {
+          const bool isSet  = (expect[iValue / 64] >> (iValue % 64)) & 1;
+          const bool wasSet = (preset[iValue / 64] >> (iValue % 64)) & 1;
+          isRight &= (isSet == (wasSet || (statuses[iValue] & statusBits)));
+        }
+        Check(isRight, "MaskStatus", TriggerClusterKernels::Scalar, "reference, length " + std::to_string(length));
+
+        for (const TriggerClusterKernels::Level level : g_levels) {
+          TriggerClusterKernels::SetLevel(level);
+          std::vector<uint64_t> bits = preset;
+          TriggerClusterKernels::MaskStatus(statuses.data(), length, statusBits, bits.data());
+          Check(bits == expect, "MaskStatus", TriggerClusterKernels::GetLevel(), "length " + std::to_string(length) + ", bits " + std::to_string(statusBits));
+        }
+      }
+    }
+  }  // end length loop
+  return;
+
+}  // end 'TestMaskStatus(std::mt19937&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Masked values must agree exactly, removed energy to within rounding
+// ----------------------------------------------------------------------------
+void TestZeroMasked(std::mt19937& rng) {
+
+  // sparse masks, empty masks, and full masks
+  const std::vector<double> densities = {0.02, 0., 1.};
+
+  for (const uint32_t length : g_lengths) {
+    const std::size_t nWords = (length + 63) / 64;
+
+    std::vector<float> in(length);
+    FillEnergies(rng, in);
+
+    for (const double density : densities) {
+      std::bernoulli_distribution isMasked(density);
+      std::vector<uint64_t>       bits(nWords, 0);
+      for (uint32_t iValue = 0; iValue < length; ++iValue) {
+        if (isMasked(rng)) bits[iValue / 64] |= (uint64_t(1) << (iValue % 64));
+      }
+
+      // plain reference
+      std::vector<float> reference = in;
+      float              removed   = 0.;
+      for (uint32_t iValue = 0; iValue < length; ++iValue) {
+        if ((bits[iValue / 64] >> (iValue % 64)) & 1) {
+          removed           += reference[iValue];
+          reference[iValue]  = 0.;
+        }
+      }
+
+      for (const TriggerClusterKernels::Level level : g_levels) {
+        TriggerClusterKernels::SetLevel(level);
+        std::vector<float> out = in;
+        const float        sum = TriggerClusterKernels::ZeroMasked(out.data(), length, bits.data());
+
+        const std::string what = "length " + std::to_string(length) + ", density " + std::to_string(density);
+        Check(out == reference, "ZeroMasked (values)", TriggerClusterKernels::GetLevel(), what);
+        Check(IsClose(sum, removed, std::fabs(removed), length), "ZeroMasked (removed)", TriggerClusterKernels::GetLevel(), what);
+      }
+    }
+  }  // end length loop
+  return;
+
+}  // end 'TestZeroMasked(std::mt19937&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Saturating sums must agree exactly with min(sum, max)
+// ----------------------------------------------------------------------------
+void TestSaturatingSum(std::mt19937& rng) {
+
+  // small LUT outputs, and values which overflow 16 bits
+  std::uniform_int_distribution<uint32_t> small(0, 0xFF);
+  std::uniform_int_distribution<uint32_t> large(0x4000, 0xFFFF);
+
+  for (const uint32_t nCols : g_lengths) {
+    if (nCols > 2048) continue;
+    for (const uint32_t nRows : {0U, 1U, 4U, 16U, 17U}) {
+      for (const bool overflow : {false, true}) {
+
+        // pad rows to exercise stride != nCols
+        const uint32_t        stride = nCols + 3;
+        std::vector<uint16_t> in(static_cast<std::size_t>(nRows) * stride);
+        for (uint16_t& adc : in) {
+          adc = overflow ? large(rng) : small(rng);
+        }
+
+        for (const uint16_t max : {uint16_t(0xFF), uint16_t(0x3FF), uint16_t(0xFFFF)}) {
+
+          // plain reference
+          std::vector<uint16_t> reference(nCols);
+          for (uint32_t iCol = 0; iCol < nCols; ++iCol) {
+            uint64_t sum = 0;
+            for (uint32_t iRow = 0; iRow < nRows; ++iRow) {
+              sum += in[(iRow * stride) + iCol];
+            }
+            reference[iCol] = std::min<uint64_t>(sum, max);
+          }
+
+          for (const TriggerClusterKernels::Level level : g_levels) {
+            TriggerClusterKernels::SetLevel(level);
+            std::vector<uint16_t> out(nCols, 0xABCD);
+            TriggerClusterKernels::SaturatingSum(in.data(), nRows, nCols, stride, max, out.data());
+            Check(out == reference, "SaturatingSum", TriggerClusterKernels::GetLevel(), std::to_string(nRows) + " x " + std::to_string(nCols) + ", max " + std::to_string(max) + (overflow ? ", overflowing" : ""));
+          }
+        }
+      }
+    }
+  }  // end column loop
+  return;
+
+}  // end 'TestSaturatingSum(std::mt19937&)'
+
+
+
+// main =======================================================================
+
+// ----------------------------------------------------------------------------
+//! Run every kernel test, returning nonzero on any failure
+// ----------------------------------------------------------------------------
+/*! Levels the CPU doesn't support are clamped by SetLevel(),
+ *  so on such machines they rerun the widest supported one.
+ */
+int main() {
+
+  std::cout << "TriggerClusterKernelTest: best kernel level on this CPU is " << TriggerClusterKernels::GetBestLevel() << std::endl;
+
+  std::mt19937 rng(20240719);
+  TestBlockSum(rng);
+  TestGatherSum(rng);
+  TestMaskAbove(rng);
+  TestMaskStatus(rng);
+  TestZeroMasked(rng);
+  TestSaturatingSum(rng);
+
+  if (g_nFailures > 0) {
+    std::cerr << "TriggerClusterKernelTest: " << g_nFailures << " check(s) failed!" << std::endl;
+    return 1;
+  }
+  std::cout << "TriggerClusterKernelTest: all checks passed" << std::endl;
+  return 0;
+
+}  // end 'main()'
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,673 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterKernels.cc'
+ *  \authors Derek Anderson
+ *  \date    06.19.2024
+ *
+ *  Vectorized summation kernels for the
+ *  TriggerClusterMaker module
+ */
+// ----------------------------------------------------------------------------
+
+#define TRIGGERCLUSTERKERNELS_CC
+
+// c++ utilities
+#include <algorithm>
+#include <vector>
+// intrinsics
+#if defined(__x86_64__)
+  #include <immintrin.h>
+  #define TRIGGERCLUSTERKERNELS_X86
+#endif
+
+// kernel definitions
+#include "TriggerClusterKernels.h"
+
+
+
+// internal helpers ===========================================================
+
+namespace {
+
+  // --------------------------------------------------------------------------
+  //! Currently selected instruction set level
+  // --------------------------------------------------------------------------
+  TriggerClusterKernels::Level& CurrentLevel() {
+    static TriggerClusterKernels::Level level = TriggerClusterKernels::GetBestLevel();
+    return level;
+  }
+
+  // --------------------------------------------------------------------------
+  //! Per-thread scratch row for block sums
+  // --------------------------------------------------------------------------
+  float* ScratchRow(const uint32_t size) {
+    thread_local std::vector<float> scratch;
+    if (scratch.size() < size) {
+      scratch.resize(size);
+    }
+    return scratch.data();
+  }
+
+  // --------------------------------------------------------------------------
+  //! Pairwise sum of adjacent values, i.e. ((x0 + x1) + (x2 + x3))
+  // --------------------------------------------------------------------------
+  float PairwiseSum(const float* in, const uint32_t size) {
+    if (size == 1) return in[0];
+    const uint32_t half = size / 2;
+    return PairwiseSum(in, half) + PairwiseSum(in + half, size - half);
+  }
+
+  // --------------------------------------------------------------------------
+  //! Combine groups of adjacent columns of a row
+  // --------------------------------------------------------------------------
+  void ReduceColumnsScalar(const float* row, const uint32_t nOut, const uint32_t factor, float* out) {
+    for (uint32_t iOut = 0; iOut < nOut; ++iOut) {
+      out[iOut] = PairwiseSum(row + (iOut * factor), factor);
+    }
+  }
+
+  // scalar kernels -----------------------------------------------------------
+
+  void BlockSumScalar(const float* in, const uint32_t nEta, const uint32_t nPhi, const uint32_t factor, float* out) {
+
+    const uint32_t nOutEta = nEta / factor;
+    const uint32_t nOutPhi = nPhi / factor;
+    float*         row     = ScratchRow(nPhi);
+    for (uint32_t iOutEta = 0; iOutEta < nOutEta; ++iOutEta) {
+
+      // sum rows elementwise
+      const float* first = in + (iOutEta * factor * nPhi);
+      std::copy(first, first + nPhi, row);
+      for (uint32_t iRow = 1; iRow < factor; ++iRow) {
+        const float* next = first + (iRow * nPhi);
+        for (uint32_t iPhi = 0; iPhi < nPhi; ++iPhi) {
+          row[iPhi] += next[iPhi];
+        }
+      }
+
+      // then combine columns
+      ReduceColumnsScalar(row, nOutPhi, factor, out + (iOutEta * nOutPhi));
+    }
+    return;
+
+  }  // end 'BlockSumScalar(float*, uint32_t, uint32_t, uint32_t, float*)'
+
+  float GatherSumScalar(const float* in, const uint32_t* indices, const uint32_t nIndices) {
+
+    float sum = 0.;
+    for (uint32_t iIndex = 0; iIndex < nIndices; ++iIndex) {
+      sum += in[indices[iIndex]];
+    }
+    return sum;
+
+  }  // end 'GatherSumScalar(float*, uint32_t*, uint32_t)'
+
+  void MaskAboveScalar(const float* in, const uint32_t nValues, const float threshold, uint64_t* bits) {
+
+    std::fill(bits, bits + ((nValues + 63) / 64), 0);
+    for (uint32_t iValue = 0; iValue < nValues; ++iValue) {
+      if (in[iValue] > threshold) {
+        bits[iValue / 64] |= (uint64_t(1) << (iValue % 64));
+      }
+    }
+    return;
+
+  }  // end 'MaskAboveScalar(float*, uint32_t, float, uint64_t*)'
+
+  void MaskStatusScalar(const uint8_t* statuses, const uint32_t nValues, const uint8_t statusBits, uint64_t* bits) {
+
+    for (uint32_t iValue = 0; iValue < nValues; ++iValue) {
+      if (statuses[iValue] & statusBits) {
+        bits[iValue / 64] |= (uint64_t(1) << (iValue % 64));
+      }
+    }
+    return;
+
+  }  // end 'MaskStatusScalar(uint8_t*, uint32_t, uint8_t, uint64_t*)'
+
+  float ZeroMaskedScalar(float* values, const uint32_t nValues, const uint64_t* bits) {
+
+    // only visit set bits
+    float removed = 0.;
+    for (uint32_t iWord = 0; iWord < ((nValues + 63) / 64); ++iWord) {
+      for (uint64_t word = bits[iWord]; word != 0; word &= (word - 1)) {
+        const uint32_t iValue = (iWord * 64) + __builtin_ctzll(word);
+        if (iValue >= nValues) break;
+        removed        += values[iValue];
+        values[iValue]  = 0.;
+      }
+    }
+    return removed;
+
+  }  // end 'ZeroMaskedScalar(float*, uint32_t, uint64_t*)'
+
+  void SaturatingSumScalar(const uint16_t* in, const uint32_t nRows, const uint32_t nCols, const uint32_t stride, const uint16_t max, uint16_t* out) {
+
+    for (uint32_t iCol = 0; iCol < nCols; ++iCol) {
+      uint32_t sum = 0;
+      for (uint32_t iRow = 0; iRow < nRows; ++iRow) {
+        sum = std::min<uint32_t>(sum + in[(iRow * stride) + iCol], 0xFFFF);
+      }
+      out[iCol] = std::min<uint32_t>(sum, max);
+    }
+    return;
+
+  }  // end 'SaturatingSumScalar(uint16_t*, uint32_t, uint32_t, uint32_t, uint16_t, uint16_t*)'
+
+#ifdef TRIGGERCLUSTERKERNELS_X86
+
+  // avx2 kernels -------------------------------------------------------------
+
+  __attribute__((target("avx2")))
+  void ReduceColumnsAVX2(const float* row, const uint32_t nOut, const uint32_t factor, float* out) {
+
+    uint32_t iOut = 0;
+    switch (factor) {
+
+      // 16 inputs -> 8 outputs
+      case 2:
+        for (; (iOut + 8) <= nOut; iOut += 8) {
+          const __m256 a = _mm256_loadu_ps(row + (2 * iOut));
+          const __m256 b = _mm256_loadu_ps(row + (2 * iOut) + 8);
+          const __m256 h = _mm256_hadd_ps(a, b);
+          _mm256_storeu_ps(
+            out + iOut,
+            _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(h), _MM_SHUFFLE(3, 1, 2, 0)))
+          );
+        }
+        break;
+
+      // 32 inputs -> 8 outputs
+      case 4:
+        for (; (iOut + 8) <= nOut; iOut += 8) {
+          const __m256 a  = _mm256_loadu_ps(row + (4 * iOut));
+          const __m256 b  = _mm256_loadu_ps(row + (4 * iOut) + 8);
+          const __m256 c  = _mm256_loadu_ps(row + (4 * iOut) + 16);
+          const __m256 d  = _mm256_loadu_ps(row + (4 * iOut) + 24);
+          const __m256 h  = _mm256_hadd_ps(_mm256_hadd_ps(a, b), _mm256_hadd_ps(c, d));
+          const __m256i p = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+          _mm256_storeu_ps(out + iOut, _mm256_permutevar8x32_ps(h, p));
+        }
+        break;
+
+      default:
+        break;
+    }
+
+    // pick up whatever is left
+    ReduceColumnsScalar(row + (iOut * factor), nOut - iOut, factor, out + iOut);
+    return;
+
+  }  // end 'ReduceColumnsAVX2(float*, uint32_t, uint32_t, float*)'
+
+  __attribute__((target("avx2")))
+  void BlockSumAVX2(const float* in, const uint32_t nEta, const uint32_t nPhi, const uint32_t factor, float* out) {
+
+    const uint32_t nOutEta = nEta / factor;
+    const uint32_t nOutPhi = nPhi / factor;
+    float*         row     = ScratchRow(nPhi);
+    for (uint32_t iOutEta = 0; iOutEta < nOutEta; ++iOutEta) {
+
+      // sum rows elementwise
+      const float* first = in + (iOutEta * factor * nPhi);
+      uint32_t     iPhi  = 0;
+      for (; (iPhi + 8) <= nPhi; iPhi += 8) {
+        __m256 acc = _mm256_loadu_ps(first + iPhi);
+        for (uint32_t iRow = 1; iRow < factor; ++iRow) {
+          acc = _mm256_add_ps(acc, _mm256_loadu_ps(first + (iRow * nPhi) + iPhi));
+        }
+        _mm256_storeu_ps(row + iPhi, acc);
+      }
+      for (; iPhi < nPhi; ++iPhi) {
+        row[iPhi] = first[iPhi];
+        for (uint32_t iRow = 1; iRow < factor; ++iRow) {
+          row[iPhi] += first[(iRow * nPhi) + iPhi];
+        }
+      }
+
+      // then combine columns
+      ReduceColumnsAVX2(row, nOutPhi, factor, out + (iOutEta * nOutPhi));
+    }
+    return;
+
+  }  // end 'BlockSumAVX2(float*, uint32_t, uint32_t, uint32_t, float*)'
+
+  __attribute__((target("avx2")))
+  float GatherSumAVX2(const float* in, const uint32_t* indices, const uint32_t nIndices) {
+
+    // gather 8 lanes at a time
+    __m256   acc    = _mm256_setzero_ps();
+    uint32_t iIndex = 0;
+    for (; (iIndex + 8) <= nIndices; iIndex += 8) {
+      const __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + iIndex));
+      acc = _mm256_add_ps(acc, _mm256_i32gather_ps(in, index, 4));
+    }
+
+    // reduce lanes
+    const __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    const __m128 pair = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    float        sum  = _mm_cvtss_f32(_mm_add_ss(pair, _mm_shuffle_ps(pair, pair, 1)));
+
+    // pick up whatever is left
+    return sum + GatherSumScalar(in, indices + iIndex, nIndices - iIndex);
+
+  }  // end 'GatherSumAVX2(float*, uint32_t*, uint32_t)'
+
+  __attribute__((target("avx2")))
+  void MaskAboveAVX2(const float* in, const uint32_t nValues, const float threshold, uint64_t* bits) {
+
+    // compare 8 lanes at a time, 64 values per word
+    const __m256 cut    = _mm256_set1_ps(threshold);
+    uint32_t     iValue = 0;
+    for (; (iValue + 64) <= nValues; iValue += 64) {
+      uint64_t word = 0;
+      for (uint32_t iLane = 0; iLane < 64; iLane += 8) {
+        const __m256 above = _mm256_cmp_ps(_mm256_loadu_ps(in + iValue + iLane), cut, _CMP_GT_OQ);
+        word |= static_cast<uint64_t>(_mm256_movemask_ps(above)) << iLane;
+      }
+      bits[iValue / 64] = word;
+    }
+
+    // pick up whatever is left
+    MaskAboveScalar(in + iValue, nValues - iValue, threshold, bits + (iValue / 64));
+    return;
+
+  }  // end 'MaskAboveAVX2(float*, uint32_t, float, uint64_t*)'
+
+  __attribute__((target("avx2")))
+  void MaskStatusAVX2(const uint8_t* statuses, const uint32_t nValues, const uint8_t statusBits, uint64_t* bits) {
+
+    // test 32 statuses at a time, 64 values per word
+    const __m256i test   = _mm256_set1_epi8(static_cast<char>(statusBits));
+    const __m256i zero   = _mm256_setzero_si256();
+    uint32_t      iValue = 0;
+    for (; (iValue + 64) <= nValues; iValue += 64) {
+      uint64_t word = 0;
+      for (uint32_t iLane = 0; iLane < 64; iLane += 32) {
+        const __m256i status = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(statuses + iValue + iLane));
+        const __m256i good   = _mm256_cmpeq_epi8(_mm256_and_si256(status, test), zero);
+        word |= static_cast<uint64_t>(~static_cast<uint32_t>(_mm256_movemask_epi8(good))) << iLane;
+      }
+      bits[iValue / 64] |= word;
+    }
+
+    // pick up whatever is left
+    MaskStatusScalar(statuses + iValue, nValues - iValue, statusBits, bits + (iValue / 64));
+    return;
+
+  }  // end 'MaskStatusAVX2(uint8_t*, uint32_t, uint8_t, uint64_t*)'
+
+  __attribute__((target("avx2")))
+  float ZeroMaskedAVX2(float* values, const uint32_t nValues, const uint64_t* bits) {
+
+    // blend 8 lanes at a time, skipping empty words and lanes
+    const __m256i select = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256  zero   = _mm256_setzero_ps();
+    __m256        acc    = _mm256_setzero_ps();
+    uint32_t      iValue = 0;
+    for (; (iValue + 64) <= nValues; iValue += 64) {
+      const uint64_t word = bits[iValue / 64];
+      if (word == 0) continue;
+      for (uint32_t iLane = 0; iLane < 64; iLane += 8) {
+        const int32_t lanes = (word >> iLane) & 0xFF;
+        if (lanes == 0) continue;
+
+        const __m256i hit  = _mm256_and_si256(_mm256_set1_epi32(lanes), select);
+        const __m256  mask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(hit, select));
+        const __m256  in   = _mm256_loadu_ps(values + iValue + iLane);
+        acc = _mm256_add_ps(acc, _mm256_and_ps(in, mask));
+        _mm256_storeu_ps(values + iValue + iLane, _mm256_blendv_ps(in, zero, mask));
+      }
+    }
+
+    // reduce lanes
+    const __m128 half    = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    const __m128 pair    = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    float        removed = _mm_cvtss_f32(_mm_add_ss(pair, _mm_shuffle_ps(pair, pair, 1)));
+
+    // pick up whatever is left
+    return removed + ZeroMaskedScalar(values + iValue, nValues - iValue, bits + (iValue / 64));
+
+  }  // end 'ZeroMaskedAVX2(float*, uint32_t, uint64_t*)'
+
+  __attribute__((target("avx2")))
+  void SaturatingSumAVX2(const uint16_t* in, const uint32_t nRows, const uint32_t nCols, const uint32_t stride, const uint16_t max, uint16_t* out) {
+
+    // sum 16 columns at a time down the rows
+    const __m256i cap  = _mm256_set1_epi16(static_cast<short>(max));
+    uint32_t      iCol = 0;
+    for (; (iCol + 16) <= nCols; iCol += 16) {
+      __m256i acc = _mm256_setzero_si256();
+      for (uint32_t iRow = 0; iRow < nRows; ++iRow) {
+        acc = _mm256_adds_epu16(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + (iRow * stride) + iCol)));
+      }
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + iCol), _mm256_min_epu16(acc, cap));
+    }
+
+    // pick up whatever is left
+    SaturatingSumScalar(in + iCol, nRows, nCols - iCol, stride, max, out + iCol);
+    return;
+
+  }  // end 'SaturatingSumAVX2(uint16_t*, uint32_t, uint32_t, uint32_t, uint16_t, uint16_t*)'
+
+  // avx-512 kernels ----------------------------------------------------------
+
+  __attribute__((target("avx512f")))
+  void BlockSumAVX512(const float* in, const uint32_t nEta, const uint32_t nPhi, const uint32_t factor, float* out) {
+
+    const uint32_t nOutEta = nEta / factor;
+    const uint32_t nOutPhi = nPhi / factor;
+    float*         row     = ScratchRow(nPhi);
+    for (uint32_t iOutEta = 0; iOutEta < nOutEta; ++iOutEta) {
+
+      // sum rows elementwise
+      const float* first = in + (iOutEta * factor * nPhi);
+      uint32_t     iPhi  = 0;
+      for (; (iPhi + 16) <= nPhi; iPhi += 16) {
+        __m512 acc = _mm512_loadu_ps(first + iPhi);
+        for (uint32_t iRow = 1; iRow < factor; ++iRow) {
+          acc = _mm512_add_ps(acc, _mm512_loadu_ps(first + (iRow * nPhi) + iPhi));
+        }
+        _mm512_storeu_ps(row + iPhi, acc);
+      }
+      for (; iPhi < nPhi; ++iPhi) {
+        row[iPhi] = first[iPhi];
+        for (uint32_t iRow = 1; iRow < factor; ++iRow) {
+          row[iPhi] += first[(iRow * nPhi) + iPhi];
+        }
+      }
+
+      // then combine columns
+      //   - n.b. avx-512 has no horizontal add, and the
+      //     avx2 shuffles already saturate the ports
+      ReduceColumnsAVX2(row, nOutPhi, factor, out + (iOutEta * nOutPhi));
+    }
+    return;
+
+  }  // end 'BlockSumAVX512(float*, uint32_t, uint32_t, uint32_t, float*)'
+
+  __attribute__((target("avx512f")))
+  float GatherSumAVX512(const float* in, const uint32_t* indices, const uint32_t nIndices) {
+
+    // gather 16 lanes at a time
+    __m512   acc    = _mm512_setzero_ps();
+    uint32_t iIndex = 0;
+    for (; (iIndex + 16) <= nIndices; iIndex += 16) {
+      const __m512i index = _mm512_loadu_si512(indices + iIndex);
+      acc = _mm512_add_ps(acc, _mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xFFFF, index, in, 4));
+    }
+
+    // reduce lanes
+    //   - n.b. spilled to memory rather than using the reduce
+    //     intrinsics, which trip -Wuninitialized on gcc 12
+    alignas(64) float lanes[16];
+    _mm512_store_ps(lanes, acc);
+    const float sum = PairwiseSum(lanes, 16);
+
+    // pick up whatever is left
+    return sum + GatherSumAVX2(in, indices + iIndex, nIndices - iIndex);
+
+  }  // end 'GatherSumAVX512(float*, uint32_t*, uint32_t)'
+
+  __attribute__((target("avx512f")))
+  void MaskAboveAVX512(const float* in, const uint32_t nValues, const float threshold, uint64_t* bits) {
+
+    // compare 16 lanes at a time, 64 values per word
+    const __m512 cut    = _mm512_set1_ps(threshold);
+    uint32_t     iValue = 0;
+    for (; (iValue + 64) <= nValues; iValue += 64) {
+      uint64_t word = 0;
+      for (uint32_t iLane = 0; iLane < 64; iLane += 16) {
+        const __mmask16 above = _mm512_cmp_ps_mask(_mm512_loadu_ps(in + iValue + iLane), cut, _CMP_GT_OQ);
+        word |= static_cast<uint64_t>(above) << iLane;
+      }
+      bits[iValue / 64] = word;
+    }
+
+    // pick up whatever is left
+    MaskAboveScalar(in + iValue, nValues - iValue, threshold, bits + (iValue / 64));
+    return;
+
+  }  // end 'MaskAboveAVX512(float*, uint32_t, float, uint64_t*)'
+
+  __attribute__((target("avx512f")))
+  float ZeroMaskedAVX512(float* values, const uint32_t nValues, const uint64_t* bits) {
+
+    // masked moves 16 lanes at a time, skipping empty words
+    const __m512 zero   = _mm512_setzero_ps();
+    __m512       acc    = _mm512_setzero_ps();
+    uint32_t     iValue = 0;
+    for (; (iValue + 64) <= nValues; iValue += 64) {
+      const uint64_t word = bits[iValue / 64];
+      if (word == 0) continue;
+      for (uint32_t iLane = 0; iLane < 64; iLane += 16) {
+        const __mmask16 lanes = static_cast<__mmask16>(word >> iLane);
+        if (lanes == 0) continue;
+
+        acc = _mm512_add_ps(acc, _mm512_maskz_loadu_ps(lanes, values + iValue + iLane));
+        _mm512_mask_storeu_ps(values + iValue + iLane, lanes, zero);
+      }
+    }
+
+    // reduce lanes
+    alignas(64) float lanes[16];
+    _mm512_store_ps(lanes, acc);
+    const float removed = PairwiseSum(lanes, 16);
+
+    // pick up whatever is left
+    return removed + ZeroMaskedAVX2(values + iValue, nValues - iValue, bits + (iValue / 64));
+
+  }  // end 'ZeroMaskedAVX512(float*, uint32_t, uint64_t*)'
+
+#endif
+
+}  // end anonymous namespace
+
+
+
+// dispatch ===================================================================
+
+namespace TriggerClusterKernels {
+
+  // --------------------------------------------------------------------------
+  //! Get currently selected instruction set level
+  // --------------------------------------------------------------------------
+  Level GetLevel() {
+    return CurrentLevel();
+  }
+
+
+
+  // --------------------------------------------------------------------------
+  //! Get widest instruction set level supported by the CPU
+  // --------------------------------------------------------------------------
+  Level GetBestLevel() {
+#ifdef TRIGGERCLUSTERKERNELS_X86
+    if (__builtin_cpu_supports("avx512f")) return Level::AVX512;
+    if (__builtin_cpu_supports("avx2"))    return Level::AVX2;
+#endif
+    return Level::Scalar;
+  }
+
+
+
+  // --------------------------------------------------------------------------
+  //! Force an instruction set level
+  // --------------------------------------------------------------------------
+  /*! Levels beyond what the CPU supports are clamped to the
+   *  widest supported one.
+   */
+  void SetLevel(const Level level) {
+    CurrentLevel() = std::min(level, GetBestLevel());
+  }
+
+
+
+  // --------------------------------------------------------------------------
+  //! Sum factor x factor blocks of an (eta, phi) grid
+  // --------------------------------------------------------------------------
+  /*! Output grid is (nEta / factor) x (nPhi / factor); any
+   *  towers beyond a whole number of blocks are dropped.
+   */
+  void BlockSum(const float* in, const uint32_t nEta, const uint32_t nPhi, const uint32_t factor, float* out) {
+
+    switch (CurrentLevel()) {
+#ifdef TRIGGERCLUSTERKERNELS_X86
+      case Level::AVX512:
+        BlockSumAVX512(in, nEta, nPhi, factor, out);
+        break;
+      case Level::AVX2:
+        BlockSumAVX2(in, nEta, nPhi, factor, out);
+        break;
+#endif
+      default:
+        BlockSumScalar(in, nEta, nPhi, factor, out);
+        break;
+    }
+    return;
+
+  }  // end 'BlockSum(float*, uint32_t, uint32_t, uint32_t, float*)'
+
+
+
+  // --------------------------------------------------------------------------
+  //! Sum values at a list of indices
+  // --------------------------------------------------------------------------
+  float GatherSum(const float* in, const uint32_t* indices, const uint32_t nIndices) {
+
+    float sum;
+    switch (CurrentLevel()) {
+#ifdef TRIGGERCLUSTERKERNELS_X86
+      case Level::AVX512:
+        sum = GatherSumAVX512(in, indices, nIndices);
+        break;
+      case Level::AVX2:
+        sum = GatherSumAVX2(in, indices, nIndices);
+        break;
+#endif
+      default:
+        sum = GatherSumScalar(in, indices, nIndices);
+        break;
+    }
+    return sum;
+
+  }  // end 'GatherSum(float*, uint32_t*, uint32_t)'
+
+
+
+  // --------------------------------------------------------------------------
+  //! Set a bit for every value above a threshold
+  // --------------------------------------------------------------------------
+  /*! Bit (i % 64) of bits[i / 64] is set if in[i] > threshold;
+   *  (nValues + 63) / 64 words are written, with any bits
+   *  past nValues cleared.
+   */
+  void MaskAbove(const float* in, const uint32_t nValues, const float threshold, uint64_t* bits) {
+
+    switch (CurrentLevel()) {
+#ifdef TRIGGERCLUSTERKERNELS_X86
+      case Level::AVX512:
+        MaskAboveAVX512(in, nValues, threshold, bits);
+        break;
+      case Level::AVX2:
+        MaskAboveAVX2(in, nValues, threshold, bits);
+        break;
+#endif
+      default:
+        MaskAboveScalar(in, nValues, threshold, bits);
+        break;
+    }
+    return;
+
+  }  // end 'MaskAbove(float*, uint32_t, float, uint64_t*)'
+
+
+
+  // --------------------------------------------------------------------------
+  //! Set a bit for every status with any of statusBits set
+  // --------------------------------------------------------------------------
+  /*! Bit (i % 64) of bits[i / 64] is set if statuses[i] has
+   *  any of statusBits; bits are OR'd into what's already
+   *  there, so a mask can be merged onto another. There's no
+   *  byte compare in AVX-512F, so the AVX-512 level uses the
+   *  AVX2 implementation.
+   */
+  void MaskStatus(const uint8_t* statuses, const uint32_t nValues, const uint8_t statusBits, uint64_t* bits) {
+
+    switch (CurrentLevel()) {
+#ifdef TRIGGERCLUSTERKERNELS_X86
+      case Level::AVX512:
+        [[fallthrough]];
+      case Level::AVX2:
+        MaskStatusAVX2(statuses, nValues, statusBits, bits);
+        break;
+#endif
+      default:
+        MaskStatusScalar(statuses, nValues, statusBits, bits);
+        break;
+    }
+    return;
+
+  }  // end 'MaskStatus(uint8_t*, uint32_t, uint8_t, uint64_t*)'
+
+
+
+  // --------------------------------------------------------------------------
+  //! Zero every value whose bit is set, returning what was removed
+  // --------------------------------------------------------------------------
+  /*! bits is laid out as in MaskAbove(). Words with no bits
+   *  set are skipped, so a mostly-clean mask costs little
+   *  more than reading it.
+   */
+  float ZeroMasked(float* values, const uint32_t nValues, const uint64_t* bits) {
+
+    float removed;
+    switch (CurrentLevel()) {
+#ifdef TRIGGERCLUSTERKERNELS_X86
+      case Level::AVX512:
+        removed = ZeroMaskedAVX512(values, nValues, bits);
+        break;
+      case Level::AVX2:
+        removed = ZeroMaskedAVX2(values, nValues, bits);
+        break;
+#endif
+      default:
+        removed = ZeroMaskedScalar(values, nValues, bits);
+        break;
+    }
+    return removed;
+
+  }  // end 'ZeroMasked(float*, uint32_t, uint64_t*)'
+
+
+
+  // --------------------------------------------------------------------------
+  //! Sum the columns of a row-major matrix of ADCs, saturating
+  // --------------------------------------------------------------------------
+  /*! out[iCol] is the sum of in[(iRow * stride) + iCol] over
+   *  nRows rows, clamped to max. Adds saturate at 0xFFFF like
+   *  unsigned 16-bit firmware adders; since every value is
+   *  unsigned, the result is min(sum, max) in any order, so
+   *  all implementations agree exactly. As with MaskStatus(),
+   *  the AVX-512 level uses the AVX2 implementation.
+   */
+  void SaturatingSum(const uint16_t* in, const uint32_t nRows, const uint32_t nCols, const uint32_t stride, const uint16_t max, uint16_t* out) {
+
+    switch (CurrentLevel()) {
+#ifdef TRIGGERCLUSTERKERNELS_X86
+      case Level::AVX512:
+        [[fallthrough]];
+      case Level::AVX2:
+        SaturatingSumAVX2(in, nRows, nCols, stride, max, out);
+        break;
+#endif
+      default:
+        SaturatingSumScalar(in, nRows, nCols, stride, max, out);
+        break;
+    }
+    return;
+
+  }  // end 'SaturatingSum(uint16_t*, uint32_t, uint32_t, uint32_t, uint16_t, uint16_t*)'
+
+}  // end TriggerClusterKernels namespace
+
+// end ------------------------------------------------------------------------
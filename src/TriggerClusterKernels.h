@@ -0,0 +1,75 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterKernels.h'
+ *  \authors Derek Anderson
+ *  \date    06.19.2024
+ *
+ *  Vectorized summation kernels for the
+ *  TriggerClusterMaker module
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERKERNELS_H
+#define TRIGGERCLUSTERKERNELS_H
+
+// c++ utilities
+#include <cstdint>
+
+
+
+// ----------------------------------------------------------------------------
+//! Vectorized reductions over tower grids
+// ----------------------------------------------------------------------------
+/*! Each kernel has a scalar implementation and, on x86-64,
+ *  AVX2 and AVX-512 implementations. The widest instruction
+ *  set supported by the CPU is picked at runtime, unless a
+ *  narrower one is forced via SetLevel().
+ *
+ *  The block reductions sum rows first (elementwise) and
+ *  then combine adjacent columns pairwise, in that order for
+ *  every implementation, so all implementations agree
+ *  bit-for-bit. The gathered sum and the energy removed by
+ *  masking use lane-wise partial sums and so only agree to
+ *  within float rounding. Threshold and status masks are
+ *  plain compares, and integer sums saturate the same way
+ *  in every implementation, so they agree exactly.
+ */
+namespace TriggerClusterKernels {
+
+  // instruction set levels
+  enum Level {
+    Scalar,
+    AVX2,
+    AVX512
+  };
+
+  // dispatch
+  Level GetLevel();
+  Level GetBestLevel();
+  void  SetLevel(const Level level);
+
+  // kernels
+  void  BlockSum(
+    const float* in,
+    const uint32_t nEta,
+    const uint32_t nPhi,
+    const uint32_t factor,
+    float* out
+  );
+  float GatherSum(const float* in, const uint32_t* indices, const uint32_t nIndices);
+  void  MaskAbove(const float* in, const uint32_t nValues, const float threshold, uint64_t* bits);
+  void  MaskStatus(const uint8_t* statuses, const uint32_t nValues, const uint8_t statusBits, uint64_t* bits);
+  float ZeroMasked(float* values, const uint32_t nValues, const uint64_t* bits);
+  void  SaturatingSum(
+    const uint16_t* in,
+    const uint32_t nRows,
+    const uint32_t nCols,
+    const uint32_t stride,
+    const uint16_t max,
+    uint16_t* out
+  );
+
+}  // end TriggerClusterKernels namespace
+
+#endif
+
+// end ------------------------------------------------------------------------
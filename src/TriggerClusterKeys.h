@@ -0,0 +1,216 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterKeys.h'
+ *  \authors Derek Anderson
+ *  \date    07.10.2024
+ *
+ *  Helpers for sPHENIX tower and trigger sum keys
+ *  for the TriggerClusterMaker module
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERKEYS_H
+#define TRIGGERCLUSTERKEYS_H
+
+// c++ utilities
+#include <cstdint>
+#include <limits>
+#include <utility>
+// calo base
+#include <calobase/TowerInfoDefs.h>
+// trigger libraries
+//   - TODO use local paths when ready
+#include <calotrigger/TriggerDefs.h>
+// module utilities
+#include "TriggerClusterMakerDefs.h"
+
+
+
+// ----------------------------------------------------------------------------
+//! sPHENIX key tools for the TriggerClusterMaker module
+// ----------------------------------------------------------------------------
+/*! Everything which needs TriggerDefs or TowerInfoDefs
+ *  lives here rather than in TriggerClusterMakerDefs.h, so
+ *  that only the fun4all modules depend on them.
+ */
+namespace TriggerClusterMakerDefs {
+
+  // key traits ---------------------------------------------------------------
+
+  // --------------------------------------------------------------------------
+  //! Detector ID and tower key encoding of a calorimeter layer
+  // --------------------------------------------------------------------------
+  template <uint32_t C> struct KeyTraits;
+
+  template <> struct KeyTraits<Cal::EM> {
+    static constexpr uint32_t detector = TriggerDefs::DetectorId::emcalDId;
+    static uint32_t EncodeKey(const uint32_t eta, const uint32_t phi) {return TowerInfoDefs::encode_emcal(eta, phi);}
+  };
+
+  template <> struct KeyTraits<Cal::IH> {
+    static constexpr uint32_t detector = TriggerDefs::DetectorId::hcalinDId;
+    static uint32_t EncodeKey(const uint32_t eta, const uint32_t phi) {return TowerInfoDefs::encode_hcal(eta, phi);}
+  };
+
+  template <> struct KeyTraits<Cal::OH> {
+    static constexpr uint32_t detector = TriggerDefs::DetectorId::hcaloutDId;
+    static uint32_t EncodeKey(const uint32_t eta, const uint32_t phi) {return TowerInfoDefs::encode_hcal(eta, phi);}
+  };
+
+
+
+  // methods ------------------------------------------------------------------
+
+  // --------------------------------------------------------------------------
+  //! Get calorimeter layer corresponding to a trigger detector ID
+  // --------------------------------------------------------------------------
+  inline uint32_t GetCalFromDetector(const uint32_t det) {
+
+    uint32_t cal;
+    switch (det) {
+      case TriggerDefs::DetectorId::emcalDId:
+        cal = Cal::EM;
+        break;
+      case TriggerDefs::DetectorId::hcalinDId:
+        cal = Cal::IH;
+        break;
+      case TriggerDefs::DetectorId::hcaloutDId:
+        cal = Cal::OH;
+        break;
+      default:
+        cal = std::numeric_limits<uint32_t>::max();
+        break;
+    }
+    return cal;
+
+  }  // end 'GetCalFromDetector(uint32_t)'
+
+
+
+  // --------------------------------------------------------------------------
+  //! Calculate eta/phi bin of a sum based on sum key
+  // --------------------------------------------------------------------------
+  /*! Returns the index of the sum along the specified axis,
+   *  in units of sums. Multiply by GetTowersInSum() to get
+   *  the index of the first tower in the sum.
+   */
+  template <uint32_t A, uint32_t T> inline uint32_t GetBin(const uint32_t sumkey) {
+
+    // get relevant sum and primitive IDs
+    static_assert((A == Axis::Eta) || (A == Axis::Phi), "GetBin: unknown axis");
+    const uint32_t sumID  = (A == Axis::Eta) ? TriggerDefs::getSumEtaId(sumkey) : TriggerDefs::getSumPhiId(sumkey);
+    const uint32_t primID = (A == Axis::Eta)
+                          ? TriggerDefs::getPrimitiveEtaId_from_TriggerSumKey(sumkey)
+                          : TriggerDefs::getPrimitivePhiId_from_TriggerSumKey(sumkey);
+
+    // segmentation doesn't depend on layer
+    return sumID + (SumTraits<Cal::EM, T>::nSumInPrim * primID);
+
+  }  // end 'GetBin<uint32_t, uint32_t>(uint32_t)'
+
+
+
+  // --------------------------------------------------------------------------
+  //! Calculate eta/phi bin of a sum based on sum key (runtime axis/type)
+  // --------------------------------------------------------------------------
+  inline uint32_t GetBin(const uint32_t sumkey, const uint32_t axis, const uint32_t type = Type::Prim) {
+
+    uint32_t bin;
+    if (axis == Axis::Eta) {
+      bin = (type == Type::LL1) ? GetBin<Axis::Eta, Type::LL1>(sumkey) : GetBin<Axis::Eta, Type::Prim>(sumkey);
+    } else if (axis == Axis::Phi) {
+      bin = (type == Type::LL1) ? GetBin<Axis::Phi, Type::LL1>(sumkey) : GetBin<Axis::Phi, Type::Prim>(sumkey);
+    } else {
+      bin = std::numeric_limits<uint32_t>::max();
+    }
+    return bin;
+
+  }  // end 'GetBin(uint32_t, uint32_t, uint32_t)'
+
+
+
+  // --------------------------------------------------------------------------
+  //! Get tower key based on provided eta, phi indices in a given layer
+  // --------------------------------------------------------------------------
+  template <uint32_t C> inline uint32_t GetKeyFromEtaPhiIndex(const uint32_t eta, const uint32_t phi) {
+    return KeyTraits<C>::EncodeKey(eta, phi);
+  }
+
+
+
+  // --------------------------------------------------------------------------
+  //! Get tower key based on provided eta, phi indices
+  // --------------------------------------------------------------------------
+  inline uint32_t GetKeyFromEtaPhiIndex(const uint32_t eta, const uint32_t phi, const uint32_t det) {
+
+    uint32_t key;
+    switch (det) {
+
+      // get emcal tower index
+      case TriggerDefs::DetectorId::emcalDId:
+        key = GetKeyFromEtaPhiIndex<Cal::EM>(eta, phi);
+        break;
+
+      // get hcal tower index
+      case TriggerDefs::DetectorId::hcalinDId:
+        [[fallthrough]];
+      case TriggerDefs::DetectorId::hcaloutDId:
+        [[fallthrough]];
+      case TriggerDefs::DetectorId::hcalDId:
+        key = GetKeyFromEtaPhiIndex<Cal::IH>(eta, phi);
+        break;
+
+      // otherwise return dummy value
+      default:
+        key = std::numeric_limits<uint32_t>::max();
+        break;
+    }
+    return key;
+
+  } //  end 'GetKeyFromEtaPhiIndex(uint32_t, uint32_t, uint32_t)'
+
+
+
+  // --------------------------------------------------------------------------
+  //! Get range of tower indices for a specified direction from a starting point
+  // --------------------------------------------------------------------------
+  inline std::pair<uint32_t, uint32_t> GetRangeOfIndices(
+    const uint32_t iStartTrg,
+    const uint32_t detector,
+    const uint32_t type = Type::Prim
+  ) {
+
+    std::pair<uint32_t, uint32_t> range;
+    switch (detector) {
+
+      // get emcal tower range
+      case TriggerDefs::DetectorId::emcalDId:
+        range = (type == Type::LL1)
+              ? GetRangeOfIndices<Cal::EM, Type::LL1>(iStartTrg)
+              : GetRangeOfIndices<Cal::EM, Type::Prim>(iStartTrg);
+        break;
+
+      // get hcal tower range
+      case TriggerDefs::DetectorId::hcalinDId:
+        [[fallthrough]];
+      case TriggerDefs::DetectorId::hcaloutDId:
+        [[fallthrough]];
+      case TriggerDefs::DetectorId::hcalDId:
+        range = (type == Type::LL1)
+              ? GetRangeOfIndices<Cal::IH, Type::LL1>(iStartTrg)
+              : GetRangeOfIndices<Cal::IH, Type::Prim>(iStartTrg);
+        break;
+
+      // otherwise set both to start
+      default:
+        range = std::make_pair(iStartTrg, iStartTrg);
+        break;
+    }
+    return range;
+
+  }  // end 'GetRangeOfIndeices(uint32_t, uint32_t, uint32_t)'
+
+}  // end TriggerClusterMakerDefs namespace
+
+#endif
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,105 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterLL1Decoder.cc'
+ *  \authors Derek Anderson
+ *  \date    06.26.2024
+ *
+ *  Bit-parallel decoder for LL1 jet-patch trigger
+ *  words for the TriggerClusterMaker module
+ */
+// ----------------------------------------------------------------------------
+
+#define TRIGGERCLUSTERLL1DECODER_CC
+
+// c++ utilities
+#include <algorithm>
+
+// class definition
+#include "TriggerClusterLL1Decoder.h"
+
+
+
+// public methods =============================================================
+
+// ----------------------------------------------------------------------------
+//! Clear all fired patches
+// ----------------------------------------------------------------------------
+/*! Only the bitmasks need to be cleared: ADCs are only read
+ *  back for patches whose bit is set.
+ */
+void TriggerClusterLL1Decoder::Reset() {
+
+  for (auto& fired : m_fired) {
+    fired.fill(0);
+  }
+  return;
+
+}  // end 'Reset()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Add a trigger word
+// ----------------------------------------------------------------------------
+/*! The word's patch is located by its layer (or any value
+ *  past the outer HCal for words which don't map onto one
+ *  layer) and its (eta, phi) position on the retower grid.
+ *  Returns false if the patch isn't on the grid.
+ */
+bool TriggerClusterLL1Decoder::Fill(
+  const uint32_t cal,
+  const uint32_t iEta,
+  const uint32_t iPhi,
+  const unsigned int* samples,
+  const std::size_t nSamples,
+  const uint32_t threshold
+) {
+
+  // locate patch
+  const uint32_t source = std::min(cal, AllLayers);
+  if ((iEta >= NEta) || (iPhi >= NPhi)) return false;
+
+  // get peak over samples
+  uint32_t adc = 0;
+  for (std::size_t iSample = 0; iSample < nSamples; ++iSample) {
+    adc = std::max(adc, static_cast<uint32_t>(samples[iSample]));
+  }
+
+  // record adc and set fired bit without branching
+  m_adc[source][(iEta * NPhi) + iPhi]  = adc;
+  m_fired[source][iEta]               |= static_cast<uint64_t>(adc >= threshold) << iPhi;
+  return true;
+
+}  // end 'Fill(uint32_t, uint32_t, uint32_t, unsigned int*, std::size_t, uint32_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Collect all fired patches
+// ----------------------------------------------------------------------------
+/*! Patches are ordered by source, then eta, then phi. */
+void TriggerClusterLL1Decoder::Decode(std::vector<Patch>& patches) const {
+
+  patches.clear();
+  for (uint32_t source = 0; source <= AllLayers; ++source) {
+    for (uint32_t iEta = 0; iEta < NEta; ++iEta) {
+
+      // walk set bits, clearing the lowest each time
+      uint64_t word = m_fired[source][iEta];
+      while (word) {
+        const uint32_t iPhi = __builtin_ctzll(word);
+        word &= word - 1;
+
+        Patch patch;
+        patch.source = source;
+        patch.iEta   = iEta;
+        patch.iPhi   = iPhi;
+        patch.adc    = m_adc[source][(iEta * NPhi) + iPhi];
+        patches.push_back(patch);
+      }
+    }  // end eta loop
+  }  // end source loop
+  return;
+
+}  // end 'Decode(std::vector<Patch>&)'
+
+// end ------------------------------------------------------------------------
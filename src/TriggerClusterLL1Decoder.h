@@ -0,0 +1,82 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterLL1Decoder.h'
+ *  \authors Derek Anderson
+ *  \date    06.26.2024
+ *
+ *  Bit-parallel decoder for LL1 jet-patch trigger
+ *  words for the TriggerClusterMaker module
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERLL1DECODER_H
+#define TRIGGERCLUSTERLL1DECODER_H
+
+// c++ utilities
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+// module utilities
+#include "TriggerClusterMakerDefs.h"
+
+
+
+// ----------------------------------------------------------------------------
+//! Unpacks LL1 trigger words into fired jet patches
+// ----------------------------------------------------------------------------
+/*! Each trigger word is located by its layer and its patch
+ *  on the retower grid (24 x 64 in every layer), and holds
+ *  one ADC value per sample. The peak ADC of each word
+ *  is compared against threshold and the result is OR-ed
+ *  into a bitmask with one 64-bit word per eta row, so a
+ *  full row of phi is a single word.
+ *
+ *  Decoding then skips empty rows outright and walks the set
+ *  bits of the others with count-trailing-zeros, so the cost
+ *  scales with the no. of fired patches rather than the no.
+ *  of patches.
+ */
+class TriggerClusterLL1Decoder {
+
+  public:
+
+    // retower grid
+    static constexpr uint32_t NEta = TriggerClusterMakerDefs::SumTraits<TriggerClusterMakerDefs::Cal::EM, TriggerClusterMakerDefs::Type::LL1>::nSumEta;
+    static constexpr uint32_t NPhi = TriggerClusterMakerDefs::SumTraits<TriggerClusterMakerDefs::Cal::EM, TriggerClusterMakerDefs::Type::LL1>::nSumPhi;
+    static_assert(NPhi == 64, "TriggerClusterLL1Decoder: a row of phi must fit in one 64-bit word");
+
+    // source of words whose detector doesn't map onto one
+    // layer (e.g. combined EMCal + HCal jet patches)
+    static constexpr uint32_t AllLayers = TriggerClusterMakerDefs::Cal::OH + 1;
+
+    // ------------------------------------------------------------------------
+    //! A fired patch
+    // ------------------------------------------------------------------------
+    struct Patch {
+      uint32_t source = 0;  // layer (TriggerClusterMakerDefs::Cal) or AllLayers
+      uint32_t iEta   = 0;  // eta index of lower corner (in retowers)
+      uint32_t iPhi   = 0;  // phi index of lower corner (in retowers)
+      uint32_t adc    = 0;  // peak ADC over samples
+    };
+
+    // ctor/dtor
+    TriggerClusterLL1Decoder()  {Reset();};
+    ~TriggerClusterLL1Decoder() {};
+
+    // public methods
+    void Reset();
+    bool Fill(const uint32_t cal, const uint32_t iEta, const uint32_t iPhi, const unsigned int* samples, const std::size_t nSamples, const uint32_t threshold);
+    void Decode(std::vector<Patch>& patches) const;
+
+  private:
+
+    // fired-patch bitmask (one word per eta row) and
+    // peak ADCs, per source
+    std::array<std::array<uint64_t, NEta>, AllLayers + 1>        m_fired;
+    std::array<std::array<uint32_t, NEta * NPhi>, AllLayers + 1> m_adc;
+
+};
+
+#endif
+
+// end ------------------------------------------------------------------------
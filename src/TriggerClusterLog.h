@@ -0,0 +1,128 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterLog.h'
+ *  \authors Derek Anderson
+ *  \date    07.08.2024
+ *
+ *  Compile-time gated debug logging for the
+ *  trigger cluster modules
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERLOG_H
+#define TRIGGERCLUSTERLOG_H
+
+// c++ utilities
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+
+
+// ----------------------------------------------------------------------------
+//! Maximum log level compiled into the modules
+// ----------------------------------------------------------------------------
+/*! Messages above this level are removed at compile time.
+ *  Can be set with configure --with-max-log-level=N; by
+ *  default, release (NDEBUG) builds keep only per-module and
+ *  per-stage messages (levels 0 and 1), so nothing is logged
+ *  from inside the cluster-building loops.
+ */
+#ifndef TRIGGERCLUSTER_MAX_LOG_LEVEL
+  #ifdef NDEBUG
+    #define TRIGGERCLUSTER_MAX_LOG_LEVEL 1
+  #else
+    #define TRIGGERCLUSTER_MAX_LOG_LEVEL 3
+  #endif
+#endif
+
+
+
+// ----------------------------------------------------------------------------
+//! Logging macro
+// ----------------------------------------------------------------------------
+/*! Logs msg (which may be a chain of << operands) to the
+ *  module's buffered sink if the module is in debug mode and
+ *  Verbosity() >= level. Levels follow the old convention of
+ *  the modules:
+ *    0 -- fun4all methods (debug only)
+ *    1 -- per-run and per-stage messages
+ *    2 -- per-event stages
+ *    3 -- per-element messages (sums, patches, towers, etc.)
+ *
+ *  Expects m_log, m_config.debug, and Verbosity() to be in
+ *  scope, as they are in every module of this package. The
+ *  message is only formatted once the check passes.
+ */
+#if defined(__GNUC__)
+  #define TRGCLUST_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+  #define TRGCLUST_UNLIKELY(x) (x)
+#endif
+
+#define TRGCLUST_LOG(level, msg) \
+  do { \
+    if constexpr ((level) <= TRIGGERCLUSTER_MAX_LOG_LEVEL) { \
+      if (TRGCLUST_UNLIKELY(m_config.debug && (Verbosity() >= (level)))) { \
+        std::ostringstream trgClustLine; \
+        trgClustLine << msg << "\n"; \
+        m_log.Write(trgClustLine.str()); \
+      } \
+    } \
+  } while (0)
+
+
+
+// ----------------------------------------------------------------------------
+//! Buffered log sink
+// ----------------------------------------------------------------------------
+/*! Lines are appended to an in-memory buffer, which the
+ *  owning module flushes to stdout once per event (and at
+ *  the end of each fun4all method) rather than once per
+ *  line. Writes are serialized so that worker threads can
+ *  log too; flushing is only done from the event thread.
+ */
+class TriggerClusterLogSink {
+
+  public:
+
+    // ctor/dtor
+    TriggerClusterLogSink()  {};
+    ~TriggerClusterLogSink() {Flush();};
+
+    // ------------------------------------------------------------------------
+    //! Append a line to the buffer
+    // ------------------------------------------------------------------------
+    void Write(const std::string& line) {
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_buffer.append(line);
+      return;
+
+    }  // end 'Write(std::string&)'
+
+    // ------------------------------------------------------------------------
+    //! Write out and clear the buffer
+    // ------------------------------------------------------------------------
+    void Flush() {
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_buffer.empty()) return;
+
+      std::cout << m_buffer << std::flush;
+      m_buffer.clear();
+      return;
+
+    }  // end 'Flush()'
+
+  private:
+
+    // buffered lines
+    std::string m_buffer;
+    std::mutex  m_mutex;
+
+};
+
+#endif
+
+// end ------------------------------------------------------------------------
@@ -15,6 +15,7 @@
 #include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <limits>
 // calo base
 #include <calobase/RawClusterv1.h>
 #include <calobase/TowerInfo.h>
@@ -22,6 +23,8 @@
 // trigger libraries
 #include <calotrigger/LL1Out.h>
 #include <calotrigger/LL1Outv1.h>
+#include <calotrigger/TriggerPrimitive.h>
+#include <calotrigger/TriggerPrimitivev1.h>
 #include <calotrigger/TriggerPrimitiveContainer.h>
 #include <calotrigger/TriggerPrimitiveContainerv1.h>
 // f4a libraries
@@ -30,6 +33,7 @@
 #include <phool/getClass.h>
 #include <phool/phool.h>
 #include <phool/PHCompositeNode.h>
+#include <phool/PHDataNode.h>
 #include <phool/PHIODataNode.h>
 #include <phool/PHNode.h>
 #include <phool/PHNodeIterator.h>
@@ -37,6 +41,7 @@
 
 // module definition
 #include "TriggerClusterMaker.h"
+#include "TriggerClusterKeys.h"
 
 
 
@@ -48,16 +53,14 @@
 TriggerClusterMaker::TriggerClusterMaker(const std::string &name) : SubsysReco(name) {
 
   // print debug message
-  if (m_config.debug && (Verbosity() > 0)) {
-    std::cout << "TriggerClusterMaker::TriggerClusterMaker(const std::string &name) Calling ctor" << std::endl;
-  }
-
-  // set tower nodes to null
-  std::fill(m_inTowerNodes.begin(), m_inTowerNodes.end(), nullptr);
+  TRGCLUST_LOG(1, "TriggerClusterMaker::TriggerClusterMaker(const std::string &name) Calling ctor");
 
   // make sure vectors are clear
   m_inLL1Nodes.clear();
   m_inPrimNodes.clear();
+  m_sumIDs.clear();
+  m_sweepClusters.clear();
+  m_sweepBuffers.clear();
 
 }  // end ctor
 
@@ -69,11 +72,7 @@ TriggerClusterMaker::TriggerClusterMaker(const std::string &name) : SubsysReco(n
 TriggerClusterMaker::~TriggerClusterMaker() {
 
   // print debug message
-  if (m_config.debug && (Verbosity() > 0)) {
-    std::cout << "TriggerClusterMaker::~TriggerClusterMaker() Calling dtor" << std::endl;
-  }
-
-  /* nothing to do */
+  TRGCLUST_LOG(1, "TriggerClusterMaker::~TriggerClusterMaker() Calling dtor");
 
 }  // end dtor
 
@@ -86,42 +85,141 @@ TriggerClusterMaker::~TriggerClusterMaker() {
 // ----------------------------------------------------------------------------
 int TriggerClusterMaker::Init(PHCompositeNode* topNode) {
 
-  if (m_config.debug) {
-    std::cout << "TriggerClusterMaker::Init(PHCompositeNode *topNode) Initializing" << std::endl;
-  }
+  TRGCLUST_LOG(0, "TriggerClusterMaker::Init(PHCompositeNode *topNode) Initializing");
 
   // initialize outputs
   InitOutNode(topNode);
+
+  // configure and initialize engine
+  //   - n.b. this also spins up workers if
+  //     processing in parallel
+  TriggerClusterEngineConfig engine;
+  engine.debug            = m_config.debug;
+  engine.verbosity        = Verbosity();
+  engine.mode             = m_config.mode;
+  engine.patch            = m_config.patch;
+  engine.sweep            = m_config.sweep;
+  engine.nThreads         = m_config.nThreads;
+  engine.minParallelPrims = m_config.minParallelPrims;
+  engine.cacheSums        = m_config.cacheSums;
+  engine.sparse           = m_config.sparse;
+  engine.sparseThreshold  = m_config.sparseThreshold;
+  engine.maskChannels     = m_config.maskChannels;
+  engine.maskStatusBits   = m_config.maskStatusBits;
+  engine.maskedChannels   = m_config.maskedChannels;
+  engine.sumAdcs          = m_config.sumAdcs;
+  engine.adcMax           = m_config.adcMax;
+  m_engine.SetConfig(engine);
+  m_engine.SetPyramid(m_outPyramidNode);
+  m_engine.Init();
+  m_log.Flush();
   return Fun4AllReturnCodes::EVENT_OK;
 
 }  // end 'Init(PHCompositeNode*)'
 
 
 
+// ----------------------------------------------------------------------------
+//! Bind input nodes for the run
+// ----------------------------------------------------------------------------
+int TriggerClusterMaker::InitRun(PHCompositeNode* topNode) {
+
+  TRGCLUST_LOG(0, "TriggerClusterMaker::InitRun(PHCompositeNode *topNode) Binding input nodes");
+
+  // resolve input nodes once per run
+  GrabTowerNodes(topNode);
+  GrabTriggerNodes(topNode);
+
+  // and map tower channels onto engine grids
+  MapTowerChannels();
+  m_log.Flush();
+  return Fun4AllReturnCodes::EVENT_OK;
+
+}  // end 'InitRun(PHCompositeNode*)'
+
+
+
 // ----------------------------------------------------------------------------
 //! Grab inputs and build trigger clusters
 // ----------------------------------------------------------------------------
 int TriggerClusterMaker::process_event(PHCompositeNode* topNode) {
 
-  if (m_config.debug) {
-    std::cout << "TriggerClusterMaker::process_event(PHCompositeNode *topNode) Processing Event" << std::endl;
+  TRGCLUST_LOG(0, "TriggerClusterMaker::process_event(PHCompositeNode *topNode) Processing Event");
+  TRGCLUST_TIME(m_instrument, TriggerClusterInstrument::Event);
+
+  // make sure bound input nodes are still valid
+  ValidateInputNodes();
+
+  // drop events which can't contain anything of interest
+  if (m_config.prefilter) {
+    if (!PassesPrefilter()) {
+      ++m_nRejected;
+      TRGCLUST_COUNT(m_instrument, TriggerClusterInstrument::EventsRejected, 1);
+      TRGCLUST_LOG(2, "    Event rejected by pre-filter");
+      m_log.Flush();
+      return Fun4AllReturnCodes::ABORTEVENT;
+    }
+    ++m_nAccepted;
+    TRGCLUST_COUNT(m_instrument, TriggerClusterInstrument::EventsAccepted, 1);
   }
 
-  // grab input nodes
-  GrabTowerNodes(topNode);
-  GrabTriggerNodes(topNode);
+  m_engine.BeginEvent(m_clusters);
+
+  // copy towers into engine, and reduce
+  // them into pyramid if needed
+  SnapshotTowers();
+  if (m_config.makePyramid) {
+    m_engine.GetPyramid();
+  }
 
   // loop over LL1 nodes
-  for (auto inLL1Node : m_inLL1Nodes) {
-    ProcessLL1s(inLL1Node);
+  for (auto& inLL1Node : m_inLL1Nodes) {
+    ProcessLL1s(inLL1Node.data);
   }  // end LL1 node loop
 
-  // loop over trigger primitive nodes
-  for (auto inPrimNode : m_inPrimNodes) {
-    ProcessPrimitives(inPrimNode);
-  }  // end trigger primitive node loop
+  // build clusters according to mode
+  switch (m_config.mode) {
+
+    // loop over trigger primitive nodes
+    case TriggerClusterMakerDefs::Mode::Primitives:
+      ProcessPrimitives();
+      break;
+
+    // or scan sliding-window patches
+    case TriggerClusterMakerDefs::Mode::Patches:
+      ProcessPatches();
+      break;
+
+    // or scan patches for every sweep configuration
+    case TriggerClusterMakerDefs::Mode::Sweep:
+      ProcessSweep();
+      break;
+
+    default:
+      break;
+  }
 
-  // end event
+  // convert to RawClusters if needed
+  if (m_config.output == TriggerClusterMakerDefs::Output::Raw) {
+    UnpackClusters(m_clusters, m_outClustNode, m_outLL1ClustNode);
+    for (std::size_t iConfig = 0; iConfig < m_sweepClusters.size(); ++iConfig) {
+      UnpackClusters(m_sweepClusters[iConfig], m_outSweepClustNodes[iConfig], m_outSweepClustNodes[iConfig]);
+    }
+  }
+
+#ifdef TRIGGERCLUSTER_INSTRUMENT
+  // count clusters and towers across every active buffer
+  TRGCLUST_COUNT(m_instrument, TriggerClusterInstrument::ClustersEmitted, m_clusters -> GetNClusters());
+  TRGCLUST_COUNT(m_instrument, TriggerClusterInstrument::TowersAdded, m_clusters -> GetNTowers());
+  for (const TriggerClusterBuffer* sweepClusters : m_sweepClusters) {
+    TRGCLUST_COUNT(m_instrument, TriggerClusterInstrument::ClustersEmitted, sweepClusters -> GetNClusters());
+    TRGCLUST_COUNT(m_instrument, TriggerClusterInstrument::TowersAdded, sweepClusters -> GetNTowers());
+  }
+#endif
+
+  // flush debug messages and end event
+  m_engine.EndEvent();
+  m_log.Flush();
   return Fun4AllReturnCodes::EVENT_OK;
 
 }  // end 'process_event(PHCompositeNode*)'
@@ -133,12 +231,29 @@ int TriggerClusterMaker::process_event(PHCompositeNode* topNode) {
 // ----------------------------------------------------------------------------
 int TriggerClusterMaker::End(PHCompositeNode *topNode) {
 
-  if (m_config.debug) {
-    std::cout << "TriggerClusterMaker::End(PHCompositeNode *topNode) This is the End..." << std::endl;
+  TRGCLUST_LOG(0, "TriggerClusterMaker::End(PHCompositeNode *topNode) This is the End...");
+
+  // join any workers
+  m_engine.End();
+
+  // report pre-filter decisions
+  if (m_config.prefilter) {
+    TRGCLUST_LOG(0, "    Pre-filter accepted " << m_nAccepted << " and rejected " << m_nRejected << " events");
   }
 
-  /* nothing to do */
+#ifdef TRIGGERCLUSTER_INSTRUMENT
+  // collect sum cache counters
+  TRGCLUST_COUNT(m_instrument, TriggerClusterInstrument::SumCacheHits, m_engine.GetNSumCacheHits());
+  TRGCLUST_COUNT(m_instrument, TriggerClusterInstrument::SumCacheMisses, m_engine.GetNSumCacheMisses());
+  TRGCLUST_COUNT(m_instrument, TriggerClusterInstrument::PrimitivesSkipped, m_engine.GetNSkippedPrimitives());
 
+  // report timing and counters
+  m_instrument.Report();
+  if (!m_config.instrumentFile.empty()) {
+    m_instrument.Write(m_config.instrumentFile);
+  }
+#endif
+  m_log.Flush();
   return Fun4AllReturnCodes::EVENT_OK;
 
 }  // end 'End(PHCompositeNode*)'
@@ -153,9 +268,7 @@ int TriggerClusterMaker::End(PHCompositeNode *topNode) {
 void TriggerClusterMaker::InitOutNode(PHCompositeNode* topNode) {
 
   // print debug message
-  if (m_config.debug && (Verbosity() > 0)) {
-    std::cout << "TriggerClusterMaker::InitOutNode(PHCompositeNode*) Creating output node" << std::endl;
-  }
+  TRGCLUST_LOG(1, "TriggerClusterMaker::InitOutNode(PHCompositeNode*) Creating output node");
 
   // find dst node
   //   - if missing, abort
@@ -175,16 +288,44 @@ void TriggerClusterMaker::InitOutNode(PHCompositeNode* topNode) {
     trgNode =  trgNodeToAdd;
   }
 
-  // create container for clusters
-  m_outClustNode = new RawClusterContainer();
-
-  // and add node to tree
-  PHIODataNode<PHObject>* clustNode = new PHIODataNode<PHObject>(m_outClustNode, m_config.outNodeName, "PHObject");
-  if (!clustNode) {
-    std::cerr << PHWHERE << ": PANIC! Couldn't create cluster node! Aborting!" << std::endl;
-    assert(clustNode);
+  // create packed container for all clusters, or containers
+  // for clusters from primitives/patches and from LL1s
+  if (m_config.output == TriggerClusterMakerDefs::Output::Packed) {
+    AddOutNode(trgNode, m_config.outNodeName, m_outPackNode);
+    m_clusters = m_outPackNode;
   } else {
-    trgNode -> addNode(clustNode);
+    AddOutNode(trgNode, m_config.outNodeName, m_outClustNode);
+    AddOutNode(trgNode, m_config.outLL1NodeName, m_outLL1ClustNode);
+    m_clusters = &m_clustBuffer;
+  }
+
+  // in sweep mode, add a node per configuration
+  //   - n.b. buffers are sized up front so that
+  //     pointers into them stay valid
+  if (m_config.mode == TriggerClusterMakerDefs::Mode::Sweep) {
+    const std::size_t nConfigs = m_config.sweep.size();
+    m_sweepClusters.resize(nConfigs, NULL);
+    m_sweepBuffers.resize(nConfigs);
+    m_outSweepClustNodes.resize(nConfigs, NULL);
+    m_outSweepPackNodes.resize(nConfigs, NULL);
+    for (std::size_t iConfig = 0; iConfig < nConfigs; ++iConfig) {
+      const std::string name = m_config.outNodeName + m_config.outSweepSuffix + std::to_string(iConfig);
+      if (m_config.output == TriggerClusterMakerDefs::Output::Packed) {
+        AddOutNode(trgNode, name, m_outSweepPackNodes[iConfig]);
+        m_sweepClusters[iConfig] = m_outSweepPackNodes[iConfig];
+      } else {
+        AddOutNode(trgNode, name, m_outSweepClustNodes[iConfig]);
+        m_sweepClusters[iConfig] = &m_sweepBuffers[iConfig];
+      }
+    }
+  }
+
+  // add energy pyramid if needed
+  //   - n.b. the pyramid can be rebuilt from the towers at
+  //     any time, so it's not worth ~110 kB per event in
+  //     the output
+  if (m_config.makePyramid) {
+    AddOutNode(trgNode, m_config.outPyramidNodeName, m_outPyramidNode, false);
   }
   return;
 
@@ -198,30 +339,12 @@ void TriggerClusterMaker::InitOutNode(PHCompositeNode* topNode) {
 void TriggerClusterMaker::GrabTowerNodes(PHCompositeNode* topNode) {
 
   // print debug message
-  if (m_config.debug && (Verbosity() > 0)) {
-    std::cout << "TriggerClusterMaker::GrabTowerNodes(PHCompositeNode*) Grabbing input tower nodes" << std::endl;
-  }
-
-  // get emcal tower info node
-  m_inTowerNodes[TriggerClusterMakerDefs::Cal::EM] = findNode::getClass<TowerInfoContainer>(topNode, m_config.inEMCalTowerNode);
-  if (!m_inTowerNodes[TriggerClusterMakerDefs::Cal::EM]) {
-    std::cerr << PHWHERE << ": PANIC! Couldn't grab EMCal towers from node '" << m_config.inEMCalTowerNode << "'!" << std::endl;
-    assert(m_inTowerNodes[TriggerClusterMakerDefs::Cal::EM]); 
-  }
-
-  // get inner hcal tower info node
-  m_inTowerNodes[TriggerClusterMakerDefs::Cal::IH] = findNode::getClass<TowerInfoContainer>(topNode, m_config.inIHCalTowerNode);
-  if (!m_inTowerNodes[TriggerClusterMakerDefs::Cal::EM]) {
-    std::cerr << PHWHERE << ": PANIC! Couldn't grab IHCal towers from node '" << m_config.inIHCalTowerNode << "'!" << std::endl;
-    assert(m_inTowerNodes[TriggerClusterMakerDefs::Cal::IH]); 
-  }
+  TRGCLUST_LOG(1, "TriggerClusterMaker::GrabTowerNodes(PHCompositeNode*) Grabbing input tower nodes");
 
-  // get outer hcal tower info node
-  m_inTowerNodes[TriggerClusterMakerDefs::Cal::OH] = findNode::getClass<TowerInfoContainer>(topNode, m_config.inOHCalTowerNode);
-  if (!m_inTowerNodes[TriggerClusterMakerDefs::Cal::EM]) {
-    std::cerr << PHWHERE << ": PANIC! Couldn't grab OHCal towers from node '" << m_config.inOHCalTowerNode << "'!" << std::endl;
-    assert(m_inTowerNodes[TriggerClusterMakerDefs::Cal::OH]); 
-  }
+  // bind emcal, inner hcal, and outer hcal tower info nodes
+  BindInputNode(topNode, m_config.inEMCalTowerNode, m_inTowerNodes[TriggerClusterMakerDefs::Cal::EM]);
+  BindInputNode(topNode, m_config.inIHCalTowerNode, m_inTowerNodes[TriggerClusterMakerDefs::Cal::IH]);
+  BindInputNode(topNode, m_config.inOHCalTowerNode, m_inTowerNodes[TriggerClusterMakerDefs::Cal::OH]);
   return;
 
 }  // end 'GrabTowerNodes(PHCompositeNode*)'
@@ -234,30 +357,22 @@ void TriggerClusterMaker::GrabTowerNodes(PHCompositeNode* topNode) {
 void TriggerClusterMaker::GrabTriggerNodes(PHCompositeNode* topNode) {
 
   // print debug message
-  if (m_config.debug && (Verbosity() > 0)) {
-    std::cout << "TriggerClusterMaker::GrabTriggerNodes(PHCompositeNode*) Grabbing input trigger nodes" << std::endl;
-  }
+  TRGCLUST_LOG(1, "TriggerClusterMaker::GrabTriggerNodes(PHCompositeNode*) Grabbing input trigger nodes");
+
+  // drop any handles left over from a previous run
+  m_inLL1Nodes.clear();
+  m_inPrimNodes.clear();
 
   // get LL1 nodes
-  for (const std::string& inLL1Node : m_config.inLL1Nodes) {
-    m_inLL1Nodes.push_back(
-      findNode::getClass<LL1Out>(topNode, inLL1Node)
-    );
-    if (!m_inLL1Nodes.back()) {
-      std::cerr << PHWHERE << ": PANIC! Couldn't grab LL1Out node '" << inLL1Node << "'!" << std::endl;
-      assert(m_inLL1Nodes.back());
-    }
+  m_inLL1Nodes.resize(m_config.inLL1Nodes.size());
+  for (size_t iLL1Node = 0; iLL1Node < m_config.inLL1Nodes.size(); ++iLL1Node) {
+    BindInputNode(topNode, m_config.inLL1Nodes[iLL1Node], m_inLL1Nodes[iLL1Node]);
   }
 
   // get trigger primitive nodes
-  for (const std::string& inPrimNode : m_config.inPrimNodes) {
-    m_inPrimNodes.push_back(
-      findNode::getClass<TriggerPrimitiveContainer>(topNode, inPrimNode)
-    );
-    if (!m_inPrimNodes.back()) {
-      std::cerr << PHWHERE << ": PANIC! Couldn't grab TriggerPrimitive node '" << inPrimNode << "'!" << std::endl;
-      assert(m_inPrimNodes.back());
-    }
+  m_inPrimNodes.resize(m_config.inPrimNodes.size());
+  for (size_t iPrimNode = 0; iPrimNode < m_config.inPrimNodes.size(); ++iPrimNode) {
+    BindInputNode(topNode, m_config.inPrimNodes[iPrimNode], m_inPrimNodes[iPrimNode]);
   }
   return;
 
@@ -265,25 +380,178 @@ void TriggerClusterMaker::GrabTriggerNodes(PHCompositeNode* topNode) {
 
 
 
+// ----------------------------------------------------------------------------
+//! Check that bound input nodes still point to their payloads
+// ----------------------------------------------------------------------------
+/*! Only compares cached pointers, so the cost per event is
+ *  constant in the number of events processed.
+ */
+void TriggerClusterMaker::ValidateInputNodes() {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterMaker::ValidateInputNodes() Validating input nodes");
+  TRGCLUST_TIME(m_instrument, TriggerClusterInstrument::GrabNodes);
+
+  for (auto& inTowerNode : m_inTowerNodes) {
+    RefreshInputNode(inTowerNode);
+  }
+  for (auto& inLL1Node : m_inLL1Nodes) {
+    RefreshInputNode(inLL1Node);
+  }
+  for (auto& inPrimNode : m_inPrimNodes) {
+    RefreshInputNode(inPrimNode);
+  }
+  return;
+
+}  // end 'ValidateInputNodes()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Map channel index of each tower onto its grid index in the engine
+// ----------------------------------------------------------------------------
+/*! The channel ordering of the tower containers follows the
+ *  readout, not (eta, phi), so the mapping is computed once
+ *  per run from the containers' own key decoding. Cells of
+ *  the combined retower grid are keyed like HCal towers.
+ */
+void TriggerClusterMaker::MapTowerChannels() {
+
+  // print debug message
+  TRGCLUST_LOG(1, "TriggerClusterMaker::MapTowerChannels() Mapping tower channels onto grids");
+
+  std::vector<uint32_t> chanToGrid;
+  for (uint32_t iCal = 0; iCal < m_inTowerNodes.size(); ++iCal) {
+
+    TowerInfoContainer*            towers = m_inTowerNodes[iCal].data;
+    const TriggerClusterTowerGrid& grid   = m_engine.GetTowerGrid(iCal);
+
+    // packed channels assume one channel per grid cell
+    if (towers -> size() > grid.Size()) {
+      std::cerr << PHWHERE << ": PANIC! Tower node '" << m_inTowerNodes[iCal].name << "' has more channels than towers! Aborting!" << std::endl;
+      assert(towers -> size() <= grid.Size());
+    }
+
+    // map each channel onto grid, and each
+    // packed channel back to a key
+    const uint32_t offset = TriggerClusterBuffer::GetChannelOffset(iCal);
+    chanToGrid.resize(towers -> size());
+    m_chanToKey.resize(std::max<std::size_t>(m_chanToKey.size(), offset + grid.Size()), 0);
+    for (uint32_t iChan = 0; iChan < towers -> size(); ++iChan) {
+      const uint32_t key = towers -> encode_key(iChan);
+      chanToGrid[iChan] = grid.Index(
+        towers -> getTowerEtaBin(key),
+        towers -> getTowerPhiBin(key)
+      );
+      m_chanToKey[offset + iChan] = key;
+    }
+    m_engine.MapChannels(iCal, chanToGrid);
+  }  // end layer loop
+
+  // map combined grid cells onto keys
+  const uint32_t nCombEta   = TriggerClusterMakerDefs::CalTraits<TriggerClusterMakerDefs::Cal::IH>::nEta;
+  const uint32_t nCombPhi   = TriggerClusterMakerDefs::CalTraits<TriggerClusterMakerDefs::Cal::IH>::nPhi;
+  const uint32_t combOffset = TriggerClusterBuffer::GetChannelOffset(TriggerClusterBuffer::AllLayers);
+  m_chanToKey.resize(std::max<std::size_t>(m_chanToKey.size(), combOffset + (nCombEta * nCombPhi)), 0);
+  for (uint32_t iEta = 0; iEta < nCombEta; ++iEta) {
+    for (uint32_t iPhi = 0; iPhi < nCombPhi; ++iPhi) {
+      m_chanToKey[combOffset + (iEta * nCombPhi) + iPhi] = TriggerClusterMakerDefs::GetKeyFromEtaPhiIndex<TriggerClusterMakerDefs::Cal::IH>(iEta, iPhi);
+    }
+  }
+  return;
+
+}  // end 'MapTowerChannels()
+
+
+
+// ----------------------------------------------------------------------------
+//! Copy tower energies and statuses into the engine's grids
+// ----------------------------------------------------------------------------
+/*! This is the only place towers are read from the input
+ *  containers; all downstream cluster building reads from
+ *  the engine's grids. Bad and listed channels are masked
+ *  here as well, so per-tower status checks are never
+ *  needed downstream.
+ */
+void TriggerClusterMaker::SnapshotTowers() {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterMaker::SnapshotTowers() Copying towers into snapshot");
+  TRGCLUST_TIME(m_instrument, TriggerClusterInstrument::TowerLookup);
+
+  for (uint32_t iCal = 0; iCal < m_inTowerNodes.size(); ++iCal) {
+
+    TowerInfoContainer*      towers = m_inTowerNodes[iCal].data;
+    TriggerClusterTowerGrid& grid   = m_engine.GetTowerGrid(iCal);
+    const uint32_t*          index  = m_engine.GetChannelMap(iCal).data();
+    const uint32_t           nChan  = m_engine.GetChannelMap(iCal).size();
+
+    // zero grid in case any channels are missing
+    grid.Reset();
+    for (uint32_t iChan = 0; iChan < nChan; ++iChan) {
+      TowerInfo* tower = towers -> get_tower_at_channel(iChan);
+      if (!tower) continue;
+      grid.energy[index[iChan]] = tower -> get_energy();
+      grid.status[index[iChan]] = tower -> get_status();
+    }
+
+    // then drop bad and listed channels
+    m_engine.MaskTowers(iCal);
+  }  // end layer loop
+
+  // print debug message
+  TRGCLUST_LOG(2, "    Masked " << m_engine.GetNMaskedTowers() << " towers, removing " << m_engine.GetMaskedEnergy() << " GeV");
+  TRGCLUST_COUNT(m_instrument, TriggerClusterInstrument::TowersMasked, m_engine.GetNMaskedTowers());
+  return;
+
+}  // end 'SnapshotTowers()'
+
+
+
 // ----------------------------------------------------------------------------
 //! Process a node of LL1s
 // ----------------------------------------------------------------------------
+/*! Each trigger word's sum key is decoded into a layer and
+ *  a patch on the retower grid, and handed to the engine,
+ *  which turns fired patches into clusters.
+ */
 void TriggerClusterMaker::ProcessLL1s(LL1Out* lloNode) {
 
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterMaker::ProcessLL1s(LL1Out*) Building clusters from LL1 trigger words");
+  TRGCLUST_TIME(m_instrument, TriggerClusterInstrument::LL1s);
+
+  // determine threshold
+  const uint32_t threshold = (m_config.ll1Threshold > 0) ? m_config.ll1Threshold : lloNode -> getThreshold();
+
   // loop over trigger words
+  m_engine.ResetLL1s();
   LL1Outv1::Range lloWordRange = lloNode -> getTriggerWords();
   for (
     LL1Outv1::Iter itTrgWord = lloWordRange.first;
     itTrgWord != lloWordRange.second;
     ++itTrgWord
   ) {
+    const std::vector<unsigned int>* samples = (*itTrgWord).second;
+    if (!samples) continue;
 
-    // FIXME figure out how to get trigger
-    //   - primitives from LL1Out
-    //auto word = (*itTrgWord).second;
-    //MakeCluster(word);
-
+    // locate word's patch
+    const uint32_t sumKey = (*itTrgWord).first;
+    const uint32_t cal    = TriggerClusterMakerDefs::GetCalFromDetector(
+      TriggerDefs::getDetectorId_from_TriggerSumKey(sumKey)
+    );
+    m_engine.AddLL1Word(
+      cal,
+      TriggerClusterMakerDefs::GetBin<TriggerClusterMakerDefs::Axis::Eta, TriggerClusterMakerDefs::Type::LL1>(sumKey),
+      TriggerClusterMakerDefs::GetBin<TriggerClusterMakerDefs::Axis::Phi, TriggerClusterMakerDefs::Type::LL1>(sumKey),
+      samples -> data(),
+      samples -> size(),
+      threshold
+    );
   }  // end trigger word loop
+
+  // turn fired patches into clusters
+  m_engine.ProcessLL1s();
   return;
 
 }  // end 'ProcessLL1s(LL1Out*)'
@@ -291,138 +559,439 @@ void TriggerClusterMaker::ProcessLL1s(LL1Out* lloNode) {
 
 
 // ----------------------------------------------------------------------------
-//! Process a node of trigger primitives
+//! Process all nodes of trigger primitives
 // ----------------------------------------------------------------------------
-void TriggerClusterMaker::ProcessPrimitives(TriggerPrimitiveContainer* primNode) {
+/*! Every primitive is handed to the engine as the list of
+ *  its sum IDs, tagged with the layer of its node; the
+ *  engine then builds all of them at once (across its
+ *  workers, if any).
+ */
+void TriggerClusterMaker::ProcessPrimitives() {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterMaker::ProcessPrimitives() Collecting trigger primitives");
+  TRGCLUST_TIME(m_instrument, TriggerClusterInstrument::Primitives);
+
+  // loop over nodes
+  for (auto& inPrimNode : m_inPrimNodes) {
+
+    // resolve layer once for the whole node
+    const uint32_t layer = GetNodeLayer(inPrimNode.data);
 
     // loop over primitives
+    TriggerPrimitiveContainerv1::Range trgPrimStoreRange = inPrimNode.data -> getTriggerPrimitives();
+    for (
+      TriggerPrimitiveContainerv1::Iter itTrgPrim = trgPrimStoreRange.first;
+      itTrgPrim != trgPrimStoreRange.second;
+      ++itTrgPrim
+    ) {
+      TriggerPrimitive* primitive = (*itTrgPrim).second;
+      if (!primitive) continue;
+      TRGCLUST_COUNT(m_instrument, TriggerClusterInstrument::PrimitivesSeen, 1);
+
+      // in sparse mode, skip zero-suppressed primitives
+      if (m_config.sparse && IsPrimitiveEmpty(primitive)) {
+        TRGCLUST_COUNT(m_instrument, TriggerClusterInstrument::PrimitivesSkipped, 1);
+        continue;
+      }
+
+      // look up sum IDs (and ADCs if needed)
+      //   - n.b. the sum vectors hold one LUT output per sample,
+      //     so the tower footprint only depends on the sum key
+      m_sumIDs.clear();
+      m_sumAdcs.clear();
+      TriggerPrimitivev1::Range trgPrimSumRange = primitive -> getSums();
+      for (
+        TriggerPrimitive::Iter itPrimSum = trgPrimSumRange.first;
+        itPrimSum != trgPrimSumRange.second;
+        ++itPrimSum
+      ) {
+        m_sumIDs.push_back( GetSumID((*itPrimSum).first, TriggerClusterMakerDefs::Type::Prim) );
+        if (m_config.sumAdcs) {
+          m_sumAdcs.push_back( GetPeakAdc((*itPrimSum).second) );
+        }
+      }
+      m_engine.AddPrimitive(layer, m_sumIDs.data(), m_sumIDs.size(), m_config.sumAdcs ? m_sumAdcs.data() : NULL);
+
+    }  // end trigger primitive loop
+  }  // end trigger primitive node loop
+
+  // build clusters
+  m_engine.ProcessPrimitives();
+  return;
+
+}  // end 'ProcessPrimitives()
+
+
+
+// ----------------------------------------------------------------------------
+//! Build clusters from sliding-window patches
+// ----------------------------------------------------------------------------
+/*! Patches are found and expanded entirely by the engine
+ *  from the towers already copied into it.
+ */
+void TriggerClusterMaker::ProcessPatches() {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterMaker::ProcessPatches() Building clusters from patches");
+  TRGCLUST_TIME(m_instrument, TriggerClusterInstrument::Patches);
+
+  m_engine.ProcessPatches();
+  return;
+
+}  // end 'ProcessPatches()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Build clusters from patches for every sweep configuration
+// ----------------------------------------------------------------------------
+/*! The engine shares retowered grids and integral images
+ *  across configurations, so towers are only processed once
+ *  however many configurations are swept.
+ */
+void TriggerClusterMaker::ProcessSweep() {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterMaker::ProcessSweep() Building clusters for " << m_sweepClusters.size() << " patch configurations");
+  TRGCLUST_TIME(m_instrument, TriggerClusterInstrument::Patches);
+
+  m_engine.ProcessSweep(m_sweepClusters);
+  return;
+
+}  // end 'ProcessSweep()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Convert a buffer of packed clusters into RawClusters
+// ----------------------------------------------------------------------------
+/*! Clusters built from LL1 words go into outLL1Node, all
+ *  others into outNode.
+ */
+void TriggerClusterMaker::UnpackClusters(
+  const TriggerClusterBuffer* clusters,
+  RawClusterContainer* outNode,
+  RawClusterContainer* outLL1Node
+) {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterMaker::UnpackClusters(TriggerClusterBuffer*, RawClusterContainer*, RawClusterContainer*) Unpacking " << clusters -> GetNClusters() << " clusters");
+  TRGCLUST_TIME(m_instrument, TriggerClusterInstrument::Insertion);
+
+  for (std::size_t iClust = 0; iClust < clusters -> GetNClusters(); ++iClust) {
+
+    // make a cluster and add towers to it
+    //   - n.b. the output container owns it
+    //     and deletes it when reset
+    const uint16_t* chans    = clusters -> GetChannels(iClust);
+    const float*    energies = clusters -> GetEnergies(iClust);
+    const uint32_t  nTowers  = clusters -> GetNTowers(iClust);
+
+    RawClusterv1* cluster = new RawClusterv1();
+    for (uint32_t iTow = 0; iTow < nTowers; ++iTow) {
+      cluster -> addTower(m_chanToKey[chans[iTow]], energies[iTow]);
+    }
+    cluster -> set_energy(clusters -> GetEnergy(iClust));
+
+    // put cluster in relevant output node
+    if (clusters -> GetSource(iClust) == TriggerClusterMakerDefs::Source::FromLL1) {
+      outLL1Node -> AddCluster(cluster);
+    } else {
+      outNode -> AddCluster(cluster);
+    }
+  }  // end cluster loop
+  return;
+
+}  // end 'UnpackClusters(TriggerClusterBuffer*, RawClusterContainer*, RawClusterContainer*)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Get calorimeter layer of a node of trigger primitives
+// ----------------------------------------------------------------------------
+/*! Determined from the first sum in the node. Returns the
+ *  max value of uint32_t if the node is empty.
+ */
+uint32_t TriggerClusterMaker::GetNodeLayer(TriggerPrimitiveContainer* primNode) {
+
   TriggerPrimitiveContainerv1::Range trgPrimStoreRange = primNode -> getTriggerPrimitives();
   for (
     TriggerPrimitiveContainerv1::Iter itTrgPrim = trgPrimStoreRange.first;
     itTrgPrim != trgPrimStoreRange.second;
     ++itTrgPrim
   ) {
-
-    // grab trigger primitve and decompose into clusters
     TriggerPrimitive* primitive = (*itTrgPrim).second;
     if (!primitive) continue;
 
-    // create new cluster and add primitive to it
-    RawClusterv1* cluster = new RawClusterv1();
-    AddPrimitiveToCluster(primitive, cluster);
-
-    // put cluster in output node
-    m_outClustNode -> AddCluster(cluster);
-
-  }  // end trigger primitive loop
-  return;
+    TriggerPrimitive::Range trgPrimSumRange = primitive -> getSums();
+    if (trgPrimSumRange.first != trgPrimSumRange.second) {
+      return TriggerClusterMakerDefs::GetCalFromDetector(
+        TriggerDefs::getDetectorId_from_TriggerSumKey((*trgPrimSumRange.first).first)
+      );
+    }
+  }
+  return std::numeric_limits<uint32_t>::max();
 
-}  // end 'ProcessPrimitives(TriggerPrimitiveContainer*)'
+}  // end 'GetNodeLayer(TriggerPrimitiveContainer*)'
 
 
 
 // ----------------------------------------------------------------------------
-//! Add primitive to a given cluster
+//! Check if an event passes the pre-filter
 // ----------------------------------------------------------------------------
-void TriggerClusterMaker::AddPrimitiveToCluster(TriggerPrimitive* primitive, RawClusterv1* cluster) {
+/*! Only reads the LL1 words and primitive sums already on
+ *  the node tree, and stops at the first word or sum over
+ *  threshold, so rejecting an event costs one pass over
+ *  its trigger words and sums and accepting one usually
+ *  far less.
+ */
+bool TriggerClusterMaker::PassesPrefilter() {
 
   // print debug message
-  if (m_config.debug && (Verbosity() > 1)) {
-    std::cout << "TriggerClusterMaker::MakeClustersFromPrimitive(TriggerPrimitive*) Making clusters from TriggerPrimitive object" << std::endl;
+  TRGCLUST_LOG(2, "TriggerClusterMaker::PassesPrefilter() Checking event against pre-filter");
+  TRGCLUST_TIME(m_instrument, TriggerClusterInstrument::Prefilter);
+
+  const bool checkSums = (m_config.filterSumThreshold > 0);
+  if (!m_config.filterOnLL1 && !checkSums) return true;
+
+  // check if any LL1 word fired
+  //   - n.b. a threshold of 0 disables the check for that
+  //     node, otherwise every word would pass
+  bool checkedLL1s = false;
+  if (m_config.filterOnLL1) {
+    for (auto& inLL1Node : m_inLL1Nodes) {
+      LL1Out*        lloNode   = inLL1Node.data;
+      const uint32_t threshold = (m_config.ll1Threshold > 0) ? m_config.ll1Threshold : lloNode -> getThreshold();
+      if (threshold == 0) continue;
+      checkedLL1s = true;
+
+      LL1Outv1::Range lloWordRange = lloNode -> getTriggerWords();
+      for (
+        LL1Outv1::Iter itTrgWord = lloWordRange.first;
+        itTrgWord != lloWordRange.second;
+        ++itTrgWord
+      ) {
+        if (HasSampleAbove((*itTrgWord).second, threshold)) return true;
+      }
+    }  // end LL1 node loop
+  }
+
+  // if no check was actually made, the event passes
+  if (!checkedLL1s && !checkSums) return true;
+
+  // then check if any primitive sum is large enough
+  if (checkSums) {
+    for (auto& inPrimNode : m_inPrimNodes) {
+      TriggerPrimitiveContainerv1::Range trgPrimStoreRange = inPrimNode.data -> getTriggerPrimitives();
+      for (
+        TriggerPrimitiveContainerv1::Iter itTrgPrim = trgPrimStoreRange.first;
+        itTrgPrim != trgPrimStoreRange.second;
+        ++itTrgPrim
+      ) {
+        TriggerPrimitive* primitive = (*itTrgPrim).second;
+        if (!primitive) continue;
+
+        TriggerPrimitivev1::Range trgPrimSumRange = primitive -> getSums();
+        for (
+          TriggerPrimitive::Iter itPrimSum = trgPrimSumRange.first;
+          itPrimSum != trgPrimSumRange.second;
+          ++itPrimSum
+        ) {
+          if (HasSampleAbove((*itPrimSum).second, m_config.filterSumThreshold)) return true;
+        }
+      }  // end trigger primitive loop
+    }  // end trigger primitive node loop
   }
+  return false;
+
+}  // end 'PassesPrefilter()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Check if any sample of a trigger word or sum reaches a threshold
+// ----------------------------------------------------------------------------
+bool TriggerClusterMaker::HasSampleAbove(const std::vector<unsigned int>* samples, const uint32_t threshold) {
+
+  if (!samples) return false;
+  return std::any_of(
+    samples -> begin(),
+    samples -> end(),
+    [threshold](const unsigned int sample) {return sample >= threshold;}
+  );
+
+}  // end 'HasSampleAbove(std::vector<unsigned int>*, uint32_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Check if every LUT output of a primitive is zero
+// ----------------------------------------------------------------------------
+/*! Reads the sum values already stored with the primitive,
+ *  so no towers or sum keys need to be looked up.
+ */
+bool TriggerClusterMaker::IsPrimitiveEmpty(TriggerPrimitive* primitive) {
 
-  // loop over sums
   TriggerPrimitivev1::Range trgPrimSumRange = primitive -> getSums();
   for (
     TriggerPrimitive::Iter itPrimSum = trgPrimSumRange.first;
     itPrimSum != trgPrimSumRange.second;
     ++itPrimSum
   ) {
+    const std::vector<unsigned int>* samples = (*itPrimSum).second;
+    if (!samples) continue;
 
-    // loop over summands
-    auto sum = (*itPrimSum).second;
-    for (
-      auto itSum = sum -> begin();
-      itSum != sum -> end();
-      ++itSum
-    ) {
+    const bool isZero = std::all_of(
+      samples -> begin(),
+      samples -> end(),
+      [](const unsigned int sample) {return sample == 0;}
+    );
+    if (!isZero) return false;
+  }
+  return true;
 
-      // get sum key and detector ID
-      auto sumKey = (*itPrimSum).first;
-      auto detID  = TriggerDefs::getDetectorId_from_TriggerSumKey(sumKey);
-      std::cout << "    CHECK-1 sum key = " << sumKey << ", detector ID = " << detID << std::endl;
+}  // end 'IsPrimitiveEmpty(TriggerPrimitive*)'
 
-      // get eta, phi bin of sum
-      const uint32_t iEtaStart = TriggerClusterMakerDefs::GetBin(
-        (*itPrimSum).first,
-         TriggerClusterMakerDefs::Axis::Eta,
-         TriggerClusterMakerDefs::Type::Prim
-      );
-      const uint32_t iPhiStart = TriggerClusterMakerDefs::GetBin(
-        (*itPrimSum).first,
-         TriggerClusterMakerDefs::Axis::Phi,
-         TriggerClusterMakerDefs::Type::Prim
-      );
 
-      // then iterate through towers in sum
-      /* TODO */
 
-      // grab tower key
-      const uint32_t towKey = TriggerClusterMakerDefs::GetKeyFromEtaPhiIndex(iEtaStart, iPhiStart, detID);
+// ----------------------------------------------------------------------------
+//! Get the peak LUT output of a primitive sum
+// ----------------------------------------------------------------------------
+/*! Same convention as the LL1 words, where a patch's ADC is
+ *  its peak over samples. Returns 0 if there are no samples.
+ */
+uint16_t TriggerClusterMaker::GetPeakAdc(const std::vector<unsigned int>* samples) {
 
-      // and finally grab tower
-      TowerInfo* tower = GetTowerFromKey(towKey, detID);
-      if (!tower) continue;
-      std::cout << "    CHECK0 (eta, phi) = (" << iEtaStart << ", " << iPhiStart << ")\n"
-                << "           key = " << towKey << ", tower = " << tower
-                << std::endl;
+  if (!samples || samples -> empty()) return 0;
 
-      // and add to custer
-      cluster -> addTower(towKey, tower -> get_energy());
+  const unsigned int peak = *std::max_element(samples -> begin(), samples -> end());
+  return std::min<unsigned int>(peak, std::numeric_limits<uint16_t>::max());
+
+}  // end 'GetPeakAdc(std::vector<unsigned int>*)'
 
-    }  // end tower loop
 
-  }  // end primitive sum loop
-  return;
 
-}  // end 'MakeClustersFromPrimitive(TriggerPrimitive*, RawClusterv1*)'
+// ----------------------------------------------------------------------------
+//! Get engine sum ID of a trigger sum key
+// ----------------------------------------------------------------------------
+/*! Sum keys are only decoded the first time they're seen;
+ *  afterwards, this is a single hash lookup. Returns the max
+ *  value of uint32_t if the key can't be mapped onto a sum
+ *  (which the engine then skips).
+ */
+uint32_t TriggerClusterMaker::GetSumID(const uint32_t sumKey, const uint32_t type) {
 
+  // check if key was already decoded
+  auto itSum = m_keyToSum[type].find(sumKey);
+  if (itSum != m_keyToSum[type].end()) {
+    return itSum -> second;
+  }
 
+  // otherwise make sure key points to a valid layer
+  uint32_t       sumID = std::numeric_limits<uint32_t>::max();
+  const uint32_t cal   = TriggerClusterMakerDefs::GetCalFromDetector(
+    TriggerDefs::getDetectorId_from_TriggerSumKey(sumKey)
+  );
+
+  // and look up sum in engine
+  if (cal <= TriggerClusterMakerDefs::Cal::OH) {
+    sumID = m_engine.GetSumTable().GetSumID(
+      cal,
+      type,
+      TriggerClusterMakerDefs::GetBin(sumKey, TriggerClusterMakerDefs::Axis::Eta, type),
+      TriggerClusterMakerDefs::GetBin(sumKey, TriggerClusterMakerDefs::Axis::Phi, type)
+    );
+  }
+  m_keyToSum[type].emplace(sumKey, sumID);
+  return sumID;
+
+}  // end 'GetSumID(uint32_t, uint32_t)
+
+
+
+// private templates ==========================================================
 
 // ----------------------------------------------------------------------------
-//! Grab tower from an input node based on key
+//! Create an output container and add it to the node tree
 // ----------------------------------------------------------------------------
-TowerInfo* TriggerClusterMaker::GetTowerFromKey(const uint32_t key, const uint32_t det) {
+/*! Persistent containers go on an I/O node, so they're
+ *  written out to DSTs; otherwise the container only lives
+ *  in memory for the rest of the event.
+ */
+template <typename T> void TriggerClusterMaker::AddOutNode(
+  PHCompositeNode* trgNode,
+  const std::string& name,
+  T*& container,
+  const bool persistent
+) {
 
-  // print debug message
-  if (m_config.debug && (Verbosity() > 2)) {
-    std::cout << "TriggerClusterMaker::GetTowerFromKey(uint32_t) Grabbing tower based on key..." << std::endl;
+  // create container for clusters
+  container = new T();
+
+  // and add node to tree
+  PHDataNode<PHObject>* clustNode = persistent
+    ? new PHIODataNode<PHObject>(container, name, "PHObject")
+    : new PHDataNode<PHObject>(container, name, "PHObject");
+  if (!clustNode) {
+    std::cerr << PHWHERE << ": PANIC! Couldn't create cluster node '" << name << "'! Aborting!" << std::endl;
+    assert(clustNode);
+  } else {
+    trgNode -> addNode(clustNode);
   }
+  return;
 
-  TowerInfo* tower;
-  switch (det) {
+}  // end 'AddOutNode(PHCompositeNode*, std::string&, T*&, bool)'
 
-    // get emcal tower index
-    case TriggerDefs::DetectorId::emcalDId:
-      tower = m_inTowerNodes[TriggerClusterMakerDefs::Cal::EM] -> get_tower_at_key(key);
-      break;
 
-    // get inner hcal tower index
-    case TriggerDefs::DetectorId::hcalinDId:
-      tower = m_inTowerNodes[TriggerClusterMakerDefs::Cal::IH] -> get_tower_at_key(key);
-      break;
 
-    case TriggerDefs::DetectorId::hcaloutDId:
-      tower = m_inTowerNodes[TriggerClusterMakerDefs::Cal::OH] -> get_tower_at_key(key);
-      break;
+// ----------------------------------------------------------------------------
+//! Look up an input node by name and cache a handle to it
+// ----------------------------------------------------------------------------
+template <typename T> void TriggerClusterMaker::BindInputNode(
+  PHCompositeNode* topNode,
+  const std::string& name,
+  TriggerClusterMakerInput<T>& input
+) {
+
+  // find node and cast payload
+  PHNodeIterator itNode(topNode);
+  input.name = name;
+  input.node = dynamic_cast<PHDataNode<PHObject>*>(itNode.findFirst(name));
+  input.data = input.node ? dynamic_cast<T*>(input.node -> getData()) : NULL;
+
+  // if missing, abort
+  if (!input.data) {
+    std::cerr << PHWHERE << ": PANIC! Couldn't grab input node '" << name << "'!" << std::endl;
+    assert(input.data);
+  }
+  return;
 
-    // otherwise return null
-    default:
-      tower = nullptr;
-      break;
+}  // end 'BindInputNode(PHCompositeNode*, std::string&, TriggerClusterMakerInput<T>&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Re-validate a cached input handle
+// ----------------------------------------------------------------------------
+/*! If the node's payload was swapped out (e.g. by an input
+ *  manager), the handle is rebound without searching the
+ *  node tree again.
+ */
+template <typename T> void TriggerClusterMaker::RefreshInputNode(TriggerClusterMakerInput<T>& input) {
+
+  // nothing to do if payload is unchanged
+  PHObject* payload = input.node -> getData();
+  if (payload == input.data) return;
+
+  // otherwise rebind, and abort if payload is now missing
+  input.data = dynamic_cast<T*>(payload);
+  if (!input.data) {
+    std::cerr << PHWHERE << ": PANIC! Input node '" << input.name << "' lost its payload!" << std::endl;
+    assert(input.data);
   }
-  return tower;
+  return;
 
-}  // end 'GetTowerFromKey(uint32_t, uint32_t)'
+}  // end 'RefreshInputNode(TriggerClusterMakerInput<T>&)'
 
 // end ------------------------------------------------------------------------
@@ -15,6 +15,7 @@
 // c++ utilities
 #include <array>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 // calo base
@@ -22,14 +23,21 @@
 // f4a libraries
 #include <fun4all/SubsysReco.h>
 // module utilities
+#include "TriggerClusterContainer.h"
+#include "TriggerClusterEngine.h"
+#include "TriggerClusterInstrument.h"
+#include "TriggerClusterLog.h"
 #include "TriggerClusterMakerDefs.h"
+#include "TriggerClusterPyramidContainer.h"
 
 // forward declarations
 class LL1Out;
 class PHCompositeNode;
+class PHObject;
 class RawClusterv1;
 class TowerInfoContainer;
 class TriggerPrimitiveContainer;
+template <class T> class PHDataNode;
 
 
 
@@ -39,10 +47,109 @@ class TriggerPrimitiveContainer;
 struct TriggerClusterMakerConfig {
 
   // general options
-  bool debug = true;
+  //   - debug messages are written if debug is set, up to
+  //     the module's Verbosity() (see TriggerClusterLog.h)
+  bool debug = false;
+
+  // cluster-building options
+  //   - Primitives: one cluster per trigger primitive
+  //   - Patches: one cluster per sliding-window patch
+  //   - Sweep: one set of patch clusters per configuration
+  //     in sweep, each in its own output node (see below)
+  //   - patches with cal = TriggerClusterPyramid::AllLayers
+  //     are full-calorimeter jet patches built from the
+  //     combined EMCal + HCal retower grid
+  uint32_t                               mode  = TriggerClusterMakerDefs::Mode::Primitives;
+  TriggerClusterPatchConfig              patch;
+  std::vector<TriggerClusterPatchConfig> sweep;
+
+  // no. of threads used to process trigger primitive nodes
+  //   - primitives are processed serially when <= 1
+  //   - events with fewer than minParallelPrims primitives
+  //     are processed serially regardless (see
+  //     TriggerClusterEngineConfig)
+  uint32_t nThreads         = 1;
+  uint32_t minParallelPrims = 1024;
+
+  // reuse sums shared between primitive nodes instead of
+  // expanding them again (see TriggerClusterSumCache)
+  bool cacheSums = true;
+
+  // sparse processing
+  //   - if set, primitives whose sums are all zero in the
+  //     trigger's own LUT outputs are skipped outright, and
+  //     the engine only builds primitives with at least one
+  //     sum above sparseThreshold (in GeV)
+  bool  sparse          = false;
+  float sparseThreshold = 0.;
+
+  // channel masking
+  //   - if set, towers with any of maskStatusBits in their
+  //     TowerInfo status (by default, any tower which isn't
+  //     get_isGood()) or listed in maskedChannels (as
+  //     TowerInfo channels, per layer) are zeroed before any
+  //     clusters are built
+  //   - off by default, since it changes cluster energies
+  //     relative to earlier output
+  bool                                 maskChannels   = false;
+  uint8_t                              maskStatusBits = TriggerClusterMakerDefs::BadStatusBits();
+  std::array<std::vector<uint32_t>, 3> maskedChannels;
+
+  // integer (ADC) sums
+  //   - if set, the peak LUT output of each primitive sum
+  //     is summed into each cluster alongside its energy,
+  //     saturating at adcMax (e.g. 0xFF to emulate an 8-bit
+  //     firmware adder), as is the peak ADC of LL1 patches
+  //   - n.b. like the energy fractions of jet patches, ADC
+  //     sums are only kept in Packed output
+  bool     sumAdcs = false;
+  uint16_t adcMax  = 0xFFFF;
+
+  // minimum peak ADC for an LL1 patch to fire
+  //   - if 0, the threshold stored in the LL1 node is used
+  uint32_t ll1Threshold = 0;
+
+  // event pre-filter
+  //   - if set, each event is checked before any towers are
+  //     read or clusters built, and is aborted (ABORTEVENT)
+  //     unless an LL1 word reaches the LL1 threshold (if
+  //     filterOnLL1) or a primitive sum reaches
+  //     filterSumThreshold ADC (if > 0)
+  //   - the LL1 check is skipped for any LL1 node whose
+  //     threshold (ll1Threshold, or the node's own if 0) is
+  //     0, since every word would pass it
+  //   - events pass if neither check is enabled
+  bool     prefilter          = false;
+  bool     filterOnLL1        = true;
+  uint32_t filterSumThreshold = 0;
 
   // output options
-  std::string outNodeName = "TriggerClusters";
+  //   - Raw: clusters are stored as RawClusters, and clusters
+  //     built from LL1 words go into their own node
+  //     (n.b. this allocates a RawCluster, plus a map node
+  //     per tower, for every cluster in every event)
+  //   - Packed: all clusters are stored in a single
+  //     TriggerClusterContainer, tagged by source
+  //   - n.b. the per-layer energy fractions of jet patches
+  //     have no place in a RawCluster, so they're only kept
+  //     in Packed output
+  //   - in Sweep mode, clusters of sweep[i] go into the
+  //     node '<outNodeName><outSweepSuffix><i>' of the same
+  //     type, while LL1 clusters are stored as above
+  uint32_t    output         = TriggerClusterMakerDefs::Output::Raw;
+  std::string outNodeName    = "TriggerClusters";
+  std::string outLL1NodeName = "TriggerClusters_LL1";
+  std::string outSweepSuffix = "_Sweep";
+
+  // energy pyramid options
+  //   - if set, the towers of each event are reduced to
+  //     retowers, primitives, and LL1s in one pass and put
+  //     on the node tree as a TriggerClusterPyramidContainer,
+  //     which patch building reads from as well
+  //   - n.b. the pyramid is only available to modules later
+  //     in the same event, and is never written out to DSTs
+  bool        makePyramid        = false;
+  std::string outPyramidNodeName = "TriggerClusterPyramid";
 
   // input trigger nodes
   std::vector<std::string> inLL1Nodes = {
@@ -57,6 +164,10 @@ struct TriggerClusterMakerConfig {
     "TRIGGERPRIMITIVES_HCALOUT"
   };
 
+  // file to write timing and counters to (.root or .json)
+  //   - only used if built with TRIGGERCLUSTER_INSTRUMENT
+  std::string instrumentFile = "";
+
   // input tower nodes
   std::string inEMCalTowerNode = "TOWERINFO_CALIB_CEMC";
   std::string inIHCalTowerNode = "TOWERINFO_CALIB_HCALIN";
@@ -66,6 +177,22 @@ struct TriggerClusterMakerConfig {
 
 
 
+// ----------------------------------------------------------------------------
+//! Run-scoped handle on an input node
+// ----------------------------------------------------------------------------
+/*! Input nodes are looked up by name once per run (in InitRun)
+ *  and cached here. Each event, the cached data pointer only
+ *  needs to be compared against the node's current payload,
+ *  so no string searches of the node tree are needed.
+ */
+template <typename T> struct TriggerClusterMakerInput {
+  std::string           name = "";
+  PHDataNode<PHObject>* node = NULL;
+  T*                    data = NULL;
+};
+
+
+
 // ----------------------------------------------------------------------------
 //! Makes Trigger Cluster
 // ----------------------------------------------------------------------------
@@ -74,6 +201,11 @@ struct TriggerClusterMakerConfig {
  *  i.e. "Trigger Clusters", for downstream analysis. Output
  *  clusters can be placed on the node tree, or saved to
  *  a TTree in a specified output file.
+ *
+ *  All of the cluster building is done by a
+ *  TriggerClusterEngine; this module only binds nodes,
+ *  translates towers, LL1 words, and sum keys into the
+ *  engine's inputs, and puts its output on the node tree.
  */
 class TriggerClusterMaker : public SubsysReco {
 
@@ -87,31 +219,94 @@ class TriggerClusterMaker : public SubsysReco {
     void SetConfig(const TriggerClusterMakerConfig& config) {m_config = config;}
 
     // getters
-    TriggerClusterMakerConfig GetConfig() {return m_config;}
+    TriggerClusterMakerConfig GetConfig()         {return m_config;}
+    uint64_t                  GetNAccepted() const {return m_nAccepted;}
+    uint64_t                  GetNRejected() const {return m_nRejected;}
 
     // f4a methods
     int Init(PHCompositeNode* topNode)          override;
+    int InitRun(PHCompositeNode* topNode)       override;
     int process_event(PHCompositeNode* topNode) override;
     int End(PHCompositeNode* topNode)           override;
 
   private:
 
     // private methods
-    void       InitOutNode(PHCompositeNode* topNode);
-    void       GrabTowerNodes(PHCompositeNode* topNode);
-    void       GrabTriggerNodes(PHCompositeNode* topNode);
-    void       ProcessLL1s(LL1Out* lloNode);
-    void       ProcessPrimitives(TriggerPrimitiveContainer* primNode);
-    void       AddPrimitiveToCluster(TriggerPrimitive* primitive, RawClusterv1* cluster);
-    TowerInfo* GetTowerFromKey(const uint32_t key, const uint32_t det);
+    void          InitOutNode(PHCompositeNode* topNode);
+    void          GrabTowerNodes(PHCompositeNode* topNode);
+    void          GrabTriggerNodes(PHCompositeNode* topNode);
+    void          ValidateInputNodes();
+    void          MapTowerChannels();
+    void          SnapshotTowers();
+    void          ProcessLL1s(LL1Out* lloNode);
+    void          ProcessPrimitives();
+    void          ProcessPatches();
+    void          ProcessSweep();
+    void          UnpackClusters(const TriggerClusterBuffer* clusters, RawClusterContainer* outNode, RawClusterContainer* outLL1Node);
+    uint32_t      GetNodeLayer(TriggerPrimitiveContainer* primNode);
+    bool          PassesPrefilter();
+    bool          HasSampleAbove(const std::vector<unsigned int>* samples, const uint32_t threshold);
+    bool          IsPrimitiveEmpty(TriggerPrimitive* primitive);
+    uint16_t      GetPeakAdc(const std::vector<unsigned int>* samples);
+    uint32_t      GetSumID(const uint32_t sumKey, const uint32_t type);
+
+    // private templates
+    template <typename T> void AddOutNode(PHCompositeNode* trgNode, const std::string& name, T*& container, const bool persistent = true);
+    template <typename T> void BindInputNode(PHCompositeNode* topNode, const std::string& name, TriggerClusterMakerInput<T>& input);
+    template <typename T> void RefreshInputNode(TriggerClusterMakerInput<T>& input);
 
     // input nodes
-    std::array<TowerInfoContainer*, 3>      m_inTowerNodes;
-    std::vector<LL1Out*>                    m_inLL1Nodes;
-    std::vector<TriggerPrimitiveContainer*> m_inPrimNodes;
+    std::array<TriggerClusterMakerInput<TowerInfoContainer>, 3>      m_inTowerNodes;
+    std::vector<TriggerClusterMakerInput<LL1Out>>                    m_inLL1Nodes;
+    std::vector<TriggerClusterMakerInput<TriggerPrimitiveContainer>> m_inPrimNodes;
+
+    // output nodes
+    RawClusterContainer*     m_outClustNode    = NULL;
+    RawClusterContainer*     m_outLL1ClustNode = NULL;
+    TriggerClusterContainer* m_outPackNode     = NULL;
+
+    // output nodes of each sweep configuration
+    std::vector<RawClusterContainer*>     m_outSweepClustNodes;
+    std::vector<TriggerClusterContainer*> m_outSweepPackNodes;
+
+    // output node of energy pyramid
+    TriggerClusterPyramidContainer* m_outPyramidNode = NULL;
+
+    // cluster engine
+    TriggerClusterEngine m_engine;
 
-    // output node
-    RawClusterContainer* m_outClustNode = NULL;
+    // clusters of the current event
+    //   - points to the packed output node, or to a buffer
+    //     which is unpacked into RawClusters at end of event
+    TriggerClusterBuffer* m_clusters = NULL;
+    TriggerClusterBuffer  m_clustBuffer;
+
+    // clusters of each sweep configuration
+    //   - as above, point to the packed output nodes or to
+    //     buffers which are unpacked at end of event
+    std::vector<TriggerClusterBuffer*> m_sweepClusters;
+    std::vector<TriggerClusterBuffer>  m_sweepBuffers;
+
+    // packed channel to tower key map
+    std::vector<uint32_t> m_chanToKey;
+
+    // memoized sum key to engine sum ID, per trigger type,
+    // and sum IDs and ADCs of the current primitive
+    std::array<std::unordered_map<uint32_t, uint32_t>, 2> m_keyToSum;
+    std::vector<uint32_t>                                 m_sumIDs;
+    std::vector<uint16_t>                                 m_sumAdcs;
+
+    // no. of events accepted and rejected by the pre-filter
+    uint64_t m_nAccepted = 0;
+    uint64_t m_nRejected = 0;
+
+    // buffered debug messages
+    TriggerClusterLogSink m_log;
+
+#ifdef TRIGGERCLUSTER_INSTRUMENT
+    // per-stage timing and counters
+    TriggerClusterInstrument m_instrument;
+#endif
 
     // module configuration
     TriggerClusterMakerConfig m_config;
@@ -5,6 +5,10 @@
  *
  *  Miscellaneous definitions for the TriggerClusterMaker
  *  fun4all module
+ *
+ *  n.b. nothing here depends on sPHENIX libraries, so that
+ *  the cluster engine can be built on its own; helpers for
+ *  sPHENIX tower and sum keys are in TriggerClusterKeys.h
  */
 // ----------------------------------------------------------------------------
 
@@ -12,13 +16,9 @@
 #define TRIGGERCLUSTERMAKERDEFS_H
 
 // c++ utilities
-#include <limits>
+#include <cstdint>
+#include <type_traits>
 #include <utility>
-// calo base
-#include <calobase/TowerInfoDefs.h>
-// trigger libraries
-//   - TODO use local paths when ready
-#include <calotrigger/TriggerDefs.h>
 
 
 
@@ -48,6 +48,49 @@ namespace TriggerClusterMakerDefs {
     LL1
   };
 
+  // cluster-building mode
+  enum Mode {
+    Primitives,
+    Patches,
+    Sweep
+  };
+
+  // what a cluster was built from
+  enum Source {
+    FromPrimitive,
+    FromLL1,
+    FromPatch
+  };
+
+  // granularity of an energy pyramid level
+  enum Level {
+    TowerLevel,
+    RetowerLevel,
+    PrimLevel,
+    LL1Level
+  };
+
+  // output format
+  enum Output {
+    Raw,
+    Packed
+  };
+
+  // what to do when asynchronous output falls behind
+  enum Backpressure {
+    Block,
+    Drop
+  };
+
+  // tower status bits, as set by TowerInfo
+  enum Status {
+    Hot,
+    BadTime,
+    BadChi2,
+    NotInstr,
+    NoCalib
+  };
+
 
 
   // constants ----------------------------------------------------------------
@@ -76,122 +119,151 @@ namespace TriggerClusterMakerDefs {
     return nTowInPrim;
   }
 
+  // --------------------------------------------------------------------------
+  //! No. of towers along a side of a trigger primitive sum
+  // --------------------------------------------------------------------------
+  inline uint32_t NTowInSum() {
+    static const uint32_t nTowInSum = 2;
+    return nTowInSum;
+  }
 
-
-  // methods ------------------------------------------------------------------
+  // --------------------------------------------------------------------------
+  //! No. of sums along a side of a trigger primitive
+  // --------------------------------------------------------------------------
+  inline uint32_t NSumInPrim() {
+    static const uint32_t nSumInPrim = 4;
+    return nSumInPrim;
+  }
 
   // --------------------------------------------------------------------------
-  //! Calculate eta/phi bin based on sum key
+  //! Status bits of a tower which shouldn't be used
   // --------------------------------------------------------------------------
-  uint32_t GetBin(const uint32_t sumkey, const uint32_t axis, const uint32_t type = Type::Prim) {
+  /*! Matches TowerInfo::get_isGood(): hot, bad chi2, not
+   *  instrumented, and uncalibrated towers.
+   */
+  inline uint8_t BadStatusBits() {
+    static const uint8_t badStatusBits = (1 << Status::Hot) | (1 << Status::BadChi2) | (1 << Status::NotInstr) | (1 << Status::NoCalib);
+    return badStatusBits;
+  }
 
-    // get relevant sum and primitive IDs
-    uint32_t sumID;
-    uint32_t primID;
-    switch (axis) {
-      case Axis::Eta:
-        sumID  = TriggerDefs::getSumEtaId(sumkey);
-        primID = TriggerDefs::getPrimitiveEtaId_from_TriggerSumKey(sumkey);
-        break;
-      case Axis::Phi:
-        sumID  = TriggerDefs::getSumPhiId(sumkey);
-        primID = TriggerDefs::getPrimitivePhiId_from_TriggerSumKey(sumkey);
-        break;
-      default:
-        sumID  = std::numeric_limits<uint32_t>::max();
-        primID = std::numeric_limits<uint32_t>::max();
-        break;
-    }
 
-    // get relevant segmentation
-    uint32_t segment;
-    switch (type) {
-      case Type::LL1:
-        segment = NTowInLL1();
-        break;
-      case Type::Prim:
-        [[fallthrough]];
-      default:
-        segment = NTowInPrim();
-        break;
-    }
-    return sumID + (segment * primID);
 
-  }  // end 'GetBin(uint32_t, uint32_t, uint32_t)'
+  // geometry traits ----------------------------------------------------------
 
+  // --------------------------------------------------------------------------
+  //! Compile-time geometry of a calorimeter layer
+  // --------------------------------------------------------------------------
+  template <uint32_t C> struct CalTraits;
 
+  template <> struct CalTraits<Cal::EM> {
+    static constexpr uint32_t nEta   = 96;
+    static constexpr uint32_t nPhi   = 256;
+    static constexpr uint32_t nRetow = 4;
+  };
+
+  template <> struct CalTraits<Cal::IH> {
+    static constexpr uint32_t nEta   = 24;
+    static constexpr uint32_t nPhi   = 64;
+    static constexpr uint32_t nRetow = 1;
+  };
+
+  template <> struct CalTraits<Cal::OH> {
+    static constexpr uint32_t nEta   = 24;
+    static constexpr uint32_t nPhi   = 64;
+    static constexpr uint32_t nRetow = 1;
+  };
 
   // --------------------------------------------------------------------------
-  //! Get tower key based on provided eta, phi indices
+  //! Compile-time geometry of trigger sums and primitives in a layer
   // --------------------------------------------------------------------------
-  uint32_t GetKeyFromEtaPhiIndex(const uint32_t eta, const uint32_t phi, const uint32_t det) {
-
-    uint32_t key;
-    switch (det) {
+  /*! Primitive sums are 2x2 towers in every layer, with 4x4
+   *  sums per primitive. LL1 sums are one retower (4x4 EMCal
+   *  towers or one HCal tower), with 4x4 sums per LL1.
+   */
+  template <uint32_t C, uint32_t T> struct SumTraits {
+    static constexpr uint32_t nTowInSum  = (T == Type::LL1) ? CalTraits<C>::nRetow : 2;
+    static constexpr uint32_t nSumInPrim = 4;
+    static constexpr uint32_t nTowInPrim = nTowInSum * nSumInPrim;
+    static constexpr uint32_t nTowers    = nTowInSum * nTowInSum;
+    static constexpr uint32_t nSumEta    = CalTraits<C>::nEta / nTowInSum;
+    static constexpr uint32_t nSumPhi    = CalTraits<C>::nPhi / nTowInSum;
+  };
 
-      // get emcal tower index
-      case TriggerDefs::DetectorId::emcalDId:
-        key = TowerInfoDefs::encode_emcal(eta, phi);
+  // --------------------------------------------------------------------------
+  //! Call a functor with a layer as a compile-time constant
+  // --------------------------------------------------------------------------
+  /*! Lets callers resolve the layer once (e.g. per node) and
+   *  then run fully specialized code. Unknown layers are
+   *  treated as the EMCal.
+   */
+  template <typename F> inline void DispatchCal(const uint32_t cal, F&& func) {
+    switch (cal) {
+      case Cal::IH:
+        func(std::integral_constant<uint32_t, Cal::IH>());
         break;
-
-      // get hcal tower index
-      case TriggerDefs::DetectorId::hcalinDId:
-        [[fallthrough]];
-      case TriggerDefs::DetectorId::hcaloutDId:
-        [[fallthrough]];
-      case TriggerDefs::DetectorId::hcalDId:
-        key = TowerInfoDefs::encode_hcal(eta, phi);
+      case Cal::OH:
+        func(std::integral_constant<uint32_t, Cal::OH>());
         break;
-
-      // otherwise return dummy value
+      case Cal::EM:
+        [[fallthrough]];
       default:
-        key = std::numeric_limits<uint32_t>::max();
+        func(std::integral_constant<uint32_t, Cal::EM>());
         break;
     }
-    return key;
+  }
 
-  } //  end 'GetKeyFromEtaPhiIndex(uint32_t, uint32_t, uint32_t)'
+  // --------------------------------------------------------------------------
+  //! No. of towers along eta for a calorimeter layer
+  // --------------------------------------------------------------------------
+  inline uint32_t NEtaTowers(const uint32_t cal) {
+    return (cal == Cal::EM) ? CalTraits<Cal::EM>::nEta : CalTraits<Cal::IH>::nEta;
+  }
+
+  // --------------------------------------------------------------------------
+  //! No. of towers along phi for a calorimeter layer
+  // --------------------------------------------------------------------------
+  inline uint32_t NPhiTowers(const uint32_t cal) {
+    return (cal == Cal::EM) ? CalTraits<Cal::EM>::nPhi : CalTraits<Cal::IH>::nPhi;
+  }
 
 
 
+  // methods ------------------------------------------------------------------
+
   // --------------------------------------------------------------------------
-  //! Get range of tower indices for a specified direction from a starting point
+  //! No. of towers along a side of a sum for a given layer and trigger type
   // --------------------------------------------------------------------------
-  std::pair<uint32_t, uint32_t> GetRangeOfIndices(
-    const uint32_t iStartTrg,
-    const uint32_t detector,
-    const uint32_t type = Type::Prim
-  ) {
-
-    uint32_t iStart;
-    uint32_t iStop;
-    switch (detector) {
+  /*! Primitive sums are 2x2 towers in every layer, while LL1 sums
+   *  are one retower: 4x4 EMCal towers or a single HCal tower.
+   */
+  inline uint32_t GetTowersInSum(const uint32_t cal, const uint32_t type = Type::Prim) {
 
-      // get max emcal tower index
-      case TriggerDefs::DetectorId::emcalDId:
-        iStart = iStartTrg;
-        iStop  = iStartTrg + (2 * NTowInRetow()) - 1;
+    uint32_t nTow;
+    switch (type) {
+      case Type::LL1:
+        nTow = (cal == Cal::EM) ? SumTraits<Cal::EM, Type::LL1>::nTowInSum : SumTraits<Cal::IH, Type::LL1>::nTowInSum;
         break;
-
-      // get max hcal tower index
-      case TriggerDefs::DetectorId::hcalinDId:
-        [[fallthrough]];
-      case TriggerDefs::DetectorId::hcaloutDId:
+      case Type::Prim:
         [[fallthrough]];
-      case TriggerDefs::DetectorId::hcalDId:
-        iStart = iStartTrg;  // TODO implement
-        iStop  = iStartTrg;  // TODO implement
-        break;
-
-      // otherwise set both to start
       default:
-        iStart = iStartTrg;
-        iStop  = iStartTrg;
+        nTow = SumTraits<Cal::EM, Type::Prim>::nTowInSum;
         break;
     }
-    return std::make_pair(iStart, iStop);
+    return nTow;
+
+  }  // end 'GetTowersInSum(uint32_t, uint32_t)'
+
 
-  }  // end 'GetRangeOfIndeices(uint32_t, uint32_t, uint32_t)'
+
+  // --------------------------------------------------------------------------
+  //! Get range of tower indices spanned by a primitive in a given layer
+  // --------------------------------------------------------------------------
+  /*! Returns the first and last (inclusive) tower index along
+   *  one side of a primitive of type T starting at iStartTrg.
+   */
+  template <uint32_t C, uint32_t T> inline std::pair<uint32_t, uint32_t> GetRangeOfIndices(const uint32_t iStartTrg) {
+    return std::make_pair(iStartTrg, iStartTrg + SumTraits<C, T>::nTowInPrim - 1);
+  }
 
 }  // end TriggerClusterMakerDefs namespace
 
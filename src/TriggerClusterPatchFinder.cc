@@ -0,0 +1,148 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterPatchFinder.cc'
+ *  \authors Derek Anderson
+ *  \date    06.17.2024
+ *
+ *  Sliding-window patch finder for the
+ *  TriggerClusterMaker module
+ */
+// ----------------------------------------------------------------------------
+
+#define TRIGGERCLUSTERPATCHFINDER_CC
+
+// c++ utilities
+#include <algorithm>
+
+// class definition
+#include "TriggerClusterPatchFinder.h"
+
+
+
+// public methods =============================================================
+
+// ----------------------------------------------------------------------------
+//! Build summed-area table from a tower grid
+// ----------------------------------------------------------------------------
+void TriggerClusterPatchFinder::Build(const TriggerClusterTowerGrid& grid) {
+
+  Build(grid.energy.data(), grid.nEta, grid.nPhi);
+  return;
+
+}  // end 'Build(TriggerClusterTowerGrid&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Build summed-area table over an (eta, phi) ordered array
+// ----------------------------------------------------------------------------
+/*! Entry (i, j) of the table holds the sum of all towers
+ *  with eta < i and phi < j. Accumulation is done in double
+ *  so that differences of large partial sums stay precise.
+ */
+void TriggerClusterPatchFinder::Build(const float* energies, const uint32_t nEta, const uint32_t nPhi) {
+
+  m_nEta = nEta;
+  m_nPhi = nPhi;
+
+  // first row and column stay zero
+  const uint32_t nCol = m_nPhi + 1;
+  m_table.assign((m_nEta + 1) * nCol, 0.);
+
+  // accumulate row by row
+  for (uint32_t iEta = 0; iEta < m_nEta; ++iEta) {
+
+    const float*  towers = energies + (iEta * m_nPhi);
+    const double* below  = m_table.data() + (iEta * nCol);
+    double*       row    = m_table.data() + ((iEta + 1) * nCol);
+
+    double rowSum = 0.;
+    for (uint32_t iPhi = 0; iPhi < m_nPhi; ++iPhi) {
+      rowSum        += towers[iPhi];
+      row[iPhi + 1]  = below[iPhi + 1] + rowSum;
+    }
+  }  // end eta loop
+  return;
+
+}  // end 'Build(float*, uint32_t, uint32_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Get sum of a patch, wrapping around in phi
+// ----------------------------------------------------------------------------
+double TriggerClusterPatchFinder::GetSum(
+  const uint32_t iEta,
+  const uint32_t iPhi,
+  const uint32_t nEta,
+  const uint32_t nPhi
+) const {
+
+  // clamp eta to grid
+  const uint32_t etaHi = std::min(iEta + nEta, m_nEta);
+
+  // if patch doesn't cross phi boundary, it's one rectangle
+  const uint32_t phiHi = iPhi + nPhi;
+  if (phiHi <= m_nPhi) {
+    return GetRectangle(iEta, iPhi, etaHi, phiHi);
+  }
+
+  // otherwise split into two
+  return GetRectangle(iEta, iPhi, etaHi, m_nPhi) + GetRectangle(iEta, 0, etaHi, phiHi - m_nPhi);
+
+}  // end 'GetSum(uint32_t, uint32_t, uint32_t, uint32_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Find all patches above threshold
+// ----------------------------------------------------------------------------
+/*! Patches start at every stride along eta that keeps the
+ *  patch inside the grid, and at every stride along phi.
+ */
+void TriggerClusterPatchFinder::FindPatches(const TriggerClusterPatchConfig& config, std::vector<Patch>& patches) const {
+
+  patches.clear();
+  if ((config.nEta > m_nEta) || (config.nPhi > m_nPhi)) return;
+
+  const uint32_t strideEta = std::max(config.strideEta, 1U);
+  const uint32_t stridePhi = std::max(config.stridePhi, 1U);
+  for (uint32_t iEta = 0; (iEta + config.nEta) <= m_nEta; iEta += strideEta) {
+    for (uint32_t iPhi = 0; iPhi < m_nPhi; iPhi += stridePhi) {
+
+      const float energy = GetSum(iEta, iPhi, config.nEta, config.nPhi);
+      if (energy < config.minEnergy) continue;
+
+      Patch patch;
+      patch.iEta   = iEta;
+      patch.iPhi   = iPhi;
+      patch.energy = energy;
+      patches.push_back(patch);
+    }
+  }  // end patch loops
+  return;
+
+}  // end 'FindPatches(TriggerClusterPatchConfig&, std::vector<Patch>&)'
+
+
+
+// private methods ============================================================
+
+// ----------------------------------------------------------------------------
+//! Get sum of towers in [etaLo, etaHi) x [phiLo, phiHi)
+// ----------------------------------------------------------------------------
+double TriggerClusterPatchFinder::GetRectangle(
+  const uint32_t etaLo,
+  const uint32_t phiLo,
+  const uint32_t etaHi,
+  const uint32_t phiHi
+) const {
+
+  const uint32_t nCol = m_nPhi + 1;
+  return m_table[(etaHi * nCol) + phiHi]
+       - m_table[(etaLo * nCol) + phiHi]
+       - m_table[(etaHi * nCol) + phiLo]
+       + m_table[(etaLo * nCol) + phiLo];
+
+}  // end 'GetRectangle(uint32_t, uint32_t, uint32_t, uint32_t)'
+
+// end ------------------------------------------------------------------------
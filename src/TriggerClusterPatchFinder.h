@@ -0,0 +1,105 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterPatchFinder.h'
+ *  \authors Derek Anderson
+ *  \date    06.17.2024
+ *
+ *  Sliding-window patch finder for the
+ *  TriggerClusterMaker module
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERPATCHFINDER_H
+#define TRIGGERCLUSTERPATCHFINDER_H
+
+// c++ utilities
+#include <cstdint>
+#include <vector>
+// module utilities
+#include "TriggerClusterMakerDefs.h"
+#include "TriggerClusterTowerGrid.h"
+
+
+
+// ----------------------------------------------------------------------------
+//! Options for sliding-window patches
+// ----------------------------------------------------------------------------
+struct TriggerClusterPatchConfig {
+
+  // layer to build patches from
+  //   - TriggerClusterPyramid::AllLayers builds jet patches
+  //     from the sum of the EMCal and both HCal layers at
+  //     HCal granularity
+  uint32_t cal = TriggerClusterMakerDefs::Cal::EM;
+
+  // no. of towers along a side of a retower
+  //   - patches are built from retowers when > 1
+  //   - for AllLayers, in units of HCal towers
+  //   - must divide the no. of towers of the layer in both
+  //     eta and phi (e.g. 1, 2, 4, or 8 for the HCal)
+  uint32_t retower = 1;
+
+  // patch size (in retowers)
+  uint32_t nEta = 4;
+  uint32_t nPhi = 4;
+
+  // distance between patch origins (in retowers)
+  uint32_t strideEta = 1;
+  uint32_t stridePhi = 1;
+
+  // minimum energy for a patch to be kept
+  float minEnergy = 0.;
+
+};
+
+
+
+// ----------------------------------------------------------------------------
+//! Finds every overlapping eta-phi patch in a tower grid
+// ----------------------------------------------------------------------------
+/*! Builds a summed-area table (integral image) over a tower
+ *  grid, after which the energy of any rectangular patch is
+ *  available in O(1). Patches are not wrapped around in eta,
+ *  but are wrapped around in phi since phi is periodic: a
+ *  patch crossing the phi boundary is summed as two
+ *  rectangles.
+ */
+class TriggerClusterPatchFinder {
+
+  public:
+
+    // ------------------------------------------------------------------------
+    //! A found patch
+    // ------------------------------------------------------------------------
+    struct Patch {
+      uint32_t iEta   = 0;   // eta index of lower corner
+      uint32_t iPhi   = 0;   // phi index of lower corner
+      float    energy = 0.;  // summed energy
+    };
+
+    // ctor/dtor
+    TriggerClusterPatchFinder()  {};
+    ~TriggerClusterPatchFinder() {};
+
+    // public methods
+    void   Build(const TriggerClusterTowerGrid& grid);
+    void   Build(const float* energies, const uint32_t nEta, const uint32_t nPhi);
+    double GetSum(const uint32_t iEta, const uint32_t iPhi, const uint32_t nEta, const uint32_t nPhi) const;
+    void   FindPatches(const TriggerClusterPatchConfig& config, std::vector<Patch>& patches) const;
+
+  private:
+
+    // private methods
+    double GetRectangle(const uint32_t etaLo, const uint32_t phiLo, const uint32_t etaHi, const uint32_t phiHi) const;
+
+    // grid dimensions
+    uint32_t m_nEta = 0;
+    uint32_t m_nPhi = 0;
+
+    // summed-area table, (nEta + 1) x (nPhi + 1)
+    std::vector<double> m_table;
+
+};
+
+#endif
+
+// end ------------------------------------------------------------------------
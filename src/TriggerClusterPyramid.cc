@@ -0,0 +1,219 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterPyramid.cc'
+ *  \authors Derek Anderson
+ *  \date    07.16.2024
+ *
+ *  Multi-resolution calorimeter energy pyramid:
+ *  towers, retowers, primitives, and LL1s
+ */
+// ----------------------------------------------------------------------------
+
+#define TRIGGERCLUSTERPYRAMID_CC
+
+// c++ utilities
+#include <algorithm>
+#include <numeric>
+// module utilities
+#include "TriggerClusterKernels.h"
+
+// class definition
+#include "TriggerClusterPyramid.h"
+
+
+
+// public methods =============================================================
+
+// ----------------------------------------------------------------------------
+//! Size storage and zero every level
+// ----------------------------------------------------------------------------
+void TriggerClusterPyramid::Reset() {
+
+  m_energies.assign(GetSize(), 0.);
+  return;
+
+}  // end 'Reset()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Print total energy of each layer and level
+// ----------------------------------------------------------------------------
+void TriggerClusterPyramid::Print(std::ostream& os) const {
+
+  os << "Trigger cluster energy pyramid:" << std::endl;
+  for (uint32_t iCal = 0; iCal <= AllLayers; ++iCal) {
+    for (uint32_t iLevel = 0; iLevel < NLevels; ++iLevel) {
+      const std::size_t nCells = static_cast<std::size_t>(GetNEta(iCal, iLevel)) * GetNPhi(iCal, iLevel);
+      if (nCells == 0) continue;
+
+      const float* energies = GetEnergies(iCal, iLevel);
+      os << "  Layer " << iCal
+         << ", level " << iLevel
+         << ": " << GetNEta(iCal, iLevel) << " x " << GetNPhi(iCal, iLevel)
+         << ", energy = " << std::accumulate(energies, energies + nCells, 0.)
+         << std::endl;
+    }
+  }
+  return;
+
+}  // end 'Print(std::ostream&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Build every level from tower energies
+// ----------------------------------------------------------------------------
+/*! towers[cal] holds the (eta, phi) ordered tower energies
+ *  of each layer. Levels are reduced in cascade, each from
+ *  the level below, via TriggerClusterKernels::BlockSum().
+ */
+void TriggerClusterPyramid::Build(const std::array<const float*, 3>& towers) {
+
+  if (m_energies.size() != GetSize()) Reset();
+
+  // reduce each layer
+  for (uint32_t iCal = 0; iCal < towers.size(); ++iCal) {
+
+    float* level = m_energies.data() + GetOffset(iCal, TriggerClusterMakerDefs::Level::TowerLevel);
+    std::copy(towers[iCal], towers[iCal] + (GetNEta(iCal, 0) * GetNPhi(iCal, 0)), level);
+
+    for (uint32_t iLevel = 1; iLevel < NLevels; ++iLevel) {
+      const uint32_t factor = GetFactor(iCal, iLevel) / GetFactor(iCal, iLevel - 1);
+      const float*   below  = m_energies.data() + GetOffset(iCal, iLevel - 1);
+      float*         above  = m_energies.data() + GetOffset(iCal, iLevel);
+      if (factor > 1) {
+        TriggerClusterKernels::BlockSum(below, GetNEta(iCal, iLevel - 1), GetNPhi(iCal, iLevel - 1), factor, above);
+      } else {
+        std::copy(below, below + (GetNEta(iCal, iLevel) * GetNPhi(iCal, iLevel)), above);
+      }
+    }
+  }  // end layer loop
+
+  // sum layers at the retower level, then reduce
+  const uint32_t retower = TriggerClusterMakerDefs::Level::RetowerLevel;
+  const uint32_t nCells  = GetNEta(AllLayers, retower) * GetNPhi(AllLayers, retower);
+  float*         total   = m_energies.data() + GetOffset(AllLayers, retower);
+  std::fill(total, total + nCells, 0.);
+  for (uint32_t iCal = 0; iCal < AllLayers; ++iCal) {
+    const float* layer = GetEnergies(iCal, retower);
+    for (uint32_t iCell = 0; iCell < nCells; ++iCell) {
+      total[iCell] += layer[iCell];
+    }
+  }
+  for (uint32_t iLevel = retower + 1; iLevel < NLevels; ++iLevel) {
+    TriggerClusterKernels::BlockSum(
+      GetEnergies(AllLayers, iLevel - 1),
+      GetNEta(AllLayers, iLevel - 1),
+      GetNPhi(AllLayers, iLevel - 1),
+      GetFactor(AllLayers, iLevel) / GetFactor(AllLayers, iLevel - 1),
+      m_energies.data() + GetOffset(AllLayers, iLevel)
+    );
+  }
+  return;
+
+}  // end 'Build(std::array<float*, 3>&)'
+
+
+
+// static methods =============================================================
+
+// ----------------------------------------------------------------------------
+//! Get no. of towers along a side of a cell of a level
+// ----------------------------------------------------------------------------
+/*! For AllLayers, this is in units of HCal towers (EMCal
+ *  retowers).
+ */
+uint32_t TriggerClusterPyramid::GetFactor(const uint32_t cal, const uint32_t level) {
+
+  const uint32_t nRetow = (cal == TriggerClusterMakerDefs::Cal::EM) ? TriggerClusterMakerDefs::NTowInRetow() : 1;
+
+  uint32_t factor;
+  switch (level) {
+    case TriggerClusterMakerDefs::Level::RetowerLevel:
+      factor = nRetow;
+      break;
+    case TriggerClusterMakerDefs::Level::PrimLevel:
+      factor = nRetow * TriggerClusterMakerDefs::NTowInPrim();
+      break;
+    case TriggerClusterMakerDefs::Level::LL1Level:
+      factor = nRetow * TriggerClusterMakerDefs::NTowInLL1();
+      break;
+    case TriggerClusterMakerDefs::Level::TowerLevel:
+      [[fallthrough]];
+    default:
+      factor = 1;
+      break;
+  }
+  return factor;
+
+}  // end 'GetFactor(uint32_t, uint32_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Get no. of cells along eta of a level
+// ----------------------------------------------------------------------------
+uint32_t TriggerClusterPyramid::GetNEta(const uint32_t cal, const uint32_t level) {
+
+  if (cal == AllLayers) {
+    return (level == TriggerClusterMakerDefs::Level::TowerLevel) ? 0 : TriggerClusterMakerDefs::NEtaTowers(TriggerClusterMakerDefs::Cal::IH) / GetFactor(cal, level);
+  }
+  return TriggerClusterMakerDefs::NEtaTowers(cal) / GetFactor(cal, level);
+
+}  // end 'GetNEta(uint32_t, uint32_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Get no. of cells along phi of a level
+// ----------------------------------------------------------------------------
+uint32_t TriggerClusterPyramid::GetNPhi(const uint32_t cal, const uint32_t level) {
+
+  if (cal == AllLayers) {
+    return (level == TriggerClusterMakerDefs::Level::TowerLevel) ? 0 : TriggerClusterMakerDefs::NPhiTowers(TriggerClusterMakerDefs::Cal::IH) / GetFactor(cal, level);
+  }
+  return TriggerClusterMakerDefs::NPhiTowers(cal) / GetFactor(cal, level);
+
+}  // end 'GetNPhi(uint32_t, uint32_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Get index of first cell of a layer and level in storage
+// ----------------------------------------------------------------------------
+/*! Offsets only depend on the geometry, so they are tabulated
+ *  on the first call.
+ */
+std::size_t TriggerClusterPyramid::GetOffset(const uint32_t cal, const uint32_t level) {
+
+  typedef std::array<std::array<std::size_t, NLevels>, AllLayers + 2> Table;
+
+  static const Table offsets = []() {
+    Table       table;
+    std::size_t offset = 0;
+    for (uint32_t iCal = 0; iCal < table.size(); ++iCal) {
+      for (uint32_t iLevel = 0; iLevel < NLevels; ++iLevel) {
+        table[iCal][iLevel] = offset;
+        if (iCal <= AllLayers) {
+          offset += static_cast<std::size_t>(GetNEta(iCal, iLevel)) * GetNPhi(iCal, iLevel);
+        }
+      }
+    }
+    return table;
+  }();
+  return offsets[cal][level];
+
+}  // end 'GetOffset(uint32_t, uint32_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Get total no. of cells across every layer and level
+// ----------------------------------------------------------------------------
+std::size_t TriggerClusterPyramid::GetSize() {
+
+  return GetOffset(AllLayers + 1, 0);
+
+}  // end 'GetSize()'
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,85 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterPyramid.h'
+ *  \authors Derek Anderson
+ *  \date    07.16.2024
+ *
+ *  Multi-resolution calorimeter energy pyramid:
+ *  towers, retowers, primitives, and LL1s
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERPYRAMID_H
+#define TRIGGERCLUSTERPYRAMID_H
+
+// c++ utilities
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+// module utilities
+#include "TriggerClusterMakerDefs.h"
+
+
+
+// ----------------------------------------------------------------------------
+//! Energy pyramid of every calorimeter layer
+// ----------------------------------------------------------------------------
+/*! Holds the energies of each layer at every granularity of
+ *  TriggerClusterMakerDefs::Level, as (eta, phi) ordered
+ *  grids (index = (eta * nPhi) + phi):
+ *
+ *    - TowerLevel:   native towers
+ *    - RetowerLevel: NTowInRetow() x NTowInRetow() EMCal
+ *                    towers, or single HCal towers (24 x 64)
+ *    - PrimLevel:    NTowInPrim() x NTowInPrim() retowers
+ *    - LL1Level:     NTowInLL1() x NTowInLL1() retowers
+ *
+ *  Each level is reduced from the one below it, so the
+ *  whole pyramid costs one pass over the towers. Besides
+ *  the three layers, AllLayers holds the sum of all of them
+ *  from RetowerLevel up (it has no TowerLevel, since the
+ *  layers have different tower sizes).
+ *
+ *  This has no framework dependencies so that the cluster
+ *  engine can fill it directly; TriggerClusterPyramidContainer
+ *  wraps it for the node tree.
+ */
+class TriggerClusterPyramid {
+
+  public:
+
+    // no. of levels, and index of the sum of all layers
+    static constexpr uint32_t NLevels   = TriggerClusterMakerDefs::Level::LL1Level + 1;
+    static constexpr uint32_t AllLayers = TriggerClusterMakerDefs::Cal::OH + 1;
+
+    // ctor/dtor
+    TriggerClusterPyramid()  {Reset();};
+    ~TriggerClusterPyramid() {};
+
+    // public methods
+    void Reset();
+    void Print(std::ostream& os = std::cout) const;
+    void Build(const std::array<const float*, 3>& towers);
+
+    // getters
+    const float* GetEnergies(const uint32_t cal, const uint32_t level) const {return m_energies.data() + GetOffset(cal, level);}
+    float        GetEnergy(const uint32_t cal, const uint32_t level, const uint32_t iEta, const uint32_t iPhi) const {return GetEnergies(cal, level)[(iEta * GetNPhi(cal, level)) + iPhi];}
+
+    // static methods
+    static uint32_t    GetFactor(const uint32_t cal, const uint32_t level);
+    static uint32_t    GetNEta(const uint32_t cal, const uint32_t level);
+    static uint32_t    GetNPhi(const uint32_t cal, const uint32_t level);
+    static std::size_t GetOffset(const uint32_t cal, const uint32_t level);
+    static std::size_t GetSize();
+
+  private:
+
+    // energies of every layer and level, back to back
+    std::vector<float> m_energies;
+
+};
+
+#endif
+
+// end ------------------------------------------------------------------------
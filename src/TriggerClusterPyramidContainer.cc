@@ -0,0 +1,31 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterPyramidContainer.cc'
+ *  \authors Derek Anderson
+ *  \date    07.16.2024
+ *
+ *  Node-tree storage for the multi-resolution
+ *  calorimeter energy pyramid
+ */
+// ----------------------------------------------------------------------------
+
+#define TRIGGERCLUSTERPYRAMIDCONTAINER_CC
+
+// class definition
+#include "TriggerClusterPyramidContainer.h"
+
+
+
+// PHObject methods ===========================================================
+
+// ----------------------------------------------------------------------------
+//! Print contents
+// ----------------------------------------------------------------------------
+void TriggerClusterPyramidContainer::identify(std::ostream& os) const {
+
+  os << "TriggerClusterPyramidContainer:" << std::endl;
+  Print(os);
+  return;
+
+}  // end 'identify(std::ostream&)'
+
+// end ------------------------------------------------------------------------
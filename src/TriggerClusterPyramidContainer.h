@@ -0,0 +1,53 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterPyramidContainer.h'
+ *  \authors Derek Anderson
+ *  \date    07.16.2024
+ *
+ *  Node-tree storage for the multi-resolution
+ *  calorimeter energy pyramid
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERPYRAMIDCONTAINER_H
+#define TRIGGERCLUSTERPYRAMIDCONTAINER_H
+
+// c++ utilities
+#include <iostream>
+// phool libraries
+#include <phool/PHObject.h>
+// module utilities
+#include "TriggerClusterPyramid.h"
+
+
+
+// ----------------------------------------------------------------------------
+//! Energy pyramid on the node tree
+// ----------------------------------------------------------------------------
+/*! Puts a TriggerClusterPyramid on the node tree, so that
+ *  downstream modules can read towers, retowers, primitives,
+ *  or LL1s without reducing the towers themselves. All of
+ *  the storage and accessors live in the pyramid, see there
+ *  for the layout.
+ */
+class TriggerClusterPyramidContainer : public PHObject, public TriggerClusterPyramid {
+
+  public:
+
+    // ctor/dtor
+    TriggerClusterPyramidContainer()           {};
+    ~TriggerClusterPyramidContainer() override {};
+
+    // PHObject methods
+    void Reset() override {TriggerClusterPyramid::Reset();}
+    void identify(std::ostream& os = std::cout) const override;
+    int  isValid() const override {return 1;}
+
+  private:
+
+    ClassDefOverride(TriggerClusterPyramidContainer, 1)
+
+};
+
+#endif
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,20 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterPyramidContainerLinkDef.h'
+ *  \authors Derek Anderson
+ *  \date    07.16.2024
+ *
+ *  Node-tree storage for the multi-resolution
+ *  calorimeter energy pyramid
+ */
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#ifdef __CINT__
+
+#pragma link C++ class TriggerClusterPyramid+;
+#pragma link C++ class TriggerClusterPyramidContainer+;
+
+#endif  // end if __CINT__
+
+// end ------------------------------------------------------------------------
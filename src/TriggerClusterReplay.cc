@@ -0,0 +1,87 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterReplay.cc'
+ *  \authors Derek Anderson
+ *  \date    07.14.2024
+ *
+ *  Re-runs trigger clustering over a replay
+ *  file written by TriggerClusterReplayDumper
+ */
+// ----------------------------------------------------------------------------
+
+#define TRIGGERCLUSTERREPLAY_CC
+
+// c++ utilities
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+// module utilities
+#include "TriggerClusterBuffer.h"
+#include "TriggerClusterEngine.h"
+#include "TriggerClusterReplayReader.h"
+
+
+
+// ----------------------------------------------------------------------------
+//! Replay a file through the cluster engine
+// ----------------------------------------------------------------------------
+/*! Usage:
+ *    triggerclusterreplay <file> [mode] [nThreads] [ll1Threshold]
+ *
+ *  where mode is 0 for primitives and 1 for patches (see
+ *  TriggerClusterMakerDefs::Mode). Prints the no. of
+ *  clusters built and the replay rate.
+ */
+int main(int argc, char* argv[]) {
+
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <file> [mode] [nThreads] [ll1Threshold]" << std::endl;
+    return 1;
+  }
+
+  // parse arguments
+  const std::string inFile       = argv[1];
+  const uint32_t    mode         = (argc > 2) ? std::atoi(argv[2]) : TriggerClusterMakerDefs::Mode::Primitives;
+  const uint32_t    nThreads     = (argc > 3) ? std::atoi(argv[3]) : 1;
+  const uint32_t    ll1Threshold = (argc > 4) ? std::atoi(argv[4]) : 0;
+
+  // open file
+  TriggerClusterReplayReader reader;
+  reader.Open(inFile);
+
+  // set up engine
+  TriggerClusterEngineConfig config;
+  config.mode     = mode;
+  config.nThreads = nThreads;
+
+  TriggerClusterEngine engine;
+  engine.SetConfig(config);
+  engine.Init();
+  reader.MapChannels(engine);
+
+  // replay every event
+  TriggerClusterBuffer clusters;
+  uint64_t             nClusters = 0;
+  uint64_t             nTowers   = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (uint64_t iEvt = 0; iEvt < reader.GetNEvents(); ++iEvt) {
+    reader.Replay(iEvt, engine, &clusters, ll1Threshold);
+    nClusters += clusters.GetNClusters();
+    nTowers   += clusters.GetNTowers();
+  }
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  engine.End();
+
+  // report
+  std::cout << "TriggerClusterReplay: replayed " << reader.GetNEvents() << " events from '" << inFile << "'\n"
+            << "  clusters:  " << nClusters << " (" << nTowers << " towers)\n"
+            << "  time:      " << seconds << " s\n"
+            << "  rate:      " << ((seconds > 0.) ? reader.GetNEvents() / seconds : 0.) << " events/s"
+            << std::endl;
+  return 0;
+
+}  // end 'main(int, char*[])'
+
+// end ------------------------------------------------------------------------
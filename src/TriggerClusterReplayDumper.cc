@@ -0,0 +1,338 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterReplayDumper.cc'
+ *  \authors Derek Anderson
+ *  \date    07.14.2024
+ *
+ *  A Fun4All module to dump the inputs of the
+ *  TriggerClusterMaker into a replay file
+ */
+// ----------------------------------------------------------------------------
+
+#define TRIGGERCLUSTERREPLAYDUMPER_CC
+
+// c++ utilities
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <limits>
+// calo base
+#include <calobase/TowerInfo.h>
+#include <calobase/TowerInfoContainer.h>
+// trigger libraries
+#include <calotrigger/LL1Out.h>
+#include <calotrigger/LL1Outv1.h>
+#include <calotrigger/TriggerPrimitive.h>
+#include <calotrigger/TriggerPrimitivev1.h>
+#include <calotrigger/TriggerPrimitiveContainer.h>
+#include <calotrigger/TriggerPrimitiveContainerv1.h>
+// f4a libraries
+#include <fun4all/Fun4AllReturnCodes.h>
+// phool libraries
+#include <phool/getClass.h>
+#include <phool/phool.h>
+#include <phool/PHCompositeNode.h>
+
+// module definition
+#include "TriggerClusterReplayDumper.h"
+#include "TriggerClusterKeys.h"
+
+
+
+// ctor/dtor ==================================================================
+
+// ----------------------------------------------------------------------------
+//! Module constructor
+// ----------------------------------------------------------------------------
+TriggerClusterReplayDumper::TriggerClusterReplayDumper(const std::string &name) : SubsysReco(name) {
+
+  // print debug message
+  TRGCLUST_LOG(1, "TriggerClusterReplayDumper::TriggerClusterReplayDumper(const std::string &name) Calling ctor");
+
+}  // end ctor
+
+
+
+// ----------------------------------------------------------------------------
+//! Module destructor
+// ----------------------------------------------------------------------------
+TriggerClusterReplayDumper::~TriggerClusterReplayDumper() {
+
+  // print debug message
+  TRGCLUST_LOG(1, "TriggerClusterReplayDumper::~TriggerClusterReplayDumper() Calling dtor");
+
+}  // end dtor
+
+
+
+// fun4all methods ============================================================
+
+// ----------------------------------------------------------------------------
+//! Initialize module
+// ----------------------------------------------------------------------------
+int TriggerClusterReplayDumper::Init(PHCompositeNode* topNode) {
+
+  TRGCLUST_LOG(0, "TriggerClusterReplayDumper::Init(PHCompositeNode *topNode) Initializing");
+  m_log.Flush();
+  return Fun4AllReturnCodes::EVENT_OK;
+
+}  // end 'Init(PHCompositeNode*)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Map tower channels and open output file
+// ----------------------------------------------------------------------------
+/*! The channel maps are written once into the file header,
+ *  so the file is only opened for the first run.
+ */
+int TriggerClusterReplayDumper::InitRun(PHCompositeNode* topNode) {
+
+  TRGCLUST_LOG(0, "TriggerClusterReplayDumper::InitRun(PHCompositeNode *topNode) Opening replay file");
+
+  GrabTowerNodes(topNode);
+  if (!m_writer.IsOpen()) {
+    MapTowerChannels();
+    m_writer.Open(m_config.outFile, m_chanToGrid);
+  }
+  m_log.Flush();
+  return Fun4AllReturnCodes::EVENT_OK;
+
+}  // end 'InitRun(PHCompositeNode*)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Dump an event
+// ----------------------------------------------------------------------------
+int TriggerClusterReplayDumper::process_event(PHCompositeNode* topNode) {
+
+  TRGCLUST_LOG(0, "TriggerClusterReplayDumper::process_event(PHCompositeNode *topNode) Dumping Event");
+
+  m_writer.BeginEvent();
+
+  // dump towers
+  GrabTowerNodes(topNode);
+  DumpTowers();
+
+  // dump LL1s
+  for (const std::string& inLL1Node : m_config.inLL1Nodes) {
+    DumpLL1s( GrabNode<LL1Out>(topNode, inLL1Node) );
+  }
+
+  // dump trigger primitives
+  for (const std::string& inPrimNode : m_config.inPrimNodes) {
+    DumpPrimitives( GrabNode<TriggerPrimitiveContainer>(topNode, inPrimNode) );
+  }
+
+  m_writer.EndEvent();
+  m_log.Flush();
+  return Fun4AllReturnCodes::EVENT_OK;
+
+}  // end 'process_event(PHCompositeNode*)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Write event index and close file
+// ----------------------------------------------------------------------------
+int TriggerClusterReplayDumper::End(PHCompositeNode *topNode) {
+
+  TRGCLUST_LOG(0, "TriggerClusterReplayDumper::End(PHCompositeNode *topNode) Wrote " << m_writer.GetNEvents() << " events to '" << m_config.outFile << "'");
+
+  m_writer.Close();
+  m_log.Flush();
+  return Fun4AllReturnCodes::EVENT_OK;
+
+}  // end 'End(PHCompositeNode*)'
+
+
+
+// private methods ============================================================
+
+// ----------------------------------------------------------------------------
+//! Grab input tower nodes
+// ----------------------------------------------------------------------------
+void TriggerClusterReplayDumper::GrabTowerNodes(PHCompositeNode* topNode) {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterReplayDumper::GrabTowerNodes(PHCompositeNode*) Grabbing input tower nodes");
+
+  m_inTowerNodes[TriggerClusterMakerDefs::Cal::EM] = GrabNode<TowerInfoContainer>(topNode, m_config.inEMCalTowerNode);
+  m_inTowerNodes[TriggerClusterMakerDefs::Cal::IH] = GrabNode<TowerInfoContainer>(topNode, m_config.inIHCalTowerNode);
+  m_inTowerNodes[TriggerClusterMakerDefs::Cal::OH] = GrabNode<TowerInfoContainer>(topNode, m_config.inOHCalTowerNode);
+  return;
+
+}  // end 'GrabTowerNodes(PHCompositeNode*)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Map channel index of each tower onto its (eta, phi) grid index
+// ----------------------------------------------------------------------------
+/*! Same mapping as TriggerClusterMaker::MapTowerChannels(),
+ *  so that replayed clusters carry the same channels.
+ */
+void TriggerClusterReplayDumper::MapTowerChannels() {
+
+  // print debug message
+  TRGCLUST_LOG(1, "TriggerClusterReplayDumper::MapTowerChannels() Mapping tower channels onto grids");
+
+  for (uint32_t iCal = 0; iCal < m_inTowerNodes.size(); ++iCal) {
+    TowerInfoContainer* towers = m_inTowerNodes[iCal];
+    const uint32_t      nPhi   = TriggerClusterMakerDefs::NPhiTowers(iCal);
+
+    m_chanToGrid[iCal].resize(towers -> size());
+    for (uint32_t iChan = 0; iChan < towers -> size(); ++iChan) {
+      const uint32_t key = towers -> encode_key(iChan);
+      m_chanToGrid[iCal][iChan] = (towers -> getTowerEtaBin(key) * nPhi) + towers -> getTowerPhiBin(key);
+    }
+  }  // end layer loop
+  return;
+
+}  // end 'MapTowerChannels()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Dump tower energies and statuses in channel order
+// ----------------------------------------------------------------------------
+void TriggerClusterReplayDumper::DumpTowers() {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterReplayDumper::DumpTowers() Dumping towers");
+
+  for (uint32_t iCal = 0; iCal < m_inTowerNodes.size(); ++iCal) {
+    TowerInfoContainer* towers = m_inTowerNodes[iCal];
+    const uint32_t      nChan  = m_chanToGrid[iCal].size();
+
+    // missing channels are left zeroed
+    m_energies.assign(nChan, 0.);
+    m_statuses.assign(nChan, 0);
+    for (uint32_t iChan = 0; iChan < std::min<uint32_t>(nChan, towers -> size()); ++iChan) {
+      TowerInfo* tower = towers -> get_tower_at_channel(iChan);
+      if (!tower) continue;
+      m_energies[iChan] = tower -> get_energy();
+      m_statuses[iChan] = tower -> get_status();
+    }
+    m_writer.SetTowers(iCal, m_energies.data(), m_statuses.data(), nChan);
+  }  // end layer loop
+  return;
+
+}  // end 'DumpTowers()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Dump a node of LL1s
+// ----------------------------------------------------------------------------
+/*! Words are located on the retower grid the same way as in
+ *  TriggerClusterMaker::ProcessLL1s().
+ */
+void TriggerClusterReplayDumper::DumpLL1s(LL1Out* lloNode) {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterReplayDumper::DumpLL1s(LL1Out*) Dumping LL1 trigger words");
+
+  m_writer.AddLL1Node(lloNode -> getThreshold());
+
+  LL1Outv1::Range lloWordRange = lloNode -> getTriggerWords();
+  for (
+    LL1Outv1::Iter itTrgWord = lloWordRange.first;
+    itTrgWord != lloWordRange.second;
+    ++itTrgWord
+  ) {
+    const std::vector<unsigned int>* samples = (*itTrgWord).second;
+    if (!samples) continue;
+
+    const uint32_t sumKey = (*itTrgWord).first;
+    m_writer.AddLL1Word(
+      TriggerClusterMakerDefs::GetCalFromDetector(
+        TriggerDefs::getDetectorId_from_TriggerSumKey(sumKey)
+      ),
+      TriggerClusterMakerDefs::GetBin<TriggerClusterMakerDefs::Axis::Eta, TriggerClusterMakerDefs::Type::LL1>(sumKey),
+      TriggerClusterMakerDefs::GetBin<TriggerClusterMakerDefs::Axis::Phi, TriggerClusterMakerDefs::Type::LL1>(sumKey),
+      samples -> data(),
+      samples -> size()
+    );
+  }  // end trigger word loop
+  return;
+
+}  // end 'DumpLL1s(LL1Out*)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Dump a node of trigger primitives
+// ----------------------------------------------------------------------------
+/*! Each sum key is decoded into its layer and (eta, phi)
+ *  sum indices; the node's layer is taken from its first
+ *  sum, as in TriggerClusterMaker::GetNodeLayer().
+ */
+void TriggerClusterReplayDumper::DumpPrimitives(TriggerPrimitiveContainer* primNode) {
+
+  // print debug message
+  TRGCLUST_LOG(2, "TriggerClusterReplayDumper::DumpPrimitives(TriggerPrimitiveContainer*) Dumping trigger primitives");
+
+  uint32_t layer = std::numeric_limits<uint32_t>::max();
+
+  TriggerPrimitiveContainerv1::Range trgPrimStoreRange = primNode -> getTriggerPrimitives();
+  for (
+    TriggerPrimitiveContainerv1::Iter itTrgPrim = trgPrimStoreRange.first;
+    itTrgPrim != trgPrimStoreRange.second;
+    ++itTrgPrim
+  ) {
+    TriggerPrimitive* primitive = (*itTrgPrim).second;
+    if (!primitive) continue;
+
+    // locate each sum
+    m_sums.clear();
+    TriggerPrimitivev1::Range trgPrimSumRange = primitive -> getSums();
+    for (
+      TriggerPrimitive::Iter itPrimSum = trgPrimSumRange.first;
+      itPrimSum != trgPrimSumRange.second;
+      ++itPrimSum
+    ) {
+      const uint32_t sumKey = (*itPrimSum).first;
+      const uint32_t cal    = TriggerClusterMakerDefs::GetCalFromDetector(
+        TriggerDefs::getDetectorId_from_TriggerSumKey(sumKey)
+      );
+      if (layer == std::numeric_limits<uint32_t>::max()) {
+        layer = cal;
+      }
+
+      m_sums.push_back(
+        (cal > TriggerClusterMakerDefs::Cal::OH)
+          ? TriggerClusterReplayFormat::InvalidSum
+          : TriggerClusterReplayFormat::PackSum(
+              cal,
+              TriggerClusterMakerDefs::GetBin<TriggerClusterMakerDefs::Axis::Eta, TriggerClusterMakerDefs::Type::Prim>(sumKey),
+              TriggerClusterMakerDefs::GetBin<TriggerClusterMakerDefs::Axis::Phi, TriggerClusterMakerDefs::Type::Prim>(sumKey)
+            )
+      );
+    }  // end sum loop
+    m_writer.AddPrimitive(layer, m_sums.data(), m_sums.size());
+
+  }  // end trigger primitive loop
+  return;
+
+}  // end 'DumpPrimitives(TriggerPrimitiveContainer*)'
+
+
+
+// private templates ==========================================================
+
+// ----------------------------------------------------------------------------
+//! Grab a node, aborting if it's missing
+// ----------------------------------------------------------------------------
+template <typename T> T* TriggerClusterReplayDumper::GrabNode(PHCompositeNode* topNode, const std::string& name) {
+
+  T* node = findNode::getClass<T>(topNode, name);
+  if (!node) {
+    std::cerr << PHWHERE << ": PANIC! Couldn't grab input node '" << name << "'!" << std::endl;
+    assert(node);
+  }
+  return node;
+
+}  // end 'GrabNode(PHCompositeNode*, std::string&)'
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,137 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterReplayDumper.h'
+ *  \authors Derek Anderson
+ *  \date    07.14.2024
+ *
+ *  A Fun4All module to dump the inputs of the
+ *  TriggerClusterMaker into a replay file
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERREPLAYDUMPER_H
+#define TRIGGERCLUSTERREPLAYDUMPER_H
+
+// c++ utilities
+#include <array>
+#include <string>
+#include <vector>
+// f4a libraries
+#include <fun4all/SubsysReco.h>
+// module utilities
+#include "TriggerClusterLog.h"
+#include "TriggerClusterReplayWriter.h"
+
+// forward declarations
+class LL1Out;
+class PHCompositeNode;
+class TowerInfoContainer;
+class TriggerPrimitiveContainer;
+
+
+
+// ----------------------------------------------------------------------------
+//! Options for TriggerClusterReplayDumper module
+// ----------------------------------------------------------------------------
+/*! Input nodes default to those of TriggerClusterMakerConfig,
+ *  so that a replay sees exactly what the maker would.
+ */
+struct TriggerClusterReplayDumperConfig {
+
+  // general options
+  //   - debug messages are written if debug is set, up to
+  //     the module's Verbosity() (see TriggerClusterLog.h)
+  bool debug = false;
+
+  // output file
+  std::string outFile = "test.trgclust.replay";
+
+  // input trigger nodes
+  std::vector<std::string> inLL1Nodes = {
+    "LL1OUT_JET"
+  };
+  std::vector<std::string> inPrimNodes = {
+    "TRIGGERPRIMITIVES_JET",
+    "TRIGGERPRIMITIVES_EMCAL",
+    "TRIGGERPRIMITIVES_EMCAL_LL1",
+    "TRIGGERPRIMITIVES_HCAL_LL1",
+    "TRIGGERPRIMITIVES_HCALIN",
+    "TRIGGERPRIMITIVES_HCALOUT"
+  };
+
+  // input tower nodes
+  std::string inEMCalTowerNode = "TOWERINFO_CALIB_CEMC";
+  std::string inIHCalTowerNode = "TOWERINFO_CALIB_HCALIN";
+  std::string inOHCalTowerNode = "TOWERINFO_CALIB_HCALOUT";
+
+};
+
+
+
+// ----------------------------------------------------------------------------
+//! Dumps TriggerClusterMaker inputs to a replay file
+// ----------------------------------------------------------------------------
+/*! Writes calibrated towers of all three calorimeters, LL1
+ *  words, and trigger primitives of every event into a flat
+ *  binary file (see TriggerClusterReplayFormat.h), which
+ *  TriggerClusterReplayReader can then feed straight into a
+ *  TriggerClusterEngine. This way clustering options can be
+ *  iterated on without re-running the tower builders,
+ *  calibrations, and trigger emulator.
+ */
+class TriggerClusterReplayDumper : public SubsysReco {
+
+  public:
+
+    // ctor
+    TriggerClusterReplayDumper(const std::string& name = "TriggerClusterReplayDumper");
+    ~TriggerClusterReplayDumper() override;
+
+    // setters
+    void SetConfig(const TriggerClusterReplayDumperConfig& config) {m_config = config;}
+
+    // getters
+    TriggerClusterReplayDumperConfig GetConfig() {return m_config;}
+
+    // f4a methods
+    int Init(PHCompositeNode* topNode)          override;
+    int InitRun(PHCompositeNode* topNode)       override;
+    int process_event(PHCompositeNode* topNode) override;
+    int End(PHCompositeNode* topNode)           override;
+
+  private:
+
+    // private methods
+    void GrabTowerNodes(PHCompositeNode* topNode);
+    void MapTowerChannels();
+    void DumpTowers();
+    void DumpLL1s(LL1Out* lloNode);
+    void DumpPrimitives(TriggerPrimitiveContainer* primNode);
+
+    // private templates
+    template <typename T> T* GrabNode(PHCompositeNode* topNode, const std::string& name);
+
+    // input tower nodes
+    std::array<TowerInfoContainer*, 3> m_inTowerNodes = {NULL, NULL, NULL};
+
+    // channel to grid index maps
+    std::array<std::vector<uint32_t>, 3> m_chanToGrid;
+
+    // towers and packed sums of current event
+    std::vector<float>    m_energies;
+    std::vector<uint8_t>  m_statuses;
+    std::vector<uint32_t> m_sums;
+
+    // output file
+    TriggerClusterReplayWriter m_writer;
+
+    // buffered debug messages
+    TriggerClusterLogSink m_log;
+
+    // module configuration
+    TriggerClusterReplayDumperConfig m_config;
+
+};
+
+#endif
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,19 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterReplayDumperLinkDef.h'
+ *  \authors Derek Anderson
+ *  \date    07.14.2024
+ *
+ *  A Fun4All module to dump the inputs of the
+ *  TriggerClusterMaker into a replay file
+ */
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#ifdef __CINT__
+
+#pragma link C++ class TriggerClusterReplayDumper
+
+#endif  // end if __CINT__
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,152 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterReplayFormat.h'
+ *  \authors Derek Anderson
+ *  \date    07.14.2024
+ *
+ *  Layout of the flat binary files used to replay
+ *  trigger clustering without the waveform chain
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERREPLAYFORMAT_H
+#define TRIGGERCLUSTERREPLAYFORMAT_H
+
+// c++ utilities
+#include <cstdint>
+#include <cstring>
+
+
+
+// ----------------------------------------------------------------------------
+//! Definitions for trigger cluster replay files
+// ----------------------------------------------------------------------------
+/*! A replay file holds, for every event, the calibrated
+ *  tower energies and statuses of all three calorimeters,
+ *  the LL1 words, and the trigger primitives as located
+ *  sums. Everything is written in native byte order with
+ *  fixed-size records, so a memory-mapped file can be read
+ *  in place:
+ *
+ *    FileHeader
+ *    channel to grid maps: uint32_t[nChannels[cal]] per layer
+ *    events, each starting on an 8-byte boundary:
+ *      EventHeader
+ *      tower energies:  float[nChannels[cal]] per layer
+ *      tower statuses:  uint8_t[nChannels[cal]] per layer
+ *      LL1 nodes:       LL1Node[nLL1Nodes]
+ *      LL1 words:       Word[nWords]
+ *      LL1 samples:     uint32_t[nSamples]
+ *      primitives:      Primitive[nPrims]
+ *      primitive sums:  uint32_t[nSums] (see PackSum())
+ *    event index: uint64_t[nEvents], offset of each event
+ *
+ *  Sums are stored as (layer, eta, phi) locations rather
+ *  than sPHENIX sum keys or engine sum IDs, so files can be
+ *  replayed without sPHENIX libraries and don't depend on
+ *  how TriggerClusterSumTable orders its sums.
+ */
+namespace TriggerClusterReplayFormat {
+
+  // constants ----------------------------------------------------------------
+
+  // file identifier and layout version
+  static constexpr char     Magic[8] = {'T', 'R', 'G', 'C', 'L', 'R', 'E', 'P'};
+  static constexpr uint32_t Version  = 1;
+
+  // value of a sum which couldn't be located
+  static constexpr uint32_t InvalidSum = 0xFFFFFFFF;
+
+
+
+  // records ------------------------------------------------------------------
+
+  // --------------------------------------------------------------------------
+  //! Start of every replay file
+  // --------------------------------------------------------------------------
+  /*! nEvents and indexOffset are only filled when the file
+   *  is closed, so a file with indexOffset = 0 was not
+   *  closed properly and can't be read.
+   */
+  struct FileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t nChannels[3];
+    uint64_t nEvents;
+    uint64_t indexOffset;
+  };
+
+  // --------------------------------------------------------------------------
+  //! Start of every event
+  // --------------------------------------------------------------------------
+  struct EventHeader {
+    uint64_t size;       // bytes in event, including header and padding
+    uint32_t nLL1Nodes;
+    uint32_t nWords;
+    uint32_t nSamples;
+    uint32_t nPrims;
+    uint32_t nSums;
+    uint32_t padding;
+  };
+
+  // --------------------------------------------------------------------------
+  //! An LL1 node: its threshold and how many of the words are its own
+  // --------------------------------------------------------------------------
+  struct LL1Node {
+    uint32_t threshold;
+    uint32_t nWords;
+  };
+
+  // --------------------------------------------------------------------------
+  //! An LL1 word located on the retower grid
+  // --------------------------------------------------------------------------
+  struct Word {
+    uint32_t cal;
+    uint32_t iEta;
+    uint32_t iPhi;
+    uint32_t nSamples;
+  };
+
+  // --------------------------------------------------------------------------
+  //! A trigger primitive: its layer and no. of sums
+  // --------------------------------------------------------------------------
+  struct Primitive {
+    uint32_t layer;
+    uint32_t nSums;
+  };
+
+
+
+  // methods ------------------------------------------------------------------
+
+  // --------------------------------------------------------------------------
+  //! Pack a sum's layer and (eta, phi) indices into one word
+  // --------------------------------------------------------------------------
+  inline uint32_t PackSum(const uint32_t cal, const uint32_t iSumEta, const uint32_t iSumPhi) {
+    return ((cal & 0xFF) << 24) | ((iSumEta & 0xFFF) << 12) | (iSumPhi & 0xFFF);
+  }
+
+  inline uint32_t GetSumCal(const uint32_t sum) {return (sum >> 24) & 0xFF;}
+  inline uint32_t GetSumEta(const uint32_t sum) {return (sum >> 12) & 0xFFF;}
+  inline uint32_t GetSumPhi(const uint32_t sum) {return sum & 0xFFF;}
+
+  // --------------------------------------------------------------------------
+  //! Round a no. of bytes up to the next 8-byte boundary
+  // --------------------------------------------------------------------------
+  inline uint64_t Align(const uint64_t nBytes) {
+    return (nBytes + 7) & ~static_cast<uint64_t>(7);
+  }
+
+  // --------------------------------------------------------------------------
+  //! Check if a header starts a readable replay file
+  // --------------------------------------------------------------------------
+  inline bool IsValid(const FileHeader& header) {
+    return (std::memcmp(header.magic, Magic, sizeof(Magic)) == 0)
+        && (header.version == Version)
+        && (header.indexOffset > 0);
+  }
+
+}  // end TriggerClusterReplayFormat namespace
+
+#endif
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,257 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterReplayReader.cc'
+ *  \authors Derek Anderson
+ *  \date    07.14.2024
+ *
+ *  Memory-mapped reader of trigger cluster
+ *  replay files
+ */
+// ----------------------------------------------------------------------------
+
+#define TRIGGERCLUSTERREPLAYREADER_CC
+
+// c++ utilities
+#include <cassert>
+#include <iostream>
+#include <limits>
+// posix utilities
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// class definition
+#include "TriggerClusterReplayReader.h"
+
+
+
+// file methods ===============================================================
+
+// ----------------------------------------------------------------------------
+//! Map a replay file into memory and check its header
+// ----------------------------------------------------------------------------
+void TriggerClusterReplayReader::Open(const std::string& path) {
+
+  // close any previous file
+  Close();
+
+  // open and map file
+  m_fd = open(path.c_str(), O_RDONLY);
+  if (m_fd < 0) {
+    std::cerr << "TriggerClusterReplayReader::Open(std::string&): PANIC! Couldn't open replay file '" << path << "'! Aborting!" << std::endl;
+    assert(m_fd >= 0);
+  }
+
+  struct stat info;
+  fstat(m_fd, &info);
+  m_size = info.st_size;
+  if (m_size < sizeof(TriggerClusterReplayFormat::FileHeader)) {
+    std::cerr << "TriggerClusterReplayReader::Open(std::string&): PANIC! Replay file '" << path << "' is too small! Aborting!" << std::endl;
+    assert(m_size >= sizeof(TriggerClusterReplayFormat::FileHeader));
+  }
+
+  void* data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+  if (data == MAP_FAILED) {
+    std::cerr << "TriggerClusterReplayReader::Open(std::string&): PANIC! Couldn't map replay file '" << path << "'! Aborting!" << std::endl;
+    assert(data != MAP_FAILED);
+  }
+  madvise(data, m_size, MADV_SEQUENTIAL);
+  m_data = static_cast<const uint8_t*>(data);
+
+  // check header and locate index
+  m_header = reinterpret_cast<const TriggerClusterReplayFormat::FileHeader*>(m_data);
+  if (!TriggerClusterReplayFormat::IsValid(*m_header)) {
+    std::cerr << "TriggerClusterReplayReader::Open(std::string&): PANIC! '" << path << "' is not a complete replay file (version " << TriggerClusterReplayFormat::Version << ")! Aborting!" << std::endl;
+    assert(TriggerClusterReplayFormat::IsValid(*m_header));
+  }
+  if (m_header -> indexOffset + (m_header -> nEvents * sizeof(uint64_t)) > m_size) {
+    std::cerr << "TriggerClusterReplayReader::Open(std::string&): PANIC! Replay file '" << path << "' is truncated! Aborting!" << std::endl;
+    assert(m_header -> indexOffset + (m_header -> nEvents * sizeof(uint64_t)) <= m_size);
+  }
+  m_index = reinterpret_cast<const uint64_t*>(m_data + m_header -> indexOffset);
+
+  // copy out channel maps
+  const uint32_t* map = reinterpret_cast<const uint32_t*>(m_data + sizeof(TriggerClusterReplayFormat::FileHeader));
+  for (uint32_t iCal = 0; iCal < m_chanToGrid.size(); ++iCal) {
+    m_chanToGrid[iCal].assign(map, map + m_header -> nChannels[iCal]);
+    map += m_header -> nChannels[iCal];
+  }
+  return;
+
+}  // end 'Open(std::string&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Unmap and close file
+// ----------------------------------------------------------------------------
+void TriggerClusterReplayReader::Close() {
+
+  if (m_data) {
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+  }
+  if (m_fd >= 0) {
+    close(m_fd);
+  }
+  m_fd     = -1;
+  m_data   = NULL;
+  m_size   = 0;
+  m_header = NULL;
+  m_index  = NULL;
+  return;
+
+}  // end 'Close()'
+
+
+
+// event methods ==============================================================
+
+// ----------------------------------------------------------------------------
+//! Locate the records of an event
+// ----------------------------------------------------------------------------
+TriggerClusterReplayReader::Event TriggerClusterReplayReader::GetEvent(const uint64_t iEvent) const {
+
+  if (iEvent >= GetNEvents()) {
+    std::cerr << "TriggerClusterReplayReader::GetEvent(uint64_t): PANIC! Event " << iEvent << " is out of range! Aborting!" << std::endl;
+    assert(iEvent < GetNEvents());
+  }
+
+  // walk through the event's records in order
+  Event          event;
+  const uint8_t* cursor = m_data + m_index[iEvent];
+
+  event.header = reinterpret_cast<const TriggerClusterReplayFormat::EventHeader*>(cursor);
+  cursor      += sizeof(TriggerClusterReplayFormat::EventHeader);
+  for (uint32_t iCal = 0; iCal < event.energies.size(); ++iCal) {
+    event.energies[iCal] = reinterpret_cast<const float*>(cursor);
+    cursor              += m_header -> nChannels[iCal] * sizeof(float);
+  }
+  for (uint32_t iCal = 0; iCal < event.statuses.size(); ++iCal) {
+    event.statuses[iCal] = cursor;
+    cursor              += m_header -> nChannels[iCal] * sizeof(uint8_t);
+  }
+  event.ll1Nodes = reinterpret_cast<const TriggerClusterReplayFormat::LL1Node*>(cursor);
+  cursor        += event.header -> nLL1Nodes * sizeof(TriggerClusterReplayFormat::LL1Node);
+  event.words    = reinterpret_cast<const TriggerClusterReplayFormat::Word*>(cursor);
+  cursor        += event.header -> nWords * sizeof(TriggerClusterReplayFormat::Word);
+  event.samples  = reinterpret_cast<const uint32_t*>(cursor);
+  cursor        += event.header -> nSamples * sizeof(uint32_t);
+  event.prims    = reinterpret_cast<const TriggerClusterReplayFormat::Primitive*>(cursor);
+  cursor        += event.header -> nPrims * sizeof(TriggerClusterReplayFormat::Primitive);
+  event.sums     = reinterpret_cast<const uint32_t*>(cursor);
+  return event;
+
+}  // end 'GetEvent(uint64_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Give the engine the channel order of the file
+// ----------------------------------------------------------------------------
+/*! Must be called after TriggerClusterEngine::Init(), which
+ *  resets every layer to (eta, phi) order.
+ */
+void TriggerClusterReplayReader::MapChannels(TriggerClusterEngine& engine) const {
+
+  for (uint32_t iCal = 0; iCal < m_chanToGrid.size(); ++iCal) {
+    engine.MapChannels(iCal, m_chanToGrid[iCal]);
+  }
+  return;
+
+}  // end 'MapChannels(TriggerClusterEngine&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Run an event through an engine
+// ----------------------------------------------------------------------------
+/*! Mirrors TriggerClusterMaker::process_event(): towers are
+ *  set, each LL1 node is decoded, and then clusters are built
+ *  from primitives or patches according to the engine's
+ *  mode. If ll1Threshold is 0, the threshold stored with
+ *  each LL1 node is used. In Sweep mode, sweepClusters must
+ *  hold one buffer per sweep configuration.
+ */
+void TriggerClusterReplayReader::Replay(
+  const uint64_t iEvent,
+  TriggerClusterEngine& engine,
+  TriggerClusterBuffer* clusters,
+  const uint32_t ll1Threshold,
+  const std::vector<TriggerClusterBuffer*>* sweepClusters
+) {
+
+  const Event event = GetEvent(iEvent);
+  engine.BeginEvent(clusters);
+
+  // copy towers into engine
+  for (uint32_t iCal = 0; iCal < event.energies.size(); ++iCal) {
+    engine.SetTowers(iCal, event.energies[iCal], m_header -> nChannels[iCal], event.statuses[iCal]);
+  }
+
+  // loop over LL1 nodes
+  const TriggerClusterReplayFormat::Word* word   = event.words;
+  const uint32_t*                         sample = event.samples;
+  for (uint32_t iNode = 0; iNode < event.header -> nLL1Nodes; ++iNode) {
+    const uint32_t threshold = (ll1Threshold > 0) ? ll1Threshold : event.ll1Nodes[iNode].threshold;
+
+    engine.ResetLL1s();
+    for (uint32_t iWord = 0; iWord < event.ll1Nodes[iNode].nWords; ++iWord, ++word) {
+      engine.AddLL1Word(word -> cal, word -> iEta, word -> iPhi, sample, word -> nSamples, threshold);
+      sample += word -> nSamples;
+    }
+    engine.ProcessLL1s();
+  }  // end LL1 node loop
+
+  // build clusters according to mode
+  switch (engine.GetConfig().mode) {
+
+    // translate located sums into sum IDs
+    case TriggerClusterMakerDefs::Mode::Primitives:
+      {
+        const TriggerClusterSumTable& table = engine.GetSumTable();
+        const uint32_t*               sum   = event.sums;
+        for (uint32_t iPrim = 0; iPrim < event.header -> nPrims; ++iPrim) {
+          m_sumIDs.clear();
+          for (uint32_t iSum = 0; iSum < event.prims[iPrim].nSums; ++iSum, ++sum) {
+            const uint32_t cal = TriggerClusterReplayFormat::GetSumCal(*sum);
+            m_sumIDs.push_back(
+              ((*sum == TriggerClusterReplayFormat::InvalidSum) || (cal > TriggerClusterMakerDefs::Cal::OH))
+                ? std::numeric_limits<uint32_t>::max()
+                : table.GetSumID(
+                    cal,
+                    TriggerClusterMakerDefs::Type::Prim,
+                    TriggerClusterReplayFormat::GetSumEta(*sum),
+                    TriggerClusterReplayFormat::GetSumPhi(*sum)
+                  )
+            );
+          }
+          engine.AddPrimitive(event.prims[iPrim].layer, m_sumIDs.data(), m_sumIDs.size());
+        }
+        engine.ProcessPrimitives();
+      }
+      break;
+
+    // or scan sliding-window patches
+    case TriggerClusterMakerDefs::Mode::Patches:
+      engine.ProcessPatches();
+      break;
+
+    // or scan patches for every sweep configuration
+    case TriggerClusterMakerDefs::Mode::Sweep:
+      if (!sweepClusters) {
+        std::cerr << "TriggerClusterReplayReader::Replay(...): PANIC! No sweep outputs given in Sweep mode! Aborting!" << std::endl;
+        assert(sweepClusters);
+      }
+      engine.ProcessSweep(*sweepClusters);
+      break;
+
+    default:
+      break;
+  }
+
+  engine.EndEvent();
+  return;
+
+}  // end 'Replay(uint64_t, TriggerClusterEngine&, TriggerClusterBuffer*, uint32_t, std::vector<TriggerClusterBuffer*>*)'
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,101 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterReplayReader.h'
+ *  \authors Derek Anderson
+ *  \date    07.14.2024
+ *
+ *  Memory-mapped reader of trigger cluster
+ *  replay files
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERREPLAYREADER_H
+#define TRIGGERCLUSTERREPLAYREADER_H
+
+// c++ utilities
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+// module utilities
+#include "TriggerClusterBuffer.h"
+#include "TriggerClusterEngine.h"
+#include "TriggerClusterReplayFormat.h"
+
+
+
+// ----------------------------------------------------------------------------
+//! Reads a trigger cluster replay file and feeds it to an engine
+// ----------------------------------------------------------------------------
+/*! The file is memory-mapped, and events are read in place
+ *  through the offset index, so opening a file costs one
+ *  mmap and events can be visited in any order. Replaying
+ *  an event runs it through a TriggerClusterEngine the same
+ *  way TriggerClusterMaker would have:
+ *
+ *    reader.Open("run.trgclust");
+ *    engine.Init();
+ *    reader.MapChannels(engine);
+ *    for (uint64_t iEvt = 0; iEvt < reader.GetNEvents(); ++iEvt) {
+ *      reader.Replay(iEvt, engine, &clusters);
+ *    }
+ *
+ *  Events point into the mapped file, so they are only valid
+ *  until Close().
+ */
+class TriggerClusterReplayReader {
+
+  public:
+
+    // ------------------------------------------------------------------------
+    //! View of one event in the mapped file
+    // ------------------------------------------------------------------------
+    struct Event {
+      const TriggerClusterReplayFormat::EventHeader* header   = NULL;
+      std::array<const float*, 3>                    energies = {NULL, NULL, NULL};
+      std::array<const uint8_t*, 3>                  statuses = {NULL, NULL, NULL};
+      const TriggerClusterReplayFormat::LL1Node*     ll1Nodes = NULL;
+      const TriggerClusterReplayFormat::Word*        words    = NULL;
+      const uint32_t*                                samples  = NULL;
+      const TriggerClusterReplayFormat::Primitive*   prims    = NULL;
+      const uint32_t*                                sums     = NULL;
+    };
+
+    // ctor/dtor
+    TriggerClusterReplayReader()  {};
+    ~TriggerClusterReplayReader() {Close();}
+
+    // getters
+    bool                         IsOpen()                          const {return (m_data != NULL);}
+    uint64_t                     GetNEvents()                      const {return m_header ? m_header -> nEvents : 0;}
+    const std::vector<uint32_t>& GetChannelMap(const uint32_t cal) const {return m_chanToGrid[cal];}
+
+    // file methods
+    void Open(const std::string& path);
+    void Close();
+
+    // event methods
+    Event GetEvent(const uint64_t iEvent) const;
+    void  MapChannels(TriggerClusterEngine& engine) const;
+    void  Replay(const uint64_t iEvent, TriggerClusterEngine& engine, TriggerClusterBuffer* clusters, const uint32_t ll1Threshold = 0, const std::vector<TriggerClusterBuffer*>* sweepClusters = NULL);
+
+  private:
+
+    // mapped file
+    int                                           m_fd     = -1;
+    const uint8_t*                                m_data   = NULL;
+    std::size_t                                   m_size   = 0;
+    const TriggerClusterReplayFormat::FileHeader* m_header = NULL;
+    const uint64_t*                               m_index  = NULL;
+
+    // channel to grid maps of file
+    std::array<std::vector<uint32_t>, 3> m_chanToGrid;
+
+    // sum IDs of the current primitive
+    std::vector<uint32_t> m_sumIDs;
+
+};
+
+#endif
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,279 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterReplayWriter.cc'
+ *  \authors Derek Anderson
+ *  \date    07.14.2024
+ *
+ *  Writes events to a trigger cluster
+ *  replay file
+ */
+// ----------------------------------------------------------------------------
+
+#define TRIGGERCLUSTERREPLAYWRITER_CC
+
+// c++ utilities
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+// class definition
+#include "TriggerClusterReplayWriter.h"
+
+
+
+// file methods ===============================================================
+
+// ----------------------------------------------------------------------------
+//! Open a file and write its header and channel maps
+// ----------------------------------------------------------------------------
+/*! chanToGrid holds the grid index of every tower channel
+ *  per layer (see TriggerClusterEngine::MapChannels()), and
+ *  sets how many channels each event stores.
+ */
+void TriggerClusterReplayWriter::Open(const std::string& path, const std::array<std::vector<uint32_t>, 3>& chanToGrid) {
+
+  // close any previous file
+  Close();
+
+  m_file.open(path, std::ios::binary | std::ios::trunc);
+  if (!m_file.is_open()) {
+    std::cerr << "TriggerClusterReplayWriter::Open(std::string&, std::array<std::vector<uint32_t>, 3>&): PANIC! Couldn't open replay file '" << path << "'! Aborting!" << std::endl;
+    assert(m_file.is_open());
+  }
+  m_nBytes = 0;
+  m_index.clear();
+
+  // write placeholder header
+  //   - n.b. no. of events and index offset
+  //     are filled in on Close()
+  TriggerClusterReplayFormat::FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, TriggerClusterReplayFormat::Magic, sizeof(header.magic));
+  header.version = TriggerClusterReplayFormat::Version;
+  for (uint32_t iCal = 0; iCal < m_nChannels.size(); ++iCal) {
+    m_nChannels[iCal]      = chanToGrid[iCal].size();
+    header.nChannels[iCal] = m_nChannels[iCal];
+  }
+  Write(&header, 1);
+
+  // write channel maps
+  for (const std::vector<uint32_t>& map : chanToGrid) {
+    Write(map.data(), map.size());
+  }
+  Write<uint8_t>(NULL, TriggerClusterReplayFormat::Align(m_nBytes) - m_nBytes);
+  return;
+
+}  // end 'Open(std::string&, std::array<std::vector<uint32_t>, 3>&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Write event index and final header, then close file
+// ----------------------------------------------------------------------------
+void TriggerClusterReplayWriter::Close() {
+
+  if (!m_file.is_open()) return;
+
+  // write index
+  const uint64_t indexOffset = m_nBytes;
+  Write(m_index.data(), m_index.size());
+
+  // and fill in header
+  TriggerClusterReplayFormat::FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, TriggerClusterReplayFormat::Magic, sizeof(header.magic));
+  header.version     = TriggerClusterReplayFormat::Version;
+  header.nEvents     = m_index.size();
+  header.indexOffset = indexOffset;
+  std::copy(m_nChannels.begin(), m_nChannels.end(), header.nChannels);
+
+  m_file.seekp(0);
+  m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  m_file.close();
+  return;
+
+}  // end 'Close()'
+
+
+
+// event methods ==============================================================
+
+// ----------------------------------------------------------------------------
+//! Clear staged event
+// ----------------------------------------------------------------------------
+void TriggerClusterReplayWriter::BeginEvent() {
+
+  for (uint32_t iCal = 0; iCal < m_nChannels.size(); ++iCal) {
+    m_energies[iCal].assign(m_nChannels[iCal], 0.);
+    m_statuses[iCal].assign(m_nChannels[iCal], 0);
+  }
+  m_ll1Nodes.clear();
+  m_words.clear();
+  m_samples.clear();
+  m_prims.clear();
+  m_sums.clear();
+  return;
+
+}  // end 'BeginEvent()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Stage tower energies and statuses of a layer, in channel order
+// ----------------------------------------------------------------------------
+/*! statuses may be NULL, in which case they're zeroed.
+ *  Channels beyond those set in Open() are dropped.
+ */
+void TriggerClusterReplayWriter::SetTowers(
+  const uint32_t cal,
+  const float* energies,
+  const uint8_t* statuses,
+  const std::size_t nChannels
+) {
+
+  const std::size_t nChan = std::min<std::size_t>(nChannels, m_nChannels[cal]);
+  std::copy(energies, energies + nChan, m_energies[cal].begin());
+  if (statuses) {
+    std::copy(statuses, statuses + nChan, m_statuses[cal].begin());
+  }
+  return;
+
+}  // end 'SetTowers(uint32_t, float*, uint8_t*, std::size_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Start a new LL1 node
+// ----------------------------------------------------------------------------
+/*! Words added afterwards belong to this node until the
+ *  next call.
+ */
+void TriggerClusterReplayWriter::AddLL1Node(const uint32_t threshold) {
+
+  TriggerClusterReplayFormat::LL1Node node;
+  node.threshold = threshold;
+  node.nWords    = 0;
+  m_ll1Nodes.push_back(node);
+  return;
+
+}  // end 'AddLL1Node(uint32_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Stage an LL1 word located on the retower grid
+// ----------------------------------------------------------------------------
+void TriggerClusterReplayWriter::AddLL1Word(
+  const uint32_t cal,
+  const uint32_t iEta,
+  const uint32_t iPhi,
+  const unsigned int* samples,
+  const std::size_t nSamples
+) {
+
+  // words need a node to belong to
+  if (m_ll1Nodes.empty()) {
+    std::cerr << "TriggerClusterReplayWriter::AddLL1Word(...): PANIC! LL1 word added before any LL1 node! Aborting!" << std::endl;
+    assert(!m_ll1Nodes.empty());
+  }
+
+  TriggerClusterReplayFormat::Word word;
+  word.cal      = cal;
+  word.iEta     = iEta;
+  word.iPhi     = iPhi;
+  word.nSamples = nSamples;
+  m_words.push_back(word);
+  m_samples.insert(m_samples.end(), samples, samples + nSamples);
+  ++m_ll1Nodes.back().nWords;
+  return;
+
+}  // end 'AddLL1Word(uint32_t, uint32_t, uint32_t, unsigned int*, std::size_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Stage a primitive as its layer and packed sums
+// ----------------------------------------------------------------------------
+/*! Sums should be packed with TriggerClusterReplayFormat::
+ *  PackSum(), or be InvalidSum.
+ */
+void TriggerClusterReplayWriter::AddPrimitive(const uint32_t layer, const uint32_t* sums, const std::size_t nSums) {
+
+  TriggerClusterReplayFormat::Primitive prim;
+  prim.layer = layer;
+  prim.nSums = nSums;
+  m_prims.push_back(prim);
+  m_sums.insert(m_sums.end(), sums, sums + nSums);
+  return;
+
+}  // end 'AddPrimitive(uint32_t, uint32_t*, std::size_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Write staged event to file and record its offset
+// ----------------------------------------------------------------------------
+void TriggerClusterReplayWriter::EndEvent() {
+
+  // fill header
+  TriggerClusterReplayFormat::EventHeader header;
+  header.nLL1Nodes = m_ll1Nodes.size();
+  header.nWords    = m_words.size();
+  header.nSamples  = m_samples.size();
+  header.nPrims    = m_prims.size();
+  header.nSums     = m_sums.size();
+  header.padding   = 0;
+
+  // determine size of event
+  uint64_t size = sizeof(header);
+  for (uint32_t iCal = 0; iCal < m_nChannels.size(); ++iCal) {
+    size += m_nChannels[iCal] * (sizeof(float) + sizeof(uint8_t));
+  }
+  size += m_ll1Nodes.size() * sizeof(TriggerClusterReplayFormat::LL1Node);
+  size += m_words.size()    * sizeof(TriggerClusterReplayFormat::Word);
+  size += m_samples.size()  * sizeof(uint32_t);
+  size += m_prims.size()    * sizeof(TriggerClusterReplayFormat::Primitive);
+  size += m_sums.size()     * sizeof(uint32_t);
+  header.size = TriggerClusterReplayFormat::Align(size);
+
+  // write event
+  m_index.push_back(m_nBytes);
+  Write(&header, 1);
+  for (const std::vector<float>& energies : m_energies) {
+    Write(energies.data(), energies.size());
+  }
+  for (const std::vector<uint8_t>& statuses : m_statuses) {
+    Write(statuses.data(), statuses.size());
+  }
+  Write(m_ll1Nodes.data(), m_ll1Nodes.size());
+  Write(m_words.data(), m_words.size());
+  Write(m_samples.data(), m_samples.size());
+  Write(m_prims.data(), m_prims.size());
+  Write(m_sums.data(), m_sums.size());
+  Write<uint8_t>(NULL, header.size - size);
+  return;
+
+}  // end 'EndEvent()'
+
+
+
+// private templates ==========================================================
+
+// ----------------------------------------------------------------------------
+//! Write an array of records, or nData zero bytes if data is NULL
+// ----------------------------------------------------------------------------
+template <typename T> void TriggerClusterReplayWriter::Write(const T* data, const std::size_t nData) {
+
+  if (nData == 0) return;
+  if (data) {
+    m_file.write(reinterpret_cast<const char*>(data), nData * sizeof(T));
+  } else {
+    static const char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    m_file.write(zeros, nData * sizeof(T));
+  }
+  m_nBytes += nData * sizeof(T);
+  return;
+
+}  // end 'Write(T*, std::size_t)'
+
+// end ------------------------------------------------------------------------
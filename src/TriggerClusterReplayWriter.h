@@ -0,0 +1,99 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterReplayWriter.h'
+ *  \authors Derek Anderson
+ *  \date    07.14.2024
+ *
+ *  Writes events to a trigger cluster
+ *  replay file
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERREPLAYWRITER_H
+#define TRIGGERCLUSTERREPLAYWRITER_H
+
+// c++ utilities
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+// module utilities
+#include "TriggerClusterReplayFormat.h"
+
+
+
+// ----------------------------------------------------------------------------
+//! Writes a trigger cluster replay file
+// ----------------------------------------------------------------------------
+/*! Framework-free: callers translate their towers, LL1
+ *  words, and primitives into plain arrays, as they would
+ *  for TriggerClusterEngine. An event looks like:
+ *
+ *    writer.BeginEvent();
+ *    writer.SetTowers(cal, energies, statuses, nChannels);  // per layer
+ *    writer.AddLL1Node(threshold);                         // per LL1 node
+ *    writer.AddLL1Word(...);
+ *    writer.AddPrimitive(layer, sums, nSums);              // per primitive
+ *    writer.EndEvent();
+ *
+ *  Events are staged in memory and written out whole in
+ *  EndEvent(); the event index and final header are written
+ *  in Close(). See TriggerClusterReplayFormat.h for the
+ *  layout.
+ */
+class TriggerClusterReplayWriter {
+
+  public:
+
+    // ctor/dtor
+    TriggerClusterReplayWriter()  {};
+    ~TriggerClusterReplayWriter() {Close();}
+
+    // getters
+    bool     IsOpen()     const {return m_file.is_open();}
+    uint64_t GetNEvents() const {return m_index.size();}
+
+    // file methods
+    void Open(const std::string& path, const std::array<std::vector<uint32_t>, 3>& chanToGrid);
+    void Close();
+
+    // event methods
+    void BeginEvent();
+    void SetTowers(const uint32_t cal, const float* energies, const uint8_t* statuses, const std::size_t nChannels);
+    void AddLL1Node(const uint32_t threshold);
+    void AddLL1Word(const uint32_t cal, const uint32_t iEta, const uint32_t iPhi, const unsigned int* samples, const std::size_t nSamples);
+    void AddPrimitive(const uint32_t layer, const uint32_t* sums, const std::size_t nSums);
+    void EndEvent();
+
+  private:
+
+    // private templates
+    template <typename T> void Write(const T* data, const std::size_t nData);
+
+    // output file, no. of bytes written, and event index
+    std::ofstream         m_file;
+    uint64_t              m_nBytes = 0;
+    std::vector<uint64_t> m_index;
+
+    // no. of tower channels per layer
+    std::array<uint32_t, 3> m_nChannels = {0, 0, 0};
+
+    // staged towers of current event
+    std::array<std::vector<float>, 3>   m_energies;
+    std::array<std::vector<uint8_t>, 3> m_statuses;
+
+    // staged LL1s of current event
+    std::vector<TriggerClusterReplayFormat::LL1Node> m_ll1Nodes;
+    std::vector<TriggerClusterReplayFormat::Word>    m_words;
+    std::vector<uint32_t>                            m_samples;
+
+    // staged primitives of current event
+    std::vector<TriggerClusterReplayFormat::Primitive> m_prims;
+    std::vector<uint32_t>                              m_sums;
+
+};
+
+#endif
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,94 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterSPSCQueue.h'
+ *  \authors Derek Anderson
+ *  \date    07.02.2024
+ *
+ *  Bounded lock-free single-producer, single-consumer
+ *  queue for the TriggerCluster modules
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERSPSCQUEUE_H
+#define TRIGGERCLUSTERSPSCQUEUE_H
+
+// c++ utilities
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+
+
+// ----------------------------------------------------------------------------
+//! Bounded lock-free SPSC queue
+// ----------------------------------------------------------------------------
+/*! A ring buffer with one spare slot to tell full from
+ *  empty. Exactly one thread may Push() and exactly one
+ *  (other) thread may Pop(); neither ever blocks, so callers
+ *  decide how to wait when the queue is full or empty.
+ *  Resize() must only be called while neither thread is
+ *  using the queue.
+ */
+template <typename T> class TriggerClusterSPSCQueue {
+
+  public:
+
+    // ctor/dtor
+    TriggerClusterSPSCQueue()  {};
+    ~TriggerClusterSPSCQueue() {};
+
+    // ------------------------------------------------------------------------
+    //! Set capacity and clear queue
+    // ------------------------------------------------------------------------
+    void Resize(const std::size_t capacity) {
+      m_slots.assign(capacity + 1, T());
+      m_head.store(0, std::memory_order_relaxed);
+      m_tail.store(0, std::memory_order_relaxed);
+    }
+
+    // ------------------------------------------------------------------------
+    //! Add an item, returns false if queue is full (producer only)
+    // ------------------------------------------------------------------------
+    bool Push(const T& item) {
+      const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+      const std::size_t next = (tail + 1) % m_slots.size();
+      if (next == m_head.load(std::memory_order_acquire)) return false;
+
+      m_slots[tail] = item;
+      m_tail.store(next, std::memory_order_release);
+      return true;
+    }
+
+    // ------------------------------------------------------------------------
+    //! Remove an item, returns false if queue is empty (consumer only)
+    // ------------------------------------------------------------------------
+    bool Pop(T& item) {
+      const std::size_t head = m_head.load(std::memory_order_relaxed);
+      if (head == m_tail.load(std::memory_order_acquire)) return false;
+
+      item = m_slots[head];
+      m_head.store((head + 1) % m_slots.size(), std::memory_order_release);
+      return true;
+    }
+
+    // ------------------------------------------------------------------------
+    //! Check if queue is empty
+    // ------------------------------------------------------------------------
+    bool Empty() const {
+      return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+  private:
+
+    // slots
+    std::vector<T> m_slots;
+
+    // indices of next item to pop and next slot to push,
+    // kept on separate cache lines
+    alignas(64) std::atomic<std::size_t> m_head {0};
+    alignas(64) std::atomic<std::size_t> m_tail {0};
+
+};
+
+#endif
+
+// end ------------------------------------------------------------------------
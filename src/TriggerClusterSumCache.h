@@ -0,0 +1,139 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterSumCache.h'
+ *  \authors Derek Anderson
+ *  \date    07.17.2024
+ *
+ *  Per-event cache of trigger sums already
+ *  expanded into a cluster buffer
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERSUMCACHE_H
+#define TRIGGERCLUSTERSUMCACHE_H
+
+// c++ utilities
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+
+// ----------------------------------------------------------------------------
+//! Remembers where each sum's towers were written this event
+// ----------------------------------------------------------------------------
+/*! Several primitive nodes (e.g. the per-detector, LL1-level,
+ *  and jet nodes) are built from the same sums, so the same
+ *  sums get expanded into towers several times per event.
+ *  The first time a sum is expanded into a buffer, the
+ *  position of its towers and its energy are stored here,
+ *  keyed by sum ID (see TriggerClusterSumTable::GetSumID()).
+ *  Later visits copy the towers within the buffer instead
+ *  of gathering them from the tower grids again.
+ *
+ *  Entries are stamped with a generation number, so
+ *  invalidating the whole cache (once per event, or whenever
+ *  the towers or buffer change) is O(1). Entries only make
+ *  sense for the buffer they were recorded in, so each
+ *  buffer needs its own cache. When processing in parallel,
+ *  the engine records entries for its shared arrays of
+ *  pre-expanded sums instead, which every worker reads via
+ *  Peek().
+ */
+class TriggerClusterSumCache {
+
+  public:
+
+    // ------------------------------------------------------------------------
+    //! A cached sum
+    // ------------------------------------------------------------------------
+    struct Entry {
+      uint32_t first  = 0;   // index of sum's first tower in buffer
+      uint32_t size   = 0;   // no. of towers in sum
+      float    energy = 0.;  // summed energy
+    };
+
+    // ctor/dtor
+    TriggerClusterSumCache()  {};
+    ~TriggerClusterSumCache() {};
+
+    // getters
+    uint64_t GetNHits()   const {return m_nHits;}
+    uint64_t GetNMisses() const {return m_nMisses;}
+
+    // ------------------------------------------------------------------------
+    //! Size cache for a no. of sums and drop all entries
+    // ------------------------------------------------------------------------
+    void Resize(const std::size_t nSums) {
+      m_stamps.assign(nSums, 0);
+      m_entries.assign(nSums, Entry());
+      m_stamp = 1;
+    }
+
+    // ------------------------------------------------------------------------
+    //! Drop all entries
+    // ------------------------------------------------------------------------
+    /*! Stamps start at 0, so if the generation number ever
+     *  wraps around the stamps have to be cleared by hand.
+     */
+    void Invalidate() {
+      if (++m_stamp == 0) {
+        m_stamps.assign(m_stamps.size(), 0);
+        m_stamp = 1;
+      }
+    }
+
+    // ------------------------------------------------------------------------
+    //! Look up a sum, counting hits and misses
+    // ------------------------------------------------------------------------
+    /*! Returns NULL if the sum hasn't been expanded since the
+     *  last Invalidate(), or if the sum ID is out of range.
+     */
+    const Entry* Find(const uint32_t sumID) {
+      if ((sumID < m_stamps.size()) && (m_stamps[sumID] == m_stamp)) {
+        ++m_nHits;
+        return &m_entries[sumID];
+      }
+      ++m_nMisses;
+      return NULL;
+    }
+
+    // ------------------------------------------------------------------------
+    //! Look up a sum without counting
+    // ------------------------------------------------------------------------
+    /*! Safe to call from several threads at once, as long as
+     *  nothing is inserted meanwhile.
+     */
+    const Entry* Peek(const uint32_t sumID) const {
+      if ((sumID < m_stamps.size()) && (m_stamps[sumID] == m_stamp)) {
+        return &m_entries[sumID];
+      }
+      return NULL;
+    }
+
+    // ------------------------------------------------------------------------
+    //! Record an expanded sum
+    // ------------------------------------------------------------------------
+    void Insert(const uint32_t sumID, const uint32_t first, const uint32_t size, const float energy) {
+      if (sumID >= m_stamps.size()) return;
+      m_stamps[sumID]         = m_stamp;
+      m_entries[sumID].first  = first;
+      m_entries[sumID].size   = size;
+      m_entries[sumID].energy = energy;
+    }
+
+  private:
+
+    // generation stamp and entry of each sum ID
+    std::vector<uint32_t> m_stamps;
+    std::vector<Entry>    m_entries;
+    uint32_t              m_stamp = 1;
+
+    // hit/miss counters, accumulated over all events
+    uint64_t m_nHits   = 0;
+    uint64_t m_nMisses = 0;
+
+};
+
+#endif
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,123 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterSumTable.cc'
+ *  \authors Derek Anderson
+ *  \date    06.12.2024
+ *
+ *  Lookup table mapping trigger sums onto
+ *  the towers they were built from
+ */
+// ----------------------------------------------------------------------------
+
+#define TRIGGERCLUSTERSUMTABLE_CC
+
+// c++ utilities
+#include <cstddef>
+#include <limits>
+
+// class definition
+#include "TriggerClusterSumTable.h"
+
+
+
+// public methods =============================================================
+
+// ----------------------------------------------------------------------------
+//! Build table for all layers and trigger types
+// ----------------------------------------------------------------------------
+void TriggerClusterSumTable::Build() {
+
+  // reset any previous table
+  m_spans.clear();
+  m_towerIndices.clear();
+
+  // add spans for each type and layer
+  AddSpans<TriggerClusterMakerDefs::Cal::EM, TriggerClusterMakerDefs::Type::Prim>();
+  AddSpans<TriggerClusterMakerDefs::Cal::IH, TriggerClusterMakerDefs::Type::Prim>();
+  AddSpans<TriggerClusterMakerDefs::Cal::OH, TriggerClusterMakerDefs::Type::Prim>();
+  AddSpans<TriggerClusterMakerDefs::Cal::EM, TriggerClusterMakerDefs::Type::LL1>();
+  AddSpans<TriggerClusterMakerDefs::Cal::IH, TriggerClusterMakerDefs::Type::LL1>();
+  AddSpans<TriggerClusterMakerDefs::Cal::OH, TriggerClusterMakerDefs::Type::LL1>();
+  return;
+
+}  // end 'Build()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Get dense ID of a sum from its layer, type, and position
+// ----------------------------------------------------------------------------
+/*! The position is in units of sums along eta and phi.
+ *  Returns the max value of uint32_t if the sum isn't in
+ *  one of the three calorimeter layers, or is out of
+ *  acceptance.
+ */
+uint32_t TriggerClusterSumTable::GetSumID(
+  const uint32_t cal,
+  const uint32_t type,
+  const uint32_t iSumEta,
+  const uint32_t iSumPhi
+) const {
+
+  // make sure sum points to a valid layer and type
+  if ((cal > TriggerClusterMakerDefs::Cal::OH) || (type > TriggerClusterMakerDefs::Type::LL1)) {
+    return std::numeric_limits<uint32_t>::max();
+  }
+
+  // get segmentation of layer
+  const uint32_t nTowSum = TriggerClusterMakerDefs::GetTowersInSum(cal, type);
+  const uint32_t nSumEta = TriggerClusterMakerDefs::NEtaTowers(cal) / nTowSum;
+  const uint32_t nSumPhi = TriggerClusterMakerDefs::NPhiTowers(cal) / nTowSum;
+
+  // and make sure sum is in acceptance
+  if ((iSumEta >= nSumEta) || (iSumPhi >= nSumPhi)) {
+    return std::numeric_limits<uint32_t>::max();
+  }
+  return m_offsets[type][cal] + (iSumEta * nSumPhi) + iSumPhi;
+
+}  // end 'GetSumID(uint32_t, uint32_t, uint32_t, uint32_t)'
+
+
+
+// private templates ==========================================================
+
+// ----------------------------------------------------------------------------
+//! Add spans for every sum in a layer
+// ----------------------------------------------------------------------------
+/*! Segmentation is fixed at compile time via the layer and
+ *  trigger type, so the tower loops are fully specialized.
+ */
+template <uint32_t C, uint32_t T> void TriggerClusterSumTable::AddSpans() {
+
+  typedef TriggerClusterMakerDefs::CalTraits<C>    Layer;
+  typedef TriggerClusterMakerDefs::SumTraits<C, T> Sum;
+
+  // record where this block starts
+  m_offsets[T][C] = m_spans.size();
+
+  // loop over sums
+  for (uint32_t iSumEta = 0; iSumEta < Sum::nSumEta; ++iSumEta) {
+    for (uint32_t iSumPhi = 0; iSumPhi < Sum::nSumPhi; ++iSumPhi) {
+
+      Span span;
+      span.cal   = C;
+      span.start = m_towerIndices.size();
+      span.size  = Sum::nTowers;
+
+      // loop over towers in sum
+      for (uint32_t iTowEta = 0; iTowEta < Sum::nTowInSum; ++iTowEta) {
+        for (uint32_t iTowPhi = 0; iTowPhi < Sum::nTowInSum; ++iTowPhi) {
+
+          const uint32_t eta = (iSumEta * Sum::nTowInSum) + iTowEta;
+          const uint32_t phi = (iSumPhi * Sum::nTowInSum) + iTowPhi;
+          m_towerIndices.push_back( (eta * Layer::nPhi) + phi );
+        }
+      }  // end tower loops
+      m_spans.push_back(span);
+
+    }
+  }  // end sum loops
+  return;
+
+}  // end 'AddSpans<uint32_t, uint32_t>()'
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,84 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterSumTable.h'
+ *  \authors Derek Anderson
+ *  \date    06.12.2024
+ *
+ *  Lookup table mapping trigger sums onto
+ *  the towers they were built from
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERSUMTABLE_H
+#define TRIGGERCLUSTERSUMTABLE_H
+
+// c++ utilities
+#include <array>
+#include <cstdint>
+#include <vector>
+// module utilities
+#include "TriggerClusterMakerDefs.h"
+
+
+
+// ----------------------------------------------------------------------------
+//! Sum to tower lookup table
+// ----------------------------------------------------------------------------
+/*! The calorimeter and trigger geometry is fixed, so the
+ *  towers which feed into each trigger sum can be computed
+ *  once at initialization. Every sum (per calorimeter layer
+ *  and trigger type) is assigned a dense sum ID and a span
+ *  of contiguous entries in a flat array of (eta, phi) grid
+ *  indices, so expanding a sum is a flat gather over its
+ *  span.
+ *
+ *  The table knows nothing about sPHENIX sum keys: callers
+ *  map their keys onto sum IDs via GetSumID(), which is how
+ *  TriggerClusterMaker feeds the cluster engine. The table
+ *  is never modified after Build(), so lookups are safe to
+ *  do concurrently.
+ */
+class TriggerClusterSumTable {
+
+  public:
+
+    // ------------------------------------------------------------------------
+    //! Span of towers associated with a sum
+    // ------------------------------------------------------------------------
+    struct Span {
+      uint32_t cal   = 0;  // calorimeter layer (TriggerClusterMakerDefs::Cal)
+      uint32_t start = 0;  // index of first tower in flat arrays
+      uint32_t size  = 0;  // no. of towers in sum
+    };
+
+    // ctor/dtor
+    TriggerClusterSumTable()  {};
+    ~TriggerClusterSumTable() {};
+
+    // public methods
+    void        Build();
+    uint32_t    GetSumID(const uint32_t cal, const uint32_t type, const uint32_t iSumEta, const uint32_t iSumPhi) const;
+    const Span* GetSpan(const uint32_t sumID) const {return (sumID < m_spans.size()) ? &m_spans[sumID] : NULL;}
+
+    // getters
+    const uint32_t* GetTowerIndices() const {return m_towerIndices.data();}
+    std::size_t     GetNSpans()       const {return m_spans.size();}
+    uint32_t        GetOffset(const uint32_t cal, const uint32_t type) const {return m_offsets[type][cal];}
+    std::size_t     GetNTowers()      const {return m_towerIndices.size();}
+
+  private:
+
+    // private templates
+    template <uint32_t C, uint32_t T> void AddSpans();
+
+    // offset of each layer/type block in span array
+    std::array<std::array<uint32_t, 3>, 2> m_offsets;
+
+    // spans and flattened tower grid indices
+    std::vector<Span>     m_spans;
+    std::vector<uint32_t> m_towerIndices;
+
+};
+
+#endif
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,112 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterTowerGrid.h'
+ *  \authors Derek Anderson
+ *  \date    06.14.2024
+ *
+ *  Dense (eta, phi) snapshot of a calorimeter
+ *  layer's towers for the TriggerClusterMaker
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERTOWERGRID_H
+#define TRIGGERCLUSTERTOWERGRID_H
+
+// c++ utilities
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+
+
+// ----------------------------------------------------------------------------
+//! Cache-line aligned allocator for tower arrays
+// ----------------------------------------------------------------------------
+template <typename T> struct TriggerClusterAlignedAllocator {
+
+  typedef T value_type;
+
+  // alignment of allocated arrays (one cache line)
+  static constexpr std::size_t Alignment = 64;
+
+  // ctors
+  TriggerClusterAlignedAllocator() noexcept {};
+  template <typename U> TriggerClusterAlignedAllocator(const TriggerClusterAlignedAllocator<U>&) noexcept {};
+
+  // allocate/deallocate
+  T* allocate(const std::size_t n) {
+    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+  }
+  void deallocate(T* ptr, const std::size_t) noexcept {
+    ::operator delete(ptr, std::align_val_t(Alignment));
+  }
+
+  // all instances are interchangeable
+  template <typename U> bool operator==(const TriggerClusterAlignedAllocator<U>&) const noexcept {return true;}
+  template <typename U> bool operator!=(const TriggerClusterAlignedAllocator<U>&) const noexcept {return false;}
+
+};
+
+// convenience types
+typedef std::vector<float, TriggerClusterAlignedAllocator<float>>     TriggerClusterFloatArray;
+typedef std::vector<uint8_t, TriggerClusterAlignedAllocator<uint8_t>> TriggerClusterByteArray;
+
+
+
+// ----------------------------------------------------------------------------
+//! Structure-of-arrays snapshot of a calorimeter layer
+// ----------------------------------------------------------------------------
+/*! Tower energies and statuses are stored in contiguous,
+ *  cache-aligned arrays laid out in (eta, phi) order, i.e.
+ *  index = (eta * nPhi) + phi, so that downstream cluster
+ *  building reads memory sequentially instead of calling
+ *  into the tower containers.
+ */
+struct TriggerClusterTowerGrid {
+
+  // dimensions
+  uint32_t nEta = 0;
+  uint32_t nPhi = 0;
+
+  // tower info
+  TriggerClusterFloatArray energy;
+  TriggerClusterByteArray  status;
+
+  // --------------------------------------------------------------------------
+  //! Set dimensions and zero arrays
+  // --------------------------------------------------------------------------
+  void Resize(const uint32_t eta, const uint32_t phi) {
+    nEta = eta;
+    nPhi = phi;
+    energy.assign(Size(), 0.);
+    status.assign(Size(), 0);
+  }
+
+  // --------------------------------------------------------------------------
+  //! Zero arrays without reallocating
+  // --------------------------------------------------------------------------
+  void Reset() {
+    std::fill(energy.begin(), energy.end(), 0.);
+    std::fill(status.begin(), status.end(), 0);
+  }
+
+  // --------------------------------------------------------------------------
+  //! Get no. of towers in grid
+  // --------------------------------------------------------------------------
+  std::size_t Size() const {
+    return static_cast<std::size_t>(nEta) * nPhi;
+  }
+
+  // --------------------------------------------------------------------------
+  //! Get flat index of a tower
+  // --------------------------------------------------------------------------
+  uint32_t Index(const uint32_t eta, const uint32_t phi) const {
+    return (eta * nPhi) + phi;
+  }
+
+};
+
+#endif
+
+// end ------------------------------------------------------------------------
@@ -4,12 +4,32 @@
  *  \date    06.06.2024
  *
  *  A Fun4All module to dump trigger clusters
- *  into an NTuple
+ *  into a TTree
  */
 // ----------------------------------------------------------------------------
 
 #define TRIGGERCLUSTERTUPLEMAKER_CC
 
+// c++ utilities
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <utility>
+// root libraries
+#include <TFile.h>
+#include <TROOT.h>
+#include <TTree.h>
+// calo base
+#include <calobase/RawCluster.h>
+#include <calobase/RawClusterContainer.h>
+// f4a libraries
+#include <fun4all/Fun4AllReturnCodes.h>
+// phool libraries
+#include <phool/getClass.h>
+#include <phool/phool.h>
+#include <phool/PHCompositeNode.h>
+
 // module definition
 #include "TriggerClusterTupleMaker.h"
 
@@ -23,12 +43,10 @@
 TriggerClusterTupleMaker::TriggerClusterTupleMaker(const std::string &name) : SubsysReco(name) {
 
   // print debug message
-  if (m_config.debug && (Verbosity() > 0)) {
-    std::cout << "TriggerClusterTupleMaker::TriggerClusterTupleMaker(const std::string &name) Calling ctor" << std::endl;
-  }
+  TRGCLUST_LOG(1, "TriggerClusterTupleMaker::TriggerClusterTupleMaker(const std::string &name) Calling ctor");
 
-  // make sure vector is empty
-  m_vecOutVars.clear();
+  // make sure row is empty
+  m_row.Reset();
 
 }  // end ctor
 
@@ -40,11 +58,14 @@ TriggerClusterTupleMaker::TriggerClusterTupleMaker(const std::string &name) : Su
 TriggerClusterTupleMaker::~TriggerClusterTupleMaker() {
 
   // print debug message
-  if (m_config.debug && (Verbosity() > 0)) {
-    std::cout << "TriggerClusterTupleMaker::~TriggerClusterTupleMaker() Calling dtor" << std::endl;
-  }
+  TRGCLUST_LOG(1, "TriggerClusterTupleMaker::~TriggerClusterTupleMaker() Calling dtor");
 
-  /* nothing to do */
+  // make sure output thread is gone
+  //   - n.b. normally already joined in End()
+  if (m_writer.joinable()) {
+    m_stopWriter.store(true, std::memory_order_release);
+    m_writer.join();
+  }
 
 }  // end dtor
 
@@ -57,12 +78,16 @@ TriggerClusterTupleMaker::~TriggerClusterTupleMaker() {
 // ----------------------------------------------------------------------------
 int TriggerClusterTupleMaker::Init(PHCompositeNode* topNode) {
 
-  if (m_config.debug) {
-    std::cout << "TriggerClusterTupleMaker::Init(PHCompositeNode *topNode) Initializing" << std::endl;
-  }
+  TRGCLUST_LOG(0, "TriggerClusterTupleMaker::Init(PHCompositeNode *topNode) Initializing");
 
   // initialize output
-  InitOutput(topNode);
+  InitOutput();
+
+  // and launch output thread if needed
+  if (m_config.asyncWrite) {
+    StartWriter();
+  }
+  m_log.Flush();
   return Fun4AllReturnCodes::EVENT_OK;
 
 }  // end 'Init(PHCompositeNode*)'
@@ -70,20 +95,33 @@ int TriggerClusterTupleMaker::Init(PHCompositeNode* topNode) {
 
 
 // ----------------------------------------------------------------------------
-//! Grab inputs and build trigger clusters
+//! Grab trigger clusters and fill tree
 // ----------------------------------------------------------------------------
 int TriggerClusterTupleMaker::process_event(PHCompositeNode* topNode) {
 
-  if (m_config.debug) {
-    std::cout << "TriggerClusterTupleMaker::process_event(PHCompositeNode *topNode) Processing Event" << std::endl;
-  }
-
-  // grab input nodes
-  GrabInputNodes(topNode);
-
-  /* TODO loop over trigger clusters here */
+  TRGCLUST_LOG(0, "TriggerClusterTupleMaker::process_event(PHCompositeNode *topNode) Processing Event");
+
+  // grab input node
+  GrabInputNode(topNode);
+
+  // loop over trigger clusters
+  RawClusterContainer::ConstRange clusters = m_inTrgClusts -> getClusters();
+  for (
+    RawClusterContainer::ConstIterator itClust = clusters.first;
+    itClust != clusters.second;
+    ++itClust
+  ) {
+    if (m_config.asyncWrite) {
+      AppendRow((*itClust).first, (*itClust).second);
+    } else {
+      SetVariables((*itClust).first, (*itClust).second, m_row);
+      m_outTree -> Fill();
+    }
+  }  // end cluster loop
 
-  // end event
+  // flush debug messages and end event
+  ++m_nEvents;
+  m_log.Flush();
   return Fun4AllReturnCodes::EVENT_OK;
 
 }  // end 'process_event(PHCompositeNode*)'
@@ -95,12 +133,11 @@ int TriggerClusterTupleMaker::process_event(PHCompositeNode* topNode) {
 // ----------------------------------------------------------------------------
 int TriggerClusterTupleMaker::End(PHCompositeNode *topNode) {
 
-  if (m_config.debug) {
-    std::cout << "TriggerClusterTupleMaker::End(PHCompositeNode *topNode) This is the End..." << std::endl;
-  }
+  TRGCLUST_LOG(0, "TriggerClusterTupleMaker::End(PHCompositeNode *topNode) This is the End...");
 
   // save and exit
   SaveOutput();
+  m_log.Flush();
   return Fun4AllReturnCodes::EVENT_OK;
 
 }  // end 'End(PHCompositeNode*)'
@@ -110,46 +147,52 @@ int TriggerClusterTupleMaker::End(PHCompositeNode *topNode) {
 // private methods ============================================================
 
 // ----------------------------------------------------------------------------
-//! Create output file and ntuple
+//! Create output file and tree
 // ----------------------------------------------------------------------------
+/*! Compression is set on the file before the tree is made
+ *  so that every basket is written with the configured
+ *  codec.
+ */
 void TriggerClusterTupleMaker::InitOutput() {
 
   // print debug message
-  if (m_config.debug && (Verbosity() > 0)) {
-    std::cout << "TriggerClusterTupleMaker::InitOutput(PHCompositeNode*) Creating output" << std::endl;
-  }
+  TRGCLUST_LOG(1, "TriggerClusterTupleMaker::InitOutput() Creating output");
 
   // open output file
   m_outFile = new TFile(m_config.outFile.data(), "recreate");
-  if (!m_outFile) {
+  if (!m_outFile || m_outFile -> IsZombie()) {
     std::cerr << PHWHERE << ": PANIC! Couldn't open output file!" << std::endl;
-    assert(m_outFile);
+    assert(m_outFile && !m_outFile -> IsZombie());
   }
-
-  // make list of variables
-  const std::vector<std::string> vecLeaves = {
-    "ntowers",
-    "energy",
-    "ecore",
-    "phi",
-    "rx",
-    "ry",
-    "rz",
-    "z",
-    "r"
-  };
-
-  // flatten list
-  std::string argLeaves("");
-  for (size_t iLeaf = 0; iLeaf < vecLeaves.size(); ++iLeaf) {
-    argLeaves.append(vecLeaves[iLeaf]);
-    if ((iLeaf + 1) != vecLeaves.size()) {
-      argLeaves.append(":");
-    }
+  m_outFile -> SetCompressionSettings(
+    ROOT::CompressionSettings(m_config.compressAlgo, m_config.compressLevel)
+  );
+
+  // create tree
+  m_outFile -> cd();
+  m_outTree = new TTree(m_config.outTuple.data(), "Trigger Clusters");
+  m_outTree -> SetAutoFlush(m_config.autoFlush);
+  m_outTree -> SetAutoSave(m_config.autoSave);
+
+  // create typed branches
+  const int32_t basket = m_config.basketSize;
+  m_outTree -> Branch("event",   &m_row.event,   "event/l",   basket);
+  m_outTree -> Branch("cluster", &m_row.cluster, "cluster/i", basket);
+  m_outTree -> Branch("ntowers", &m_row.ntowers, "ntowers/i", basket);
+  m_outTree -> Branch("energy",  &m_row.energy,  "energy/F",  basket);
+  m_outTree -> Branch("ecore",   &m_row.ecore,   "ecore/F",   basket);
+  m_outTree -> Branch("phi",     &m_row.phi,     "phi/F",     basket);
+  m_outTree -> Branch("rx",      &m_row.rx,      "rx/F",      basket);
+  m_outTree -> Branch("ry",      &m_row.ry,      "ry/F",      basket);
+  m_outTree -> Branch("rz",      &m_row.rz,      "rz/F",      basket);
+  m_outTree -> Branch("z",       &m_row.z,       "z/F",       basket);
+  m_outTree -> Branch("r",       &m_row.r,       "r/F",       basket);
+
+  // and variable-length constituent branches
+  if (m_config.saveConstituents) {
+    m_outTree -> Branch("towkey",    &m_row.towkey,    basket);
+    m_outTree -> Branch("towenergy", &m_row.towenergy, basket);
   }
-
-  // create tuple
-  m_outTuple = new TNtuple(m_config.outTuple.data(), "Trigger Clusters", argLeaves.data());
   return;
 
 }  // end 'InitOutput()'
@@ -157,50 +200,232 @@ void TriggerClusterTupleMaker::InitOutput() {
 
 
 // ----------------------------------------------------------------------------
-//! Grab input nodes
+//! Grab input node
 // ----------------------------------------------------------------------------
-void TriggerClusterTupleMaker::GrabInputNodes(PHCompositeNode* topNode) {
+void TriggerClusterTupleMaker::GrabInputNode(PHCompositeNode* topNode) {
 
   // print debug message
-  if (m_config.debug && (Verbosity() > 0)) {
-    std::cout << "TriggerClusterTupleMaker::GrabTowerNodes(PHCompositeNode*) Grabbing input tower nodes" << std::endl;
-  }
+  TRGCLUST_LOG(2, "TriggerClusterTupleMaker::GrabInputNode(PHCompositeNode*) Grabbing input cluster node");
 
-  // get emcal tower info node
+  // get trigger cluster node
   m_inTrgClusts = findNode::getClass<RawClusterContainer>(topNode, m_config.inNode);
   if (!m_inTrgClusts) {
     std::cerr << PHWHERE << ": PANIC! Couldn't grab node '" << m_config.inNode << "'!" << std::endl;
-    assert(m_inTrgClusts); 
+    assert(m_inTrgClusts);
   }
   return;
 
-}  // end 'GrabInputNodes(PHCompositeNode*)'
+}  // end 'GrabInputNode(PHCompositeNode*)'
 
 
 
 // ----------------------------------------------------------------------------
-//! Set variables
+//! Set output variables from a cluster
 // ----------------------------------------------------------------------------
-void TriggerClusterTupleMaker::SetClusterVariables(RawClusterv1* cluster) {
+void TriggerClusterTupleMaker::SetVariables(const uint32_t id, RawCluster* cluster, TriggerClusterTupleRow& row) {
 
   // print debug message
-  if (m_config.debug && (Verbosity() > 0)) {
-    std::cout << "TriggerClusterTupleMaker::GrabTowerNodes(PHCompositeNode*) Grabbing input tower nodes" << std::endl;
+  TRGCLUST_LOG(3, "TriggerClusterTupleMaker::SetVariables(uint32_t, RawCluster*, TriggerClusterTupleRow&) Setting variables for cluster " << id);
+
+  // set cluster properties
+  row.Reset();
+  row.event   = m_nEvents;
+  row.cluster = id;
+  row.ntowers = cluster -> getNTowers();
+  row.energy  = cluster -> get_energy();
+  row.ecore   = cluster -> get_ecore();
+  row.phi     = cluster -> get_phi();
+  row.rx      = cluster -> get_x();
+  row.ry      = cluster -> get_y();
+  row.rz      = cluster -> get_z();
+  row.z       = cluster -> get_z();
+  row.r       = cluster -> get_r();
+
+  // and constituents, if needed
+  if (m_config.saveConstituents) {
+    RawCluster::TowerConstRange towers = cluster -> get_towers();
+    for (
+      RawCluster::TowerConstIterator itTower = towers.first;
+      itTower != towers.second;
+      ++itTower
+    ) {
+      row.towkey.push_back( (*itTower).first );
+      row.towenergy.push_back( (*itTower).second );
+    }
   }
+  return;
 
-  // get emcal tower info node
-  m_inTrgClusts = findNode::getClass<RawClusterContainer>(topNode, m_config.inNode);
-  if (!m_inTrgClusts) {
-    std::cerr << PHWHERE << ": PANIC! Couldn't grab node '" << m_config.inNode << "'!" << std::endl;
-    assert(m_inTrgClusts); 
+}  // end 'SetVariables(uint32_t, RawCluster*, TriggerClusterTupleRow&)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Write tree and close output file
+// ----------------------------------------------------------------------------
+void TriggerClusterTupleMaker::SaveOutput() {
+
+  // print debug message
+  TRGCLUST_LOG(1, "TriggerClusterTupleMaker::SaveOutput() Saving output");
+
+  // flush and join output thread first
+  if (m_config.asyncWrite) {
+    StopWriter();
   }
+
+  m_outFile -> cd();
+  m_outTree -> Write("", TObject::kOverwrite);
+  m_outFile -> Close();
   return;
 
-}  // end 'GrabInputNodes(PHCompositeNode*)'
+}  // end 'SaveOutput()'
+
 
 
+// ----------------------------------------------------------------------------
+//! Allocate buffers and launch output thread
+// ----------------------------------------------------------------------------
+/*! The output thread owns the tree from here until it's
+ *  joined in StopWriter(), so ROOT's thread safety has to be
+ *  switched on.
+ */
+void TriggerClusterTupleMaker::StartWriter() {
+
+  // print debug message
+  TRGCLUST_LOG(1, "TriggerClusterTupleMaker::StartWriter() Launching output thread");
+
+  ROOT::EnableThreadSafety();
+
+  // allocate buffers
+  //   - n.b. need at least two for the threads to overlap
+  const uint32_t nBuffers = std::max(m_config.nBuffers, 2U);
+  const uint32_t nRows    = std::max(m_config.nRowsPerBuffer, 1U);
+  m_buffers.resize(nBuffers);
+  for (TriggerClusterTupleBuffer& buffer : m_buffers) {
+    buffer.rows.resize(nRows);
+    buffer.nRows = 0;
+  }
+
+  // first buffer is filled, rest start out free
+  //   - n.b. either queue can hold every buffer, so
+  //     pushes never fail
+  m_fullQueue.Resize(nBuffers);
+  m_freeQueue.Resize(nBuffers);
+  m_fillBuffer = &m_buffers[0];
+  for (uint32_t iBuffer = 1; iBuffer < nBuffers; ++iBuffer) {
+    m_freeQueue.Push(&m_buffers[iBuffer]);
+  }
+
+  // launch thread
+  m_stopWriter.store(false, std::memory_order_release);
+  m_writer = std::thread(&TriggerClusterTupleMaker::RunWriter, this);
+  return;
+
+}  // end 'StartWriter()'
 
 
 
+// ----------------------------------------------------------------------------
+//! Flush last buffer and join output thread
+// ----------------------------------------------------------------------------
+void TriggerClusterTupleMaker::StopWriter() {
+
+  // print debug message
+  TRGCLUST_LOG(1, "TriggerClusterTupleMaker::StopWriter() Joining output thread");
+
+  if (!m_writer.joinable()) return;
+
+  // hand off partially-filled buffer, then signal and join
+  if (m_fillBuffer -> nRows > 0) {
+    m_fullQueue.Push(m_fillBuffer);
+    m_fillBuffer = NULL;
+  }
+  m_stopWriter.store(true, std::memory_order_release);
+  m_writer.join();
+
+  // report any dropped rows
+  if (m_nDropped > 0) {
+    std::cerr << PHWHERE << ": WARNING! Dropped " << m_nDropped << " rows due to backpressure." << std::endl;
+  }
+  return;
+
+}  // end 'StopWriter()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Output thread: fill tree from full buffers
+// ----------------------------------------------------------------------------
+/*! Rows are swapped (not copied) into the row bound to the
+ *  tree, so constituent vectors change hands without being
+ *  reallocated. Exits once stopped and fully drained.
+ */
+void TriggerClusterTupleMaker::RunWriter() {
+
+  while (true) {
+
+    // write next full buffer and hand it back
+    TriggerClusterTupleBuffer* buffer = NULL;
+    if (m_fullQueue.Pop(buffer)) {
+      for (std::size_t iRow = 0; iRow < buffer -> nRows; ++iRow) {
+        std::swap(m_row, buffer -> rows[iRow]);
+        m_outTree -> Fill();
+      }
+      buffer -> nRows = 0;
+      m_freeQueue.Push(buffer);
+      continue;
+    }
+
+    // otherwise stop if signalled and drained, or wait
+    if (m_stopWriter.load(std::memory_order_acquire) && m_fullQueue.Empty()) break;
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  return;
+
+}  // end 'RunWriter()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Copy a cluster into the buffer being filled
+// ----------------------------------------------------------------------------
+void TriggerClusterTupleMaker::AppendRow(const uint32_t id, RawCluster* cluster) {
+
+  // hand off buffer if full
+  if (m_fillBuffer -> nRows == m_fillBuffer -> rows.size()) {
+    SwapFillBuffer();
+  }
+
+  SetVariables(id, cluster, m_fillBuffer -> rows[m_fillBuffer -> nRows]);
+  ++(m_fillBuffer -> nRows);
+  return;
+
+}  // end 'AppendRow(uint32_t, RawCluster*)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Hand full buffer to output thread and grab a free one
+// ----------------------------------------------------------------------------
+/*! If no buffer is free, either wait for the output thread
+ *  or drop the full buffer's rows, depending on the
+ *  configured backpressure.
+ */
+void TriggerClusterTupleMaker::SwapFillBuffer() {
+
+  TriggerClusterTupleBuffer* next = NULL;
+  while (!m_freeQueue.Pop(next)) {
+    if (m_config.backpressure == TriggerClusterMakerDefs::Backpressure::Drop) {
+      m_nDropped += m_fillBuffer -> nRows;
+      m_fillBuffer -> nRows = 0;
+      return;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+
+  m_fullQueue.Push(m_fillBuffer);
+  m_fillBuffer = next;
+  return;
+
+}  // end 'SwapFillBuffer()'
 
 // end ------------------------------------------------------------------------
@@ -4,7 +4,7 @@
  *  \date    06.06.2024
  *
  *  A Fun4All module to dump trigger clusters
- *  into an NTuple
+ *  into a TTree
  */
 // ----------------------------------------------------------------------------
 
@@ -12,16 +12,26 @@
 #define TRIGGERCLUSTERTUPLEMAKER_H
 
 // c++ utilities
+#include <atomic>
+#include <cstdint>
 #include <string>
+#include <thread>
 #include <vector>
-#include <cassert>
 // root libraries
-#include <TFile.h>
-#include <TNtuple.h>
-// base calo libraries
-#include <calobase/RawCluster.h>
-#include <calobase/RawClusterv1.h>
-#include <calobase/RawClusterContainer.h>
+#include <Compression.h>
+// f4a libraries
+#include <fun4all/SubsysReco.h>
+// module utilities
+#include "TriggerClusterLog.h"
+#include "TriggerClusterMakerDefs.h"
+#include "TriggerClusterSPSCQueue.h"
+
+// forward declarations
+class PHCompositeNode;
+class RawCluster;
+class RawClusterContainer;
+class TFile;
+class TTree;
 
 
 
@@ -30,13 +40,40 @@
 // ----------------------------------------------------------------------------
 struct TriggerClusterTupleMakerConfig {
 
-  // general options 
-  bool debug = true;
+  // general options
+  //   - debug messages are written if debug is set, up to
+  //     the module's Verbosity() (see TriggerClusterLog.h)
+  bool debug = false;
 
   // output options
   std::string outFile  = "test.tuple.root";
   std::string outTuple = "TrgClustTuple";
 
+  // tree layout options
+  //   - autoFlush/autoSave follow TTree conventions: > 0 is
+  //     a no. of entries, < 0 is a no. of bytes
+  int32_t basketSize = 32000;
+  int64_t autoFlush  = -30000000;
+  int64_t autoSave   = -300000000;
+
+  // compression options
+  ROOT::RCompressionSetting::EAlgorithm::EValues compressAlgo  = ROOT::RCompressionSetting::EAlgorithm::kLZ4;
+  int32_t                                        compressLevel = 4;
+
+  // whether or not to store tower keys and energies
+  bool saveConstituents = true;
+
+  // asynchronous output options
+  //   - if asyncWrite is set, rows are buffered on the event
+  //     thread and written by a dedicated output thread
+  //   - backpressure sets what happens when every buffer is
+  //     waiting to be written: Block waits for the output
+  //     thread, Drop discards the buffer being filled
+  bool     asyncWrite     = false;
+  uint32_t nRowsPerBuffer = 4096;
+  uint32_t nBuffers       = 2;
+  uint32_t backpressure   = TriggerClusterMakerDefs::Backpressure::Block;
+
   // input options
   std::string inNode = "TriggerClusters";
 
@@ -45,11 +82,78 @@ struct TriggerClusterTupleMakerConfig {
 
 
 // ----------------------------------------------------------------------------
-//! Creates an NTuple of Trigger Clusters
+//! One row (i.e. one cluster) of the output tree
+// ----------------------------------------------------------------------------
+struct TriggerClusterTupleRow {
+
+  // event and cluster indices
+  uint64_t event   = 0;
+  uint32_t cluster = 0;
+
+  // cluster properties
+  uint32_t ntowers = 0;
+  float    energy  = 0.;
+  float    ecore   = 0.;
+  float    phi     = 0.;
+  float    rx      = 0.;
+  float    ry      = 0.;
+  float    rz      = 0.;
+  float    z       = 0.;
+  float    r       = 0.;
+
+  // constituents
+  std::vector<uint32_t> towkey;
+  std::vector<float>    towenergy;
+
+  void Reset() {
+    event     = 0;
+    cluster   = 0;
+    ntowers   = 0;
+    energy    = 0.;
+    ecore     = 0.;
+    phi       = 0.;
+    rx        = 0.;
+    ry        = 0.;
+    rz        = 0.;
+    z         = 0.;
+    r         = 0.;
+    towkey.clear();
+    towenergy.clear();
+  }
+
+};
+
+
+
+// ----------------------------------------------------------------------------
+//! A buffer of rows handed between the event and output threads
+// ----------------------------------------------------------------------------
+/*! Rows are reused across fills so that their constituent
+ *  vectors keep their capacity.
+ */
+struct TriggerClusterTupleBuffer {
+  std::vector<TriggerClusterTupleRow> rows;
+  std::size_t                         nRows = 0;
+};
+
+
+
+// ----------------------------------------------------------------------------
+//! Creates a TTree of Trigger Clusters
 // ----------------------------------------------------------------------------
 /*! This Fun4all modules ingests trigger clusters and
- *  dumps select information from them into ROOT
- *  NTuples.
+ *  dumps select information from them into a ROOT TTree,
+ *  one entry per cluster. Every quantity gets its own typed
+ *  branch, and the towers of each cluster are stored in
+ *  variable-length vector branches.
+ *
+ *  In asynchronous mode, process_event only copies clusters
+ *  into a buffer of rows. Full buffers are passed to an
+ *  output thread through a lock-free queue, and that thread
+ *  alone fills the tree (and so does all compression and
+ *  file writes). Empty buffers come back through a second
+ *  queue. End joins the thread after flushing the last
+ *  partially-filled buffer.
  */
 class TriggerClusterTupleMaker : public SubsysReco {
 
@@ -57,7 +161,7 @@ class TriggerClusterTupleMaker : public SubsysReco {
 
     // ctor
     TriggerClusterTupleMaker(const std::string& name = "TriggerClusterTupleMaker");
-    ~TriggerClusterMaker() override;
+    ~TriggerClusterTupleMaker() override;
 
     // setters
     void SetConfig(const TriggerClusterTupleMakerConfig& config) {m_config = config;}
@@ -75,22 +179,43 @@ class TriggerClusterTupleMaker : public SubsysReco {
     // private methods
     void InitOutput();
     void GrabInputNode(PHCompositeNode* topNode);
-    void SetVariables(RawClusterv1* cluster);
+    void SetVariables(const uint32_t id, RawCluster* cluster, TriggerClusterTupleRow& row);
     void SaveOutput();
-    void ResetVariables();
-
-    // output variables
-    std::vector<float> m_vecOutVars;
+    void StartWriter();
+    void StopWriter();
+    void RunWriter();
+    void AppendRow(const uint32_t id, RawCluster* cluster);
+    void SwapFillBuffer();
+
+    // output row
+    TriggerClusterTupleRow m_row;
+
+    // asynchronous output
+    //   - buffers are cycled from the event thread to the output
+    //     thread via the full queue and back via the free queue
+    std::vector<TriggerClusterTupleBuffer>              m_buffers;
+    TriggerClusterTupleBuffer*                          m_fillBuffer = NULL;
+    TriggerClusterSPSCQueue<TriggerClusterTupleBuffer*> m_fullQueue;
+    TriggerClusterSPSCQueue<TriggerClusterTupleBuffer*> m_freeQueue;
+    std::thread                                         m_writer;
+    std::atomic<bool>                                   m_stopWriter {false};
+    uint64_t                                            m_nDropped   = 0;
 
     // output members
-    TFile*   m_outFile  = NULL;
-    TNtuple* m_outTuple = NULL; 
+    TFile* m_outFile = NULL;
+    TTree* m_outTree = NULL;
 
     // input node
     RawClusterContainer* m_inTrgClusts = NULL;
 
+    // buffered debug messages
+    TriggerClusterLogSink m_log;
+
+    // no. of events processed
+    uint64_t m_nEvents = 0;
+
     // module configuration
-    TriggerClusterMakerConfig m_config;
+    TriggerClusterTupleMakerConfig m_config;
 
 };
 
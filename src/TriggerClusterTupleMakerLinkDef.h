@@ -4,7 +4,7 @@
  *  \date    06.06.2024
  *
  *  A Fun4All module to dump trigger clusters
- *  into an NTuple
+ *  into a TTree
  */
 // ----------------------------------------------------------------------------
 
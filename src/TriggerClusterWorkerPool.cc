@@ -0,0 +1,136 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterWorkerPool.cc'
+ *  \authors Derek Anderson
+ *  \date    06.24.2024
+ *
+ *  Small fixed-size worker pool for the
+ *  TriggerClusterMaker module
+ */
+// ----------------------------------------------------------------------------
+
+#define TRIGGERCLUSTERWORKERPOOL_CC
+
+// class definition
+#include "TriggerClusterWorkerPool.h"
+
+
+
+// public methods =============================================================
+
+// ----------------------------------------------------------------------------
+//! Spawn workers
+// ----------------------------------------------------------------------------
+void TriggerClusterWorkerPool::Start(const uint32_t nWorkers) {
+
+  // make sure any previous workers are gone
+  Stop();
+
+  // n.b. new workers start from the current generation, so
+  //   that a restarted pool doesn't rerun an old job
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stop = false;
+  for (uint32_t iWorker = 1; iWorker < nWorkers; ++iWorker) {
+    m_threads.emplace_back(&TriggerClusterWorkerPool::Loop, this, iWorker, m_generation);
+  }
+  return;
+
+}  // end 'Start(uint32_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Join workers
+// ----------------------------------------------------------------------------
+void TriggerClusterWorkerPool::Stop() {
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_start.notify_all();
+
+  for (std::thread& thread : m_threads) {
+    thread.join();
+  }
+  m_threads.clear();
+  return;
+
+}  // end 'Stop()'
+
+
+
+// ----------------------------------------------------------------------------
+//! Run a task over items, blocking until all workers are done
+// ----------------------------------------------------------------------------
+void TriggerClusterWorkerPool::Run(const std::size_t nItems, const Task& task) {
+
+  // hand job to workers
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_task     = &task;
+    m_nItems   = nItems;
+    m_nPending = m_threads.size();
+    ++m_generation;
+  }
+  m_start.notify_all();
+
+  // do first block here
+  RunBlock(0);
+
+  // then wait for the rest
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done.wait(lock, [this]() {return m_nPending == 0;});
+  m_task = NULL;
+  return;
+
+}  // end 'Run(std::size_t, Task&)'
+
+
+
+// private methods ============================================================
+
+// ----------------------------------------------------------------------------
+//! Worker loop
+// ----------------------------------------------------------------------------
+void TriggerClusterWorkerPool::Loop(const uint32_t iWorker, const uint64_t generation) {
+
+  uint64_t lastGeneration = generation;
+  while (true) {
+
+    // wait for a new job (or to be stopped)
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_start.wait(lock, [this, lastGeneration]() {return m_stop || (m_generation != lastGeneration);});
+      if (m_stop) return;
+      lastGeneration = m_generation;
+    }
+
+    // do this worker's block and report back
+    RunBlock(iWorker);
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      --m_nPending;
+    }
+    m_done.notify_one();
+  }
+
+}  // end 'Loop(uint32_t, uint64_t)'
+
+
+
+// ----------------------------------------------------------------------------
+//! Run task over a worker's block of items
+// ----------------------------------------------------------------------------
+void TriggerClusterWorkerPool::RunBlock(const uint32_t iWorker) {
+
+  const std::size_t nWorkers = GetNWorkers();
+  const std::size_t begin    = (m_nItems * iWorker) / nWorkers;
+  const std::size_t end      = (m_nItems * (iWorker + 1)) / nWorkers;
+  if (begin < end) {
+    (*m_task)(begin, end, iWorker);
+  }
+  return;
+
+}  // end 'RunBlock(uint32_t)'
+
+// end ------------------------------------------------------------------------
@@ -0,0 +1,79 @@
+// ----------------------------------------------------------------------------
+/*! \file    TriggerClusterWorkerPool.h'
+ *  \authors Derek Anderson
+ *  \date    06.24.2024
+ *
+ *  Small fixed-size worker pool for the
+ *  TriggerClusterMaker module
+ */
+// ----------------------------------------------------------------------------
+
+#ifndef TRIGGERCLUSTERWORKERPOOL_H
+#define TRIGGERCLUSTERWORKERPOOL_H
+
+// c++ utilities
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+// ----------------------------------------------------------------------------
+//! Fixed-size pool of worker threads
+// ----------------------------------------------------------------------------
+/*! Runs a task over a range of items, split into one
+ *  contiguous block per worker. The calling thread works on
+ *  the first block, so a pool of N workers spawns N - 1
+ *  threads. Blocks depend only on the no. of items and
+ *  workers, so which worker handles an item never affects
+ *  where its output goes.
+ */
+class TriggerClusterWorkerPool {
+
+  public:
+
+    // task run on items [begin, end) by worker iWorker
+    typedef std::function<void(const std::size_t, const std::size_t, const uint32_t)> Task;
+
+    // ctor/dtor
+    TriggerClusterWorkerPool()  {};
+    ~TriggerClusterWorkerPool() {Stop();};
+
+    // public methods
+    void Start(const uint32_t nWorkers);
+    void Stop();
+    void Run(const std::size_t nItems, const Task& task);
+
+    // getters
+    uint32_t GetNWorkers() const {return m_threads.size() + 1;}
+
+  private:
+
+    // private methods
+    void Loop(const uint32_t iWorker, const uint64_t generation);
+    void RunBlock(const uint32_t iWorker);
+
+    // threads
+    std::vector<std::thread> m_threads;
+
+    // synchronization
+    std::mutex              m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    uint64_t                m_generation = 0;
+    uint32_t                m_nPending   = 0;
+    bool                    m_stop       = false;
+
+    // current job
+    const Task* m_task   = NULL;
+    std::size_t m_nItems = 0;
+
+};
+
+#endif
+
+// end ------------------------------------------------------------------------